@@ -1,5 +1,5 @@
 function(dfs_generate_df_types)
-	cmake_parse_arguments(ARG "" "TARGET;STRUCTURES;OUTPUT;NAMESPACE" "TYPES" ${ARGN})
+	cmake_parse_arguments(ARG "" "TARGET;STRUCTURES;OUTPUT;NAMESPACE;STATIC_LAYOUT" "TYPES" ${ARGN})
 	if(NOT DEFINED ARG_TARGET)
 		message(FATAL_ERROR "Missing TARGET")
 	endif()
@@ -12,12 +12,16 @@ function(dfs_generate_df_types)
 	if (DEFINED ARG_NAMESPACE)
 		set(USE_NAMESPACE --namespace ${ARG_NAMESPACE})
 	endif()
+	if (DEFINED ARG_STATIC_LAYOUT)
+		set(USE_STATIC_LAYOUT --static-layout ${ARG_STATIC_LAYOUT})
+	endif()
 	set(GENERATED_FILES ${ARG_OUTPUT}.h ${ARG_OUTPUT}.cpp)
 	add_custom_command(OUTPUT ${GENERATED_FILES}
 		COMMAND dfs::dfs-codegen ARGS
 			"${ARG_STRUCTURES}"
 			"${ARG_OUTPUT}"
 			${USE_NAMESPACE}
+			${USE_STATIC_LAYOUT}
 			${ARG_TYPES}
 		DEPENDS dfs::dfs-codegen)
 	target_sources(${ARG_TARGET} PRIVATE ${GENERATED_FILES})
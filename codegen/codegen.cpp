@@ -19,8 +19,11 @@
 #include <format>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <set>
 
+#include <dfs/ABI.h>
+#include <dfs/MemoryLayout.h>
 #include <dfs/Structures.h>
 using namespace dfs;
 
@@ -54,6 +57,35 @@ public:
 
 	virtual void writeInterface(std::ostream &) const = 0;
 	virtual void writeImplementation(std::ostream &, std::string_view use_namespace) const = 0;
+	/**
+	 * Writes declarations that must be outside of the `--namespace`
+	 * namespace (e.g. specializations of dfs templates).
+	 */
+	virtual void writeGlobalInterface(std::ostream &) const {}
+};
+
+/**
+ * Types generated in this run and their names, used for typing structure
+ * members.
+ */
+struct GeneratedTypes
+{
+	std::string use_namespace;
+	std::map<const AbstractType *, std::string> names;
+	std::vector<const Compound *> structures;	///< generated structures in declaration order
+	const Structures::VersionInfo *static_version = nullptr;	///< version from `--static-layout`
+	std::optional<MemoryLayout> static_layout;	///< layout of \ref static_version
+
+	const std::string *find(const AbstractType *type) const
+	{
+		auto it = names.find(type);
+		return it == names.end() ? nullptr : &it->second;
+	}
+
+	std::string qualified(const std::string &name) const
+	{
+		return use_namespace.empty() ? name : std::format("{}::{}", use_namespace, name);
+	}
 };
 
 class EnumGenerator: public CodeGenerator
@@ -93,12 +125,86 @@ public:
 
 	std::set<std::string> getInterfaceDependencies() const override
 	{
-		return { "string_view", "optional", "array" };
+		return { "string_view", "optional", "array", "algorithm", "utility", "dfs/EnumContainers.h" };
 	}
 
 	std::set<std::string> getImplementationDependencies() const override
 	{
-		return { "map" };
+		return {};
+	}
+
+	/**
+	 * Tables indexed by value are used when values are dense enough,
+	 * constexpr switches otherwise.
+	 */
+	bool useTables() const
+	{
+		if (sorted_values.empty())
+			return true;
+		auto range = std::size_t(sorted_values.back().first - sorted_values.front().first) + 1;
+		return range <= 2*sorted_values.size() + 64;
+	}
+
+	int firstValue() const
+	{
+		return sorted_values.empty() ? 0 : sorted_values.front().first;
+	}
+
+	std::size_t tableSize() const
+	{
+		return sorted_values.empty() ? 0 : std::size_t(sorted_values.back().first - firstValue()) + 1;
+	}
+
+	/**
+	 * Writes a constexpr function \p function_name returning \p type
+	 * for each value using \p value_string. Values without result return
+	 * \p default_value.
+	 */
+	template <typename F>
+	void writeLookup(std::ostream &out, std::string_view function_name, std::string_view type,
+			std::string_view default_value, F &&value_string) const
+	{
+		if (useTables()) {
+			out << std::format("namespace detail {{\n"
+					"inline constexpr std::array<{}, {}> {}_table = {{{{\n",
+					type, tableSize(), function_name);
+			int next = firstValue();
+			for (const auto &[value, it]: sorted_values) {
+				for (; next < value; ++next)
+					out << std::format("\t{},\n", default_value);
+				if (next > value) // duplicate value
+					continue;
+				auto str = value_string(*it);
+				out << std::format("\t{},\n", str ? *str : default_value);
+				++next;
+			}
+			out << std::format("}}}};\n"
+					"}} // namespace detail\n"
+					"constexpr {2} {1}({0} value) {{\n"
+					"\tauto index = static_cast<long long>(value) - {3};\n"
+					"\tif (index < 0 || index >= {4})\n"
+					"\t\treturn {5};\n"
+					"\treturn detail::{1}_table[index];\n"
+					"}}\n\n",
+					name, function_name, type, firstValue(), tableSize(), default_value);
+		}
+		else {
+			out << std::format("constexpr {2} {1}({0} value) {{\n"
+					"\tswitch (static_cast<long long>(value)) {{\n",
+					name, function_name, type);
+			int previous = firstValue() - 1;
+			for (const auto &[value, it]: sorted_values) {
+				if (value == previous) // duplicate value
+					continue;
+				previous = value;
+				if (auto str = value_string(*it))
+					out << std::format("\tcase {}: return {};\n", value, *str);
+			}
+			out << std::format("\tdefault: return {};\n"
+					"\t}}\n"
+					"}}\n\n",
+					default_value);
+		}
 	}
 
 	void writeInterface(std::ostream &out) const override
@@ -115,94 +221,77 @@ public:
 		// Enum value count
 		out << std::format("inline constexpr std::underlying_type_t<{}> Count = {};\n\n", name, def.count);
 
+		// Containers indexed by the enum
+		out << std::format("constexpr std::size_t dfs_enum_count({0}) noexcept {{ return Count; }}\n"
+				"template <typename T>\n"
+				"using Array = dfs::EnumArray<{0}, T>;\n"
+				"using Bitset = dfs::EnumBitset<{0}>;\n\n",
+				name);
+
 		out << std::format("constexpr std::array<{}, {}> AllValues = {{\n", name, def.values.size());
 		for (const auto &[name, value]: def.values)
 			if (!name.empty())
 				out << std::format("\t{},\n", name);
 		out << std::format("}};\n\n");
 
-		// Prototypes
-		out << std::format("std::optional<{}> from_string(std::string_view str);\n", name);
-		out << std::format("std::string_view to_string({} value);\n", name);
-		for (const auto &[attr_name, attr_def]: def.attributes) {
-			std::string attr_type = getAttributeTypeName(attr_def);
-			out << std::format("{2} {1}({0} value);\n", name, attr_name, attr_type);
-		}
-
-		out << std::format("\n}} // namespace {}\n", name);
-		out << std::format("using {0}_t = {0}::{0};\n\n", name);
-	}
-
-	void writeImplementation(std::ostream &out, std::string_view use_namespace) const override
-	{
-		if (use_namespace.empty())
-			out << std::format("namespace {} {{\n", name);
-		else
-			out << std::format("namespace {}::{} {{\n", use_namespace, name);
-
-		// from_string
-		out << std::format("std::optional<{0}> from_string(std::string_view str) {{\n"
-				"\tstatic const std::map<std::string_view, {0}> names = {{\n",
-				name);
+		// from_string: binary search in names sorted at generation
+		std::vector<std::string_view> names;
 		for (const auto &[name, item]: def.values)
 			if (!name.empty())
-				out << std::format("\t\t{{\"{0}\", {0}}},\n", name);
-		out << "\t};\n"
-			"\tauto it = names.find(str);\n"
-			"\tif (it != names.end())\n"
-			"\t\treturn it->second;\n"
-			"\telse\n"
-			"\t\treturn std::nullopt;\n"
-			"}\n\n";
+				names.push_back(name);
+		std::ranges::sort(names);
+		out << std::format("namespace detail {{\n"
+				"inline constexpr std::array<std::pair<std::string_view, {}>, {}> sorted_names = {{{{\n",
+				name, names.size());
+		for (auto value_name: names)
+			out << std::format("\t{{\"{0}\", {0}}},\n", value_name);
+		out << std::format("}}}};\n"
+				"}} // namespace detail\n"
+				"constexpr std::optional<{0}> from_string(std::string_view str) {{\n"
+				"\tauto it = std::ranges::lower_bound(detail::sorted_names, str, {{}},\n"
+				"\t\t\t&std::pair<std::string_view, {0}>::first);\n"
+				"\tif (it != detail::sorted_names.end() && it->first == str)\n"
+				"\t\treturn it->second;\n"
+				"\telse\n"
+				"\t\treturn std::nullopt;\n"
+				"}}\n\n",
+				name);
 
 		// to_string
-		out << std::format("std::string_view to_string({} value) {{\n"
-				"\tswitch (value) {{\n",
-				name);
-		for (const auto &[name, item]: def.values)
-			if (!name.empty())
-				out << std::format("\tcase {0}: return \"{0}\";\n", name);
-		out << "\tdefault: return {};\n"
-			"\t}\n"
-			"}\n\n";
+		writeLookup(out, "to_string", "std::string_view", "{}",
+				[](const auto &value) -> std::optional<std::string> {
+					if (value.first.empty())
+						return std::nullopt;
+					return std::format("\"{}\"", value.first);
+				});
 
 		// attributes
 		for (const auto &[attr_name, attr_def]: def.attributes) {
 			std::string attr_type = getAttributeTypeName(attr_def);
-
-			out << std::format(
-					"{2} {1}({0} value) {{\n"
-					"\tswitch (value) {{\n",
-					name, attr_name, attr_type);
 			auto attr_value_to_string = overloaded{
 				[](std::string str){return std::format("\"{}\"", str);},
 				[](bool value) -> std::string {return value ? "true" : "false";},
 				[](std::integral auto i){return std::to_string(i);},
 				[&](Enum::EnumValueIterator it) { return std::format("{}::{}", attr_type, it->first); }
 			};
-			for (const auto &value: sorted_values) {
-				const auto &[name, item] = *value.second;
-				auto attr_it = item.attributes.find(attr_name);
-				if (attr_it != item.attributes.end()) {
-					if (!name.empty())
-						out << std::format("\tcase {}: return {};\n",
-								name,
-								std::visit(attr_value_to_string, attr_it->second));
-					else
-						out << std::format("\tcase {}: return {};\n",
-								item.value,
-								std::visit(attr_value_to_string, attr_it->second));
-				}
-			}
-			if (attr_def.default_value)
-				out << std::format("\tdefault: return {};\n", std::visit(attr_value_to_string, attr_def.default_value.value()));
-			else
-				out << std::format("\tdefault: return {{}};\n");
-			out << "\t}\n"
-				"}\n\n";
+			std::string default_value = attr_def.default_value
+				? std::visit(attr_value_to_string, attr_def.default_value.value())
+				: std::string("{}");
+			writeLookup(out, attr_name, attr_type, default_value,
+					[&](const auto &value) -> std::optional<std::string> {
+						auto attr_it = value.second.attributes.find(attr_name);
+						if (attr_it == value.second.attributes.end())
+							return std::nullopt;
+						return std::visit(attr_value_to_string, attr_it->second);
+					});
 		}
 
-		out << std::format("\n}} // namespace {}\n", name);
+		out << std::format("}} // namespace {}\n", name);
+		out << std::format("using {0}_t = {0}::{0};\n\n", name);
+	}
+
+	void writeImplementation(std::ostream &, std::string_view use_namespace) const override
+	{
 	}
 };
 
@@ -219,7 +308,7 @@ public:
 
 	std::set<std::string> getInterfaceDependencies() const override
 	{
-		return { "cstdint" };
+		return { "concepts", "cstdint" };
 	}
 
 	std::set<std::string> getImplementationDependencies() const override
@@ -234,9 +323,9 @@ public:
 		out << std::format(
 				"\tusing underlying_type = {0};\n"
 				"\t{1}() noexcept = default;\n"
-				"\texplicit {1}({0} v) noexcept: value(v) {{}}\n"
+				"\tconstexpr explicit {1}({0} v) noexcept: value(v) {{}}\n"
 				"\t{1} &operator=({0} v) noexcept {{ value = v; return *this; }}\n"
-				"\texplicit operator {0}() const noexcept {{ return value; }}\n\n",
+				"\tconstexpr explicit operator {0}() const noexcept {{ return value; }}\n\n",
 				base_type, name);
 
 		out << std::format("\t{} value;\n", base_type);
@@ -258,7 +347,17 @@ public:
 		for (const auto &f: def.flags)
 			if (!f.name.empty())
 				out << std::format("\t\t{}_count = {},\n", f.name, f.count);
-		out << std::format("\t}};\n");
+		out << std::format("\t}};\n\n");
+		out << std::format(
+				"\ttemplate <std::same_as<bits_t>... Flags>\n"
+				"\tstatic constexpr {0} mask(Flags... flags) noexcept {{ return ({0}(0) | ... | {0}(flags)); }}\n"
+				"\ttemplate <std::same_as<bits_t>... Flags>\n"
+				"\tconstexpr bool any_of(Flags... flags) const noexcept {{ return (value & mask(flags...)) != 0; }}\n"
+				"\ttemplate <std::same_as<bits_t>... Flags>\n"
+				"\tconstexpr bool all_of(Flags... flags) const noexcept {{ return (value & mask(flags...)) == mask(flags...); }}\n"
+				"\ttemplate <std::same_as<bits_t>... Flags>\n"
+				"\tconstexpr bool none_of(Flags... flags) const noexcept {{ return (value & mask(flags...)) == 0; }}\n",
+				base_type);
 		out << std::format("}};\n\n");
 	}
 
@@ -267,14 +366,222 @@ public:
 	}
 };
 
+class StructureGenerator: public CodeGenerator
+{
+public:
+	struct field_t
+	{
+		std::string name;	///< local member name
+		std::string path;	///< path in the df-structures compound
+	};
+
+private:
+	std::string name;
+	std::string type_name;
+	const Compound &def;
+	std::vector<field_t> fields;
+	const GeneratedTypes &generated;
+
+	const Compound *generatedParent() const
+	{
+		for (auto parent = def.parent ? def.parent->get() : nullptr; parent;
+				parent = parent->parent ? parent->parent->get() : nullptr)
+			if (generated.find(parent))
+				return parent;
+		return nullptr;
+	}
+
+	std::string getTypeName(AnyTypeRef type) const
+	{
+		return type.visit(overloaded{
+			[this](const Enum &e) -> std::string {
+				if (auto name = generated.find(&e))
+					return *name;
+				return getIntegralTypeName(e);
+			},
+			[this](const Bitfield &b) -> std::string {
+				if (auto name = generated.find(&b))
+					return *name;
+				return getIntegralTypeName(b);
+			},
+			[](const PrimitiveType &p) -> std::string {
+				switch (p.type) {
+				case PrimitiveType::StdString:
+				case PrimitiveType::PtrString:
+					return "std::string";
+				default:
+					return getIntegralTypeName(p);
+				}
+			},
+			[this](const Compound &c) -> std::string {
+				if (auto name = generated.find(&c))
+					return *name;
+				throw std::runtime_error(std::format("compound {} must also be generated", c.debug_name));
+			},
+			[this](const PointerType &p) -> std::string {
+				if (p.type_params.size() == 1) {
+					AnyTypeRef item = p.itemType();
+					if (item.get_if<Compound>() || item.get_if<PrimitiveType>())
+						try {
+							return std::format("std::unique_ptr<{}>", getTypeName(item));
+						}
+						catch (std::exception &) {
+							// fallback to the address
+						}
+				}
+				return "uintptr_t";
+			},
+			[this](const StaticArray &a) -> std::string {
+				if (a.extent == StaticArray::NoExtent)
+					throw std::runtime_error("static array without extent");
+				if (a.index_enum && a.extent == std::size_t((*a.index_enum)->count))
+					if (auto index = generated.find(a.index_enum->get()))
+						return std::format("dfs::EnumArray<{}, {}>", *index, getTypeName(a.itemType()));
+				return std::format("std::array<{}, {}>", getTypeName(a.itemType()), a.extent);
+			},
+			[this](const StdContainer &c) -> std::string {
+				if (c.container_type == StdContainer::StdVector)
+					return std::format("std::vector<{}>", getTypeName(c.itemType()));
+				throw std::runtime_error(std::format("unsupported container {}", StdContainer::to_string(c.container_type)));
+			},
+			[this](const DFContainer &c) -> std::string {
+				switch (c.container_type) {
+				case DFContainer::DFFlagArray:
+					if (c.index_enum)
+						if (auto index = generated.find(c.index_enum->get()))
+							return std::format("dfs::EnumBitset<{}>", *index);
+					return "std::vector<bool>";
+				case DFContainer::DFArray:
+				case DFContainer::DFLinkedList:
+					return std::format("std::vector<{}>", getTypeName(c.itemType()));
+				default:
+					throw std::runtime_error("unsupported df container");
+				}
+			},
+			[](const AbstractType &) -> std::string {
+				throw std::runtime_error("unsupported type");
+			}
+		});
+	}
+
+public:
+	StructureGenerator(std::string name, std::string type_name, const Compound &compound,
+			std::vector<field_t> fields, const GeneratedTypes &generated):
+		name(std::move(name)),
+		type_name(std::move(type_name)),
+		def(compound),
+		fields(std::move(fields)),
+		generated(generated)
+	{
+	}
+
+	std::set<std::string> getInterfaceDependencies() const override
+	{
+		std::set<std::string> deps = { "cstdint", "array", "memory", "string", "vector", "dfs/CompoundReader.h", "dfs/EnumContainerReaders.h", "dfs/PolymorphicReader.h" };
+		if (generated.static_layout)
+			deps.insert("dfs/StaticLayoutReader.h");
+		return deps;
+	}
+
+	std::set<std::string> getImplementationDependencies() const override
+	{
+		return {};
+	}
+
+	void writeInterface(std::ostream &out) const override
+	{
+		auto parent = generatedParent();
+		if (parent)
+			out << std::format("struct {}: {}\n{{\n", name, *generated.find(parent));
+		else
+			out << std::format("struct {}\n{{\n", name);
+		if (def.vtable && !parent)
+			out << std::format("\tvirtual ~{}() = default;\n\n", name);
+		for (const auto &field: fields) {
+			try {
+				auto type = findChildType(AnyTypeRef(def), parse_path(field.path));
+				out << std::format("\t{} {};\n", getTypeName(type), field.name);
+			}
+			catch (std::exception &e) {
+				throw std::runtime_error(std::format("{}.{}: {}", type_name, field.path, e.what()));
+			}
+		}
+		if (generated.static_layout) {
+			// Constants for the --static-layout version, the reader
+			// checks them against the runtime layout.
+			out << std::format("\tstatic constexpr std::size_t static_size = {:#x};\n",
+					generated.static_layout->type_info.at(&def).size);
+			if (def.vtable) {
+				std::string_view symbol = def.symbol ? *def.symbol : std::string_view(type_name);
+				auto it = generated.static_version->vtables_addresses.find(symbol);
+				if (it != generated.static_version->vtables_addresses.end())
+					out << std::format("\tstatic constexpr uintptr_t static_vtable = {:#x};\n", it->second);
+			}
+			out << "\n";
+			out << std::format("\tusing reader_type = dfs::StaticLayoutStructureReader<{}, \"{}\", static_layout_version", name, type_name);
+			if (parent)
+				out << std::format(",\n\t\tdfs::Base<{}>", *generated.find(parent));
+			for (const auto &field: fields) {
+				auto offset = std::get<1>(generated.static_layout->getOffset(def, parse_path(field.path)));
+				out << std::format(",\n\t\tdfs::StaticField<&{}::{}, \"{}\", {:#x}>", name, field.name, field.path, offset);
+			}
+		}
+		else {
+			if (!fields.empty())
+				out << "\n";
+			out << std::format("\tusing reader_type = dfs::StructureReader<{}, \"{}\"", name, type_name);
+			if (parent)
+				out << std::format(",\n\t\tdfs::Base<{}>", *generated.find(parent));
+			for (const auto &field: fields)
+				out << std::format(",\n\t\tdfs::Field<&{}::{}, \"{}\">", name, field.name, field.path);
+		}
+		out << ">;\n};\n\n";
+	}
+
+	void writeImplementation(std::ostream &, std::string_view use_namespace) const override
+	{
+	}
+
+	void writeGlobalInterface(std::ostream &out) const override
+	{
+		// Polymorphic family: this structure is the root and every
+		// generated structure deriving from it is a possible type.
+		if (!def.vtable || generatedParent())
+			return;
+		std::vector<std::string> derived;
+		for (auto compound: generated.structures) {
+			for (auto parent = compound->parent ? compound->parent->get() : nullptr; parent;
+					parent = parent->parent ? parent->parent->get() : nullptr)
+				if (parent == &def) {
+					derived.push_back(generated.qualified(*generated.find(compound)));
+					break;
+				}
+		}
+		if (derived.empty())
+			return;
+		auto base = generated.qualified(name);
+		out << std::format("template <>\nstruct dfs::polymorphic_reader_type<{}> {{\n"
+				"\tusing type = dfs::PolymorphicReader<{}", base, base);
+		for (const auto &d: derived)
+			out << std::format(",\n\t\t{}", d);
+		out << ">;\n};\n\n";
+	}
+};
+
 namespace fs = std::filesystem;
 
 static inline constexpr char usage[] = R"***(
 {0} <df-structures-path> <output-prefix> [<general-options>...] <type> [<type-options> ...] ...
 General options:
   --namespace <name>  add namespace around type declarations
+  --static-layout <version>
+                      generate structure readers with constant offsets for
+                      this version (falling back to runtime offsets for
+                      other versions)
 Type options:
   --as <name>         use this name instead of df-structures name (mandatory for member types)
+  --fields <fields>   generate a structure with only these comma-separated
+                      fields from a compound (<path> or <name>=<path>)
 )***";
 
 int main(int argc, char *argv[]) try
@@ -288,7 +595,8 @@ int main(int argc, char *argv[]) try
 
 	Structures structures(df_structures_path);
 
-	std::string use_namespace;
+	GeneratedTypes generated;
+	std::string &use_namespace = generated.use_namespace;
 	int arg_index = 3;
 	// General options
 	while (arg_index < argc && argv[arg_index][0] == '-') {
@@ -301,6 +609,18 @@ int main(int argc, char *argv[]) try
 			use_namespace = argv[arg_index+1];
 			arg_index += 2;
 		}
+		else if ("--static-layout"s == argv[arg_index]) {
+			if (arg_index+1 >= argc) {
+				std::cerr << "missing version name" << std::endl;
+				return EXIT_FAILURE;
+			}
+			generated.static_version = structures.versionByName(argv[arg_index+1]);
+			if (!generated.static_version)
+				throw std::runtime_error(std::format("unknown version {}", argv[arg_index+1]));
+			generated.static_layout.emplace(structures,
+					ABI::fromVersionName(generated.static_version->version_name));
+			arg_index += 2;
+		}
 		else {
 			std::cerr << "unknown general option: " << argv[arg_index] << std::endl;
 			std::cerr << std::format(usage, argv[0]);
@@ -313,6 +633,7 @@ int main(int argc, char *argv[]) try
 		std::string name = argv[arg_index++];
 		auto path = parse_path(name);
 		std::string alias;
+		std::optional<std::vector<StructureGenerator::field_t>> fields;
 		// Type options
 		while (arg_index < argc && argv[arg_index][0] == '-') {
 			using namespace std::literals;
@@ -324,19 +645,59 @@ int main(int argc, char *argv[]) try
 				alias = argv[arg_index+1];
 				arg_index += 2;
 			}
+			else if ("--fields"s == argv[arg_index]) {
+				if (arg_index+1 >= argc) {
+					std::cerr << "missing field list" << std::endl;
+					return EXIT_FAILURE;
+				}
+				fields.emplace();
+				for (auto field: std::string_view(argv[arg_index+1]) | std::views::split(',')) {
+					std::string_view spec(field.begin(), field.end());
+					if (spec.empty())
+						continue;
+					if (auto eq = spec.find('='); eq != spec.npos)
+						fields->push_back({std::string(spec.substr(0, eq)), std::string(spec.substr(eq+1))});
+					else {
+						auto field_path = parse_path(spec);
+						auto id = get_if<path::identifier>(&field_path.back());
+						if (!id)
+							throw std::runtime_error(std::format("field {} requires a name", spec));
+						fields->push_back({std::string(id->identifier), std::string(spec)});
+					}
+				}
+				arg_index += 2;
+			}
 			else {
 				std::cerr << "unknown type option: " << argv[arg_index] << std::endl;
 				std::cerr << std::format(usage, argv[0]);
 				return EXIT_FAILURE;
 			}
 		}
-		if (path.size() == 1 && holds_alternative<path::identifier>(path[0])) {
+		if (fields) {
+			if (alias.empty()) {
+				if (path.size() > 1)
+					throw std::runtime_error("nested types require an alias");
+				alias = name;
+			}
+			auto compound = structures.findCompound(path);
+			if (!compound)
+				throw std::runtime_error("compound not found");
+			generated.names.emplace(compound, alias);
+			generated.structures.push_back(compound);
+			generators.push_back(std::make_unique<StructureGenerator>(
+					std::move(alias), name, *compound, std::move(*fields), generated));
+		}
+		else if (path.size() == 1 && holds_alternative<path::identifier>(path[0])) {
 			if (alias.empty())
 				alias = name;
-			if (auto type = structures.findEnum(name))
+			if (auto type = structures.findEnum(name)) {
+				generated.names.emplace(type, alias + "_t");
 				generators.push_back(std::make_unique<EnumGenerator>(std::move(alias), *type));
-			else if (auto type = structures.findBitfield(name))
+			}
+			else if (auto type = structures.findBitfield(name)) {
+				generated.names.emplace(type, alias);
 				generators.push_back(std::make_unique<BitfieldGenerator>(std::move(alias), *type));
+			}
 			else
 				throw std::runtime_error("type not found");
 		}
@@ -350,10 +711,12 @@ int main(int argc, char *argv[]) try
 				auto r = compound->searchMember(member_name->identifier);
 				const auto &member = r.back().first->members.at(r.back().second);
 				generators.push_back(member.type.visit(overloaded{
-					[&alias](const Enum &e) -> std::unique_ptr<CodeGenerator> {
+					[&alias, &generated](const Enum &e) -> std::unique_ptr<CodeGenerator> {
+						generated.names.emplace(&e, alias + "_t");
 						return std::make_unique<EnumGenerator>(std::move(alias), e);
 					},
-					[&alias](const Bitfield &bf) -> std::unique_ptr<CodeGenerator> {
+					[&alias, &generated](const Bitfield &bf) -> std::unique_ptr<CodeGenerator> {
+						generated.names.emplace(&bf, alias);
 						return std::make_unique<BitfieldGenerator>(std::move(alias), bf);
 					},
 					[](const AbstractType &) -> std::unique_ptr<CodeGenerator> {
@@ -378,15 +741,28 @@ int main(int argc, char *argv[]) try
 		std::set<std::string> deps;
 		for (const auto &g: generators)
 			deps.merge(g->getInterfaceDependencies());
+		if (generated.static_version)
+			deps.insert({"array", "cstdint", "string_view"});
 		for (const auto &d: deps)
 			header << std::format("#include <{}>\n", d);
 		header << "\n";
 		if (!use_namespace.empty())
 			header << std::format("namespace {} {{\n\n", use_namespace);
+		if (auto version = generated.static_version) {
+			header << std::format("struct static_layout_version\n{{\n"
+					"\tstatic constexpr std::string_view name = \"{}\";\n"
+					"\tstatic constexpr std::array<uint8_t, {}> id = {{",
+					version->version_name, version->id.size());
+			for (std::size_t i = 0; i < version->id.size(); ++i)
+				header << std::format("{}{:#04x}", i == 0 ? "" : ", ", version->id[i]);
+			header << "};\n};\n\n";
+		}
 		for (const auto &g: generators)
 			g->writeInterface(header);
 		if (!use_namespace.empty())
 			header << std::format("\n}} // namespace {}\n\n", use_namespace);
+		for (const auto &g: generators)
+			g->writeGlobalInterface(header);
 		header << "#endif\n";
 	}
 	else throw std::runtime_error("Failed to create header file");
@@ -27,8 +27,6 @@
 
 using namespace dfs;
 
-static constexpr std::size_t MaxStringCapacity = 1000000;
-
 class abi_error_category_t: public std::error_category
 {
 public:
@@ -139,31 +137,6 @@ uintptr_t ABI::read_pointer_common(const uint8_t *data)
 template uintptr_t ABI::read_pointer_common<ABI::Arch::X86>(const uint8_t *);
 template uintptr_t ABI::read_pointer_common<ABI::Arch::AMD64>(const uint8_t *);
 
-template <ABI::Arch arch>
-cppcoro::task<ABI::vector_info> ABI::read_vector_common(Process &process, MemoryView data, const TypeInfo &item_type_info)
-{
-	// struct vector {
-	//     T *begin;
-	//     T *end;
-	//     T *end_capacity;
-	// };
-	using Uintptr = uintptr<arch>::type;
-	std::array<Uintptr, 3> ptr;
-	std::memcpy(ptr.data(), data.data.data(), ptr.size() * sizeof(Uintptr));
-	if (std::all_of(ptr.begin(), ptr.end(), [](auto ptr){return ptr == 0;}))
-		co_return vector_info{};
-	if (std::any_of(ptr.begin(), ptr.end(), [align = item_type_info.align](auto ptr){return ptr%align != 0;}))
-		co_return vector_info{ABIError::UnalignedPointer};
-	if (ptr[1] < ptr[0] || (ptr[1]-ptr[0])%item_type_info.size != 0)
-		co_return vector_info{ABIError::InvalidLength};
-	if (ptr[2] < ptr[1] || (ptr[2]-ptr[0])%item_type_info.size != 0)
-		co_return vector_info{ABIError::InvalidCapacity};
-	co_return vector_info{{}, ptr[0], (ptr[1]-ptr[0])/item_type_info.size};
-}
-
-template cppcoro::task<ABI::vector_info> ABI::read_vector_common<ABI::Arch::X86>(Process &, MemoryView, const TypeInfo &);
-template cppcoro::task<ABI::vector_info> ABI::read_vector_common<ABI::Arch::AMD64>(Process &, MemoryView, const TypeInfo &);
-
 template <ABI::Arch arch>
 cppcoro::task<ABI::string_result> ABI::read_string_gcc_cow(Process &process, MemoryView data)
 {
@@ -186,7 +159,7 @@ cppcoro::task<ABI::string_result> ABI::read_string_gcc_cow(Process &process, Mem
 	} rep;
 	if (auto err = co_await process.read(addr-sizeof(rep), rep))
 		co_return string_result{err};
-	if (rep.capacity > MaxStringCapacity)
+	if (rep.capacity > max_string_capacity)
 		co_return string_result{ABIError::InvalidCapacity};
 	if (rep.length > rep.capacity)
 		co_return string_result{ABIError::InvalidCapacity};
@@ -202,34 +175,16 @@ template cppcoro::task<ABI::string_result> ABI::read_string_gcc_cow<ABI::Arch::A
 template <ABI::Arch arch>
 cppcoro::task<ABI::string_result> ABI::read_string_gcc_sso(Process &process, MemoryView data)
 {
-	// struct string {
-	//     char *data;
-	//     size_t length;
-	//     union {
-	//         char local_data[16];
-	//         size_t capacity;
-	//     };
-	// };
-	using Uintptr = uintptr<arch>::type;
-	std::error_code err;
-	auto buffer = get_integer<Uintptr>(data);
-	auto length = get_integer<Uintptr>(data.subview(sizeof(Uintptr)));
-	auto local_buffer = data.subview(2*sizeof(Uintptr), 16);
-	bool is_local = buffer == local_buffer.address;
-	auto capacity = is_local
-		? 15
-		: get_integer<Uintptr>(local_buffer);
-	if (capacity > MaxStringCapacity)
-		co_return string_result{ABIError::InvalidCapacity};
-	if (length > capacity)
-		co_return string_result{ABIError::InvalidCapacity};
+	auto info = decode_string_gcc_sso<arch>(data);
+	if (info.err)
+		co_return string_result{info.err};
 	string_result res;
-	if (!is_local) {
-		res.str.resize(length);
-		res.err = co_await process.read({buffer, {reinterpret_cast<uint8_t *>(res.str.data()), length}});
+	if (!is_local_string(info, data)) {
+		res.str.resize(info.size);
+		res.err = co_await process.read({info.data, {reinterpret_cast<uint8_t *>(res.str.data()), info.size}});
 	}
 	else
-		res.str.assign(reinterpret_cast<const char *>(local_buffer.data.data()), length);
+		res.str.assign(reinterpret_cast<const char *>(data.subview(info.data - data.address).data.data()), info.size);
 	co_return res;
 }
 
@@ -239,89 +194,126 @@ template cppcoro::task<ABI::string_result> ABI::read_string_gcc_sso<ABI::Arch::A
 template <ABI::Arch arch>
 cppcoro::task<ABI::string_result> ABI::read_string_msvc2015(Process &process, MemoryView data)
 {
-	// struct string {
-	//     union {
-	//         char local_data[16];
-	//         char *data;
-	//     };
-	//     size_t length;
-	//     size_t capacity;
-	// };
-	using Uintptr = uintptr<arch>::type;
-	auto length = get_integer<Uintptr>(data.subview(16));
-	auto capacity = get_integer<Uintptr>(data.subview(16+sizeof(Uintptr)));
-	if (capacity > MaxStringCapacity)
-		co_return string_result{ABIError::InvalidCapacity};
-	if (length > capacity)
-		co_return string_result{ABIError::InvalidCapacity};
+	auto info = decode_string_msvc2015<arch>(data);
+	if (info.err)
+		co_return string_result{info.err};
 	string_result res;
-	if (capacity > 15) {
-		res.str.resize(length);
-		res.err = co_await process.read({
-				get_integer<Uintptr>(data), {
-					reinterpret_cast<uint8_t *>(res.str.data()),
-					length
-				}});
+	if (!is_local_string(info, data)) {
+		res.str.resize(info.size);
+		res.err = co_await process.read({info.data, {reinterpret_cast<uint8_t *>(res.str.data()), info.size}});
 	}
 	else
-		res.str.assign(reinterpret_cast<const char *>(data.data.data()), length);
+		res.str.assign(reinterpret_cast<const char *>(data.data.data()), info.size);
 	co_return res;
 }
 
 template cppcoro::task<ABI::string_result> ABI::read_string_msvc2015<ABI::Arch::X86>(Process &, MemoryView);
 template cppcoro::task<ABI::string_result> ABI::read_string_msvc2015<ABI::Arch::AMD64>(Process &, MemoryView);
 
+template <ABI::Arch arch>
+cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_cow(Process &process, MemoryView data)
+{
+	// See read_string_gcc_cow
+	using Uintptr = uintptr<arch>::type;
+	auto addr = get_integer<Uintptr>(data);
+	struct {
+		Uintptr length;
+		Uintptr capacity;
+		Uintptr refcount;
+	} rep;
+	if (auto err = co_await process.read(addr-sizeof(rep), rep))
+		co_return string_info{err};
+	if (rep.capacity > max_string_capacity)
+		co_return string_info{ABIError::InvalidCapacity};
+	if (rep.length > rep.capacity)
+		co_return string_info{ABIError::InvalidCapacity};
+	co_return string_info{{}, addr, rep.length};
+}
+
+template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_cow<ABI::Arch::X86>(Process &, MemoryView);
+template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_cow<ABI::Arch::AMD64>(Process &, MemoryView);
+
+template <ABI::Arch arch>
+cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_sso(Process &, MemoryView data)
+{
+	co_return decode_string_gcc_sso<arch>(data);
+}
+
+template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_sso<ABI::Arch::X86>(Process &, MemoryView);
+template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_sso<ABI::Arch::AMD64>(Process &, MemoryView);
+
+template <ABI::Arch arch>
+cppcoro::task<ABI::string_info> ABI::read_string_info_msvc2015(Process &, MemoryView data)
+{
+	co_return decode_string_msvc2015<arch>(data);
+}
+
+template cppcoro::task<ABI::string_info> ABI::read_string_info_msvc2015<ABI::Arch::X86>(Process &, MemoryView);
+template cppcoro::task<ABI::string_info> ABI::read_string_info_msvc2015<ABI::Arch::AMD64>(Process &, MemoryView);
+
 template <ABI::Arch arch>
 static constexpr TypeInfo PointerInfo = {
 	ABI::pointer_size<arch>(),
 	ABI::pointer_size<arch>()
 };
 
-const ABI ABI::GCC_32 = ABI{ Arch::X86, Compiler::GNU,
+const ABI ABI::GCC_32 = ABI{ Arch::X86, Compiler::GNU, StdLib::GNUCOW,
 			make_primitive_type_info_gcc<Arch::X86, false>(),
 			PointerInfo<Arch::X86>,
 			make_container_type_info_gcc<Arch::X86, false>(),
 			container_info_common,
 			read_pointer_common<Arch::X86>,
-			read_vector_common<Arch::X86>,
-			read_string_gcc_cow<Arch::X86> };
-const ABI ABI::GCC_64 = ABI{ Arch::AMD64, Compiler::GNU,
+			decode_vector_common<Arch::X86>,
+			read_string_gcc_cow<Arch::X86>,
+			read_string_info_gcc_cow<Arch::X86>,
+			nullptr };
+const ABI ABI::GCC_64 = ABI{ Arch::AMD64, Compiler::GNU, StdLib::GNUCOW,
 			make_primitive_type_info_gcc<Arch::AMD64, false>(),
 			PointerInfo<Arch::AMD64>,
 			make_container_type_info_gcc<Arch::AMD64, false>(),
 			container_info_common,
 			read_pointer_common<Arch::AMD64>,
-			read_vector_common<Arch::AMD64>,
-			read_string_gcc_cow<Arch::AMD64> };
-const ABI ABI::GCC_CXX11_32 = ABI{ Arch::X86, Compiler::GNU,
+			decode_vector_common<Arch::AMD64>,
+			read_string_gcc_cow<Arch::AMD64>,
+			read_string_info_gcc_cow<Arch::AMD64>,
+			nullptr };
+const ABI ABI::GCC_CXX11_32 = ABI{ Arch::X86, Compiler::GNU, StdLib::GNUCXX11,
 			make_primitive_type_info_gcc<Arch::X86, true>(),
 			PointerInfo<Arch::X86>,
 			make_container_type_info_gcc<Arch::X86, true>(),
 			container_info_common,
 			read_pointer_common<Arch::X86>,
-			read_vector_common<Arch::X86>,
-			read_string_gcc_sso<Arch::X86> };
-const ABI ABI::GCC_CXX11_64 = ABI{ Arch::AMD64, Compiler::GNU,
+			decode_vector_common<Arch::X86>,
+			read_string_gcc_sso<Arch::X86>,
+			read_string_info_gcc_sso<Arch::X86>,
+			decode_string_gcc_sso<Arch::X86> };
+const ABI ABI::GCC_CXX11_64 = ABI{ Arch::AMD64, Compiler::GNU, StdLib::GNUCXX11,
 			make_primitive_type_info_gcc<Arch::AMD64, true>(),
 			PointerInfo<Arch::AMD64>,
 			make_container_type_info_gcc<Arch::AMD64, true>(),
 			container_info_common,
 			read_pointer_common<Arch::AMD64>,
-			read_vector_common<Arch::AMD64>,
-			read_string_gcc_sso<Arch::AMD64> };
-const ABI ABI::MSVC2015_32 = ABI{ Arch::X86, Compiler::MS,
+			decode_vector_common<Arch::AMD64>,
+			read_string_gcc_sso<Arch::AMD64>,
+			read_string_info_gcc_sso<Arch::AMD64>,
+			decode_string_gcc_sso<Arch::AMD64> };
+const ABI ABI::MSVC2015_32 = ABI{ Arch::X86, Compiler::MS, StdLib::MSVC2015,
 			make_primitive_type_info_msvc2015<Arch::X86>(),
 			PointerInfo<Arch::X86>,
 			make_container_type_info_msvc2015<Arch::X86>(),
 			container_info_common,
 			read_pointer_common<Arch::X86>,
-			read_vector_common<Arch::X86>,
-			read_string_msvc2015<Arch::X86> };
-const ABI ABI::MSVC2015_64 = ABI{ Arch::AMD64, Compiler::MS,
+			decode_vector_common<Arch::X86>,
+			read_string_msvc2015<Arch::X86>,
+			read_string_info_msvc2015<Arch::X86>,
+			decode_string_msvc2015<Arch::X86> };
+const ABI ABI::MSVC2015_64 = ABI{ Arch::AMD64, Compiler::MS, StdLib::MSVC2015,
 			make_primitive_type_info_msvc2015<Arch::AMD64>(),
 			PointerInfo<Arch::AMD64>,
 			make_container_type_info_msvc2015<Arch::AMD64>(),
 			container_info_common,
 			read_pointer_common<Arch::AMD64>,
-			read_vector_common<Arch::AMD64>,
-			read_string_msvc2015<Arch::AMD64> };
+			decode_vector_common<Arch::AMD64>,
+			read_string_msvc2015<Arch::AMD64>,
+			read_string_info_msvc2015<Arch::AMD64>,
+			decode_string_msvc2015<Arch::AMD64> };
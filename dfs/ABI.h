@@ -55,6 +55,14 @@ const std::error_category &abi_error_category();
 std::error_code make_error_code(ABIError);
 /// \}
 
+} // namespace dfs
+
+///< \ingroup ABIError
+template<>
+struct std::is_error_code_enum<dfs::ABIError>: true_type {};
+
+namespace dfs {
+
 /**
  * Size and alignment for type.
  *
@@ -91,6 +99,15 @@ struct ABI
 		MS,
 	} compiler;
 
+	/**
+	 * Standard library implementation (for library types layout).
+	 */
+	enum class StdLib {
+		GNUCOW,		///< libstdc++ pre-C++11 ABI (copy-on-write strings)
+		GNUCXX11,	///< libstdc++ C++11 ABI
+		MSVC2015,	///< MSVC2015 (v140)
+	} std_library;
+
 	/**
 	 * Primitive type information.
 	 */
@@ -161,10 +178,22 @@ struct ABI
 		std::size_t size = 0;		///< Size of the vector (item count)
 	};
 	/**
-	 * Reads a std::vector from raw data \p data whose item have type
+	 * Decodes a std::vector from raw data \p data whose item have type
 	 * information \p item_type_info.
+	 *
+	 * Only \p data is used, no memory is read from the process.
+	 */
+	vector_info (*decode_vector)(MemoryView data, const TypeInfo &item_type_info);
+
+	/**
+	 * Decodes a DF array (DFContainer::DFArray) from raw data \p data.
+	 *
+	 * \p data_offset and \p size_offset are the offsets of the
+	 * DFContainer::DFArrayData and DFContainer::DFArraySize members.
 	 */
-	cppcoro::task<vector_info> (*read_vector)(Process &process, MemoryView data, const TypeInfo &item_type_info);
+	vector_info decode_df_array(MemoryView data, std::size_t data_offset, std::size_t size_offset) const {
+		return {{}, get_pointer(data.subview(data_offset)), get_integer<uint16_t>(data.subview(size_offset))};
+	}
 
 	struct string_result
 	{
@@ -176,6 +205,44 @@ struct ABI
 	 */
 	cppcoro::task<string_result> (*read_string)(Process &process, MemoryView data);
 
+	struct string_info
+	{
+		std::error_code err = {};	///< Error if the string could not be read
+		uintptr_t data = 0;		///< Address of the string characters
+		std::size_t size = 0;		///< Length of the string
+	};
+	/**
+	 * Reads the location of the characters of a std::string from raw
+	 * data \p data without reading the characters themselves.
+	 *
+	 * Characters stored in the string object (small string
+	 * optimization) are located inside \p data.
+	 */
+	cppcoro::task<string_info> (*read_string_info)(Process &process, MemoryView data);
+	/**
+	 * Decodes the location of the characters of a std::string from raw
+	 * data \p data without reading process memory.
+	 *
+	 * It is null if the string header does not contain its length
+	 * (copy-on-write strings), use \ref read_string_info instead.
+	 */
+	string_info (*decode_string)(MemoryView data);
+
+	/**
+	 * Maximum capacity accepted for strings, larger values are considered
+	 * invalid.
+	 */
+	static constexpr std::size_t max_string_capacity = 1000000;
+
+	/**
+	 * \returns true if the characters from \p info are stored inside the
+	 * string object \p data (small string optimization).
+	 */
+	static bool is_local_string(const string_info &info, MemoryView data) {
+		return info.data >= data.address
+			&& info.data + info.size <= data.address + data.data.size();
+	}
+
 	/**
 	 * Initialize type information for primitive type whose size is platform indenpendant.
 	 */
@@ -294,7 +361,72 @@ struct ABI
 	static uintptr_t read_pointer_common(const uint8_t *);
 
 	template <Arch arch>
-	static cppcoro::task<vector_info> read_vector_common(Process &process, MemoryView data, const TypeInfo &item_type_info);
+	static vector_info decode_vector_common(MemoryView data, const TypeInfo &item_type_info) {
+		// struct vector {
+		//     T *begin;
+		//     T *end;
+		//     T *end_capacity;
+		// };
+		using Uintptr = uintptr<arch>::type;
+		std::array<Uintptr, 3> ptr;
+		std::memcpy(ptr.data(), data.data.data(), ptr.size() * sizeof(Uintptr));
+		if ((ptr[0] | ptr[1] | ptr[2]) == 0)
+			return {};
+		if ((ptr[0] | ptr[1] | ptr[2]) % item_type_info.align != 0)
+			return {ABIError::UnalignedPointer};
+		if (ptr[1] < ptr[0] || (ptr[1]-ptr[0])%item_type_info.size != 0)
+			return {ABIError::InvalidLength};
+		if (ptr[2] < ptr[1] || (ptr[2]-ptr[0])%item_type_info.size != 0)
+			return {ABIError::InvalidCapacity};
+		return {{}, ptr[0], (ptr[1]-ptr[0])/item_type_info.size};
+	}
+
+	template <Arch arch>
+	static string_info decode_string_gcc_sso(MemoryView data) {
+		// struct string {
+		//     char *data;
+		//     size_t length;
+		//     union {
+		//         char local_data[16];
+		//         size_t capacity;
+		//     };
+		// };
+		using Uintptr = uintptr<arch>::type;
+		auto buffer = get_integer<Uintptr>(data);
+		auto length = get_integer<Uintptr>(data.subview(sizeof(Uintptr)));
+		auto local_buffer = data.subview(2*sizeof(Uintptr), 16);
+		auto capacity = buffer == local_buffer.address
+			? 15
+			: get_integer<Uintptr>(local_buffer);
+		if (capacity > max_string_capacity)
+			return {ABIError::InvalidCapacity};
+		if (length > capacity)
+			return {ABIError::InvalidCapacity};
+		return {{}, buffer, length};
+	}
+
+	template <Arch arch>
+	static string_info decode_string_msvc2015(MemoryView data) {
+		// struct string {
+		//     union {
+		//         char local_data[16];
+		//         char *data;
+		//     };
+		//     size_t length;
+		//     size_t capacity;
+		// };
+		using Uintptr = uintptr<arch>::type;
+		auto length = get_integer<Uintptr>(data.subview(16));
+		auto capacity = get_integer<Uintptr>(data.subview(16+sizeof(Uintptr)));
+		if (capacity > max_string_capacity)
+			return {ABIError::InvalidCapacity};
+		if (length > capacity)
+			return {ABIError::InvalidCapacity};
+		if (capacity > 15)
+			return {{}, get_integer<Uintptr>(data), length};
+		else
+			return {{}, data.address, length};
+	}
 
 	template <Arch arch>
 	static cppcoro::task<string_result> read_string_gcc_cow(Process &process, MemoryView data);
@@ -305,6 +437,15 @@ struct ABI
 	template <Arch arch>
 	static cppcoro::task<string_result> read_string_msvc2015(Process &process, MemoryView data);
 
+	template <Arch arch>
+	static cppcoro::task<string_info> read_string_info_gcc_cow(Process &process, MemoryView data);
+
+	template <Arch arch>
+	static cppcoro::task<string_info> read_string_info_gcc_sso(Process &process, MemoryView data);
+
+	template <Arch arch>
+	static cppcoro::task<string_info> read_string_info_msvc2015(Process &process, MemoryView data);
+
 	static const ABI
 		GCC_32,		///< pre-C++11 ABI for GCC x86
 		GCC_64,		///< pre-C++11 ABI for GCC amd64
@@ -332,19 +473,19 @@ struct ABI::uintptr<ABI::Arch::AMD64> {
 
 extern template uintptr_t ABI::read_pointer_common<ABI::Arch::X86>(const uint8_t *);
 extern template uintptr_t ABI::read_pointer_common<ABI::Arch::AMD64>(const uint8_t *);
-extern template cppcoro::task<ABI::vector_info> ABI::read_vector_common<ABI::Arch::X86>(Process &, MemoryView, const TypeInfo &);
-extern template cppcoro::task<ABI::vector_info> ABI::read_vector_common<ABI::Arch::AMD64>(Process &, MemoryView, const TypeInfo &);
 extern template cppcoro::task<ABI::string_result> ABI::read_string_gcc_cow<ABI::Arch::X86>(Process &, MemoryView);
 extern template cppcoro::task<ABI::string_result> ABI::read_string_gcc_cow<ABI::Arch::AMD64>(Process &, MemoryView);
 extern template cppcoro::task<ABI::string_result> ABI::read_string_gcc_sso<ABI::Arch::X86>(Process &, MemoryView);
 extern template cppcoro::task<ABI::string_result> ABI::read_string_gcc_sso<ABI::Arch::AMD64>(Process &, MemoryView);
 extern template cppcoro::task<ABI::string_result> ABI::read_string_msvc2015<ABI::Arch::X86>(Process &, MemoryView);
 extern template cppcoro::task<ABI::string_result> ABI::read_string_msvc2015<ABI::Arch::AMD64>(Process &, MemoryView);
+extern template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_cow<ABI::Arch::X86>(Process &, MemoryView);
+extern template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_cow<ABI::Arch::AMD64>(Process &, MemoryView);
+extern template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_sso<ABI::Arch::X86>(Process &, MemoryView);
+extern template cppcoro::task<ABI::string_info> ABI::read_string_info_gcc_sso<ABI::Arch::AMD64>(Process &, MemoryView);
+extern template cppcoro::task<ABI::string_info> ABI::read_string_info_msvc2015<ABI::Arch::X86>(Process &, MemoryView);
+extern template cppcoro::task<ABI::string_info> ABI::read_string_info_msvc2015<ABI::Arch::AMD64>(Process &, MemoryView);
 
 } // namespace dfs
 
-///< \ingroup ABIError
-template<>
-struct std::is_error_code_enum<dfs::ABIError>: true_type {};
-
 #endif
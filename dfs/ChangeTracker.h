@@ -0,0 +1,241 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_CHANGE_TRACKER_H
+#define DFS_CHANGE_TRACKER_H
+
+#include <dfs/CompoundReader.h>
+
+#include <cstring>
+
+namespace dfs {
+
+namespace details {
+
+template <typename F>
+struct is_vtable_field: std::false_type {};
+
+template <auto FieldPtr>
+struct is_vtable_field<VTable<FieldPtr>>: std::true_type {};
+
+} // namespace details
+
+/**
+ * Tracks changes of objects of type \p T between sessions.
+ *
+ * The raw memory of each tracked object is kept from the previous update and
+ * compared with the new memory for each field of the compound reader of \p T
+ * (fields from Base readers are included). Only objects with a changed field
+ * are decoded again, others keep their previous value.
+ *
+ * The comparison is shallow: only the memory of the object itself is
+ * compared. A change in memory referenced by a field (e.g. the content of a
+ * vector) is not detected unless the field itself changes.
+ *
+ * \ingroup readers
+ */
+template <ReadableStructure T> requires CompoundReaderWithArgs<compound_reader_type_t<T>>
+class ChangeTracker
+{
+public:
+	/**
+	 * A change of a tracked object.
+	 */
+	struct Change
+	{
+		enum Kind {
+			Added,		///< The object was not tracked before
+			Modified,	///< At least one field changed
+			Removed,	///< The object is no longer tracked
+		} kind;
+		uintptr_t address;
+		/**
+		 * Changed fields, indexed as by fieldIndex(). All fields
+		 * are set for added objects, none for removed objects.
+		 */
+		std::vector<bool> fields;
+	};
+
+	/**
+	 * Constructs a tracker using the compound reader for \p T from \p factory.
+	 */
+	ChangeTracker(ReaderFactory &factory):
+		_compound_reader(factory.getCompoundReader<T>()),
+		_size(_compound_reader->info.size)
+	{
+		add_fields(*_compound_reader, factory.abi);
+	}
+
+	/**
+	 * Reads the objects at \p addresses and update the changes.
+	 *
+	 * Objects tracked from a previous update that are not in \p addresses
+	 * are removed. The memory of all objects is read in a single
+	 * Process::readv call.
+	 *
+	 * \throws std::system_error if the memory could not be read. The
+	 * tracker state is not modified in that case.
+	 */
+	cppcoro::task<> update(ReadSession &session, std::span<const uintptr_t> addresses)
+	{
+		std::vector<Change> changes;
+		// Read new memory
+		MemoryBuffer data(0, addresses.size() * _size);
+		std::vector<MemoryBufferRef> refs(addresses.size());
+		for (std::size_t i = 0; i < addresses.size(); ++i)
+			refs[i] = {addresses[i], {data.data() + i * _size, _size}};
+		if (!refs.empty()) {
+			if (auto err = co_await session.process().readv(refs))
+				throw std::system_error(err);
+		}
+		// Compare with old memory and decode changed objects
+		std::vector<std::pair<std::size_t, std::unique_ptr<T>>> decoded;
+		std::vector<cppcoro::task<std::error_code>> tasks;
+		for (std::size_t i = 0; i < addresses.size(); ++i) {
+			auto it = _objects.find(addresses[i]);
+			std::vector<bool> fields(_fields.size(), true);
+			if (it == _objects.end()) {
+				changes.push_back({Change::Added, addresses[i], std::move(fields)});
+			}
+			else {
+				const uint8_t *old_data = it->second.data.get();
+				const uint8_t *new_data = refs[i].data.data();
+				if (std::memcmp(old_data, new_data, _size) == 0)
+					continue;
+				bool changed = false;
+				for (std::size_t f = 0; f < _fields.size(); ++f) {
+					const auto &[offset, size, field] = _fields[f];
+					fields[f] = std::memcmp(old_data + offset, new_data + offset, size) != 0;
+					changed = changed || fields[f];
+				}
+				if (!changed)
+					continue;
+				changes.push_back({Change::Modified, addresses[i], std::move(fields)});
+			}
+			auto &[index, object] = decoded.emplace_back(i, std::make_unique<T>());
+			tasks.push_back(_compound_reader->read(session, refs[i], *object));
+		}
+		if (auto err = co_await details::when_all_errors(std::move(tasks)))
+			throw std::system_error(err);
+		// Update state
+		std::unordered_map<uintptr_t, entry_t> objects;
+		objects.reserve(addresses.size());
+		for (auto address: addresses)
+			if (auto node = _objects.extract(address))
+				objects.insert(std::move(node));
+		for (const auto &[address, entry]: _objects)
+			changes.push_back({Change::Removed, address, std::vector<bool>(_fields.size(), false)});
+		for (auto &[i, object]: decoded) {
+			auto &entry = objects[addresses[i]];
+			if (!entry.data)
+				entry.data = std::make_unique<uint8_t[]>(_size);
+			std::memcpy(entry.data.get(), refs[i].data.data(), _size);
+			entry.object = std::move(object);
+		}
+		_objects = std::move(objects);
+		_changes = std::move(changes);
+	}
+
+	/**
+	 * Changes from the last update.
+	 */
+	const std::vector<Change> &changes() const { return _changes; }
+
+	/**
+	 * \returns the last decoded value of the object at \p address or \c
+	 * nullptr if it is not tracked.
+	 */
+	const T *get(uintptr_t address) const {
+		auto it = _objects.find(address);
+		return it == _objects.end() ? nullptr : it->second.object.get();
+	}
+
+	/**
+	 * Number of fields compared (size of Change::fields).
+	 */
+	std::size_t fieldCount() const { return _fields.size(); }
+
+	/**
+	 * \returns the index in Change::fields of the Field reading \p FieldPtr.
+	 *
+	 * \throws std::system_error if the field reader failed to initialize
+	 */
+	template <auto FieldPtr>
+	std::size_t fieldIndex() const {
+		const void *field_ptr = details::visit_field<FieldPtr>(*_compound_reader, [](const auto &field) -> const void * {
+			return &field;
+		});
+		auto it = std::ranges::find(_fields, field_ptr, &field_range_t::field);
+		if (it == _fields.end())
+			throw std::system_error(ItemReaderError::InvalidField);
+		return it - _fields.begin();
+	}
+
+	/**
+	 * \returns true if the member \p FieldPtr changed in \p change.
+	 */
+	template <auto FieldPtr>
+	bool changed(const Change &change) const {
+		return change.fields[fieldIndex<FieldPtr>()];
+	}
+
+private:
+	struct entry_t {
+		std::unique_ptr<uint8_t[]> data;
+		std::unique_ptr<T> object;
+	};
+	struct field_range_t {
+		std::size_t offset, size;
+		const void *field;
+	};
+
+	const compound_reader_type_t<T> *_compound_reader;
+	std::size_t _size;
+	std::vector<field_range_t> _fields;
+	std::unordered_map<uintptr_t, entry_t> _objects;
+	std::vector<Change> _changes;
+
+	template <typename Reader>
+	void add_fields(const Reader &reader, const ABI &abi) {
+		std::apply([&, this](const auto &...fields) {
+			(add_field(fields, abi), ...);
+		}, reader.fields);
+	}
+
+	template <typename F>
+	void add_field(const F &field, const ABI &abi) {
+		if constexpr (details::is_base_field<F>::value) {
+			if (field.reader)
+				add_fields(*field.reader, abi);
+		}
+		else if constexpr (details::is_vtable_field<F>::value) {
+			_fields.push_back({0, abi.pointer.size, &field});
+		}
+		else if constexpr (requires { field.offset; field.reader->size(); }) {
+			if (field.reader)
+				_fields.push_back({field.offset, field.reader->size(), &field});
+		}
+		else { // unknown field reader, compare the whole object
+			_fields.push_back({0, _size, &field});
+		}
+	}
+};
+
+} // namespace dfs
+
+#endif
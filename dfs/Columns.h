@@ -0,0 +1,266 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_COLUMNS_H
+#define DFS_COLUMNS_H
+
+#include <dfs/CompoundReader.h>
+#include <dfs/ItemReader.h>
+
+namespace dfs {
+
+namespace details {
+
+template <auto Ptr, auto... Ptrs>
+consteval std::size_t member_index()
+{
+	std::size_t index = 0;
+	bool found = false;
+	([&]() {
+		if (found)
+			return;
+		if constexpr (std::is_same_v<decltype(Ptr), decltype(Ptrs)>)
+			found = Ptr == Ptrs;
+		if (!found)
+			++index;
+	}(), ...);
+	return index;
+}
+
+} // namespace details
+
+/**
+ * Structure-of-arrays storage for some members of the structure \p T.
+ *
+ * Each member in \p FieldPtrs is stored in its own contiguous column. Row \c i
+ * of every column comes from the object at `addresses[i]`.
+ *
+ * \sa "ItemReader< Columns< T, FieldPtrs... > >"
+ *
+ * \ingroup readers
+ */
+template <ReadableStructure T, auto... FieldPtrs>
+struct Columns
+{
+	using structure_type = T;
+
+	/**
+	 * Address of the object of each row.
+	 */
+	std::vector<uintptr_t> addresses;
+	/**
+	 * One column for each member in \p FieldPtrs.
+	 */
+	std::tuple<std::vector<details::member_type_t<FieldPtrs>>...> columns;
+
+	std::size_t size() const { return addresses.size(); }
+	bool empty() const { return addresses.empty(); }
+
+	void resize(std::size_t n) {
+		addresses.resize(n);
+		std::apply([n](auto &...column) { (column.resize(n), ...); }, columns);
+	}
+
+	void clear() {
+		resize(0);
+	}
+
+	/**
+	 * \returns the column for the member \p FieldPtr.
+	 */
+	template <auto FieldPtr>
+	auto &column() {
+		constexpr auto index = details::member_index<FieldPtr, FieldPtrs...>();
+		static_assert(index < sizeof...(FieldPtrs), "member is not a column");
+		return get<index>(columns);
+	}
+	/**
+	 * \overload
+	 */
+	template <auto FieldPtr>
+	const auto &column() const {
+		constexpr auto index = details::member_index<FieldPtr, FieldPtrs...>();
+		static_assert(index < sizeof...(FieldPtrs), "member is not a column");
+		return get<index>(columns);
+	}
+};
+
+/**
+ * Reader for Columns.
+ *
+ * It accepts StdContainer::StdVector or DFContainer::DFArray whose items are
+ * the compound for \p T or pointers to it. Null pointers are skipped.
+ *
+ * Members are read using the Field from the compound reader of \p T (or its
+ * bases). Only the memory range covering the selected members of each object
+ * is read, using a single Process::readv call. Members whose ItemReader
+ * satisfies DecodableType are decoded synchronously.
+ *
+ * \ingroup readers
+ */
+template <ReadableStructure T, auto... FieldPtrs>
+class ItemReader<Columns<T, FieldPtrs...>>
+{
+	template <auto FieldPtr>
+	struct column_reader_t {
+		std::size_t offset;
+		const ItemReader<details::member_type_t<FieldPtr>> *reader;
+	};
+
+	const compound_reader_type_t<T> *_compound_reader;
+	AnyTypeRef _container_type;
+	std::size_t _size;
+	bool _item_is_pointer;
+	TypeInfo _item_info;
+	const CompoundLayout *_compound_layout = nullptr;
+	std::tuple<column_reader_t<FieldPtrs>...> _column_readers;
+	std::size_t _span_begin, _span_end;
+
+public:
+	using output_type = Columns<T, FieldPtrs...>;
+
+	ItemReader(ReaderFactory &factory, AnyTypeRef type):
+		_compound_reader(factory.getCompoundReader<T>()),
+		_container_type(type),
+		_size(factory.layout.getTypeInfo(type).size)
+	{
+		AnyTypeRef item_type = type.visit(overloaded{
+			[](const StdContainer &container) -> AnyTypeRef {
+				switch (container.container_type) {
+				case StdContainer::StdVector:
+					return container.itemType();
+				default:
+					throw TypeError(container, typeid(output_type), "incompatible container");
+				}
+			},
+			[](const DFContainer &container) -> AnyTypeRef {
+				switch (container.container_type) {
+				case DFContainer::DFArray:
+					return container.itemType();
+				default:
+					throw TypeError(container, typeid(output_type), "incompatible container");
+				}
+			},
+			[&](const AbstractType &) -> AnyTypeRef {
+				throw TypeError(type, typeid(output_type), "incompatible container");
+			}
+		});
+		_item_info = factory.layout.getTypeInfo(item_type);
+		if (_compound_reader->type == item_type.get_if<Compound>())
+			_item_is_pointer = false;
+		else if (auto pointer = item_type.get_if<PointerType>();
+				pointer && !pointer->type_params.empty() &&
+				_compound_reader->type == pointer->itemType().get_if<Compound>())
+			_item_is_pointer = true;
+		else
+			throw TypeError(item_type, typeid(T), "invalid item type");
+		if (auto container = type.get_if<DFContainer>())
+			_compound_layout = &factory.layout.compound_layout.at(container->compound.get());
+
+		_column_readers = {details::visit_field<FieldPtrs>(*_compound_reader, [this](const auto &field) {
+			if (!field.reader)
+				throw std::runtime_error(std::format("field reader failed to initialize in {} (local: {})",
+						_compound_reader->type->debug_name, typeid(T).name()));
+			return column_reader_t<FieldPtrs>{field.offset, &*field.reader};
+		})...};
+		if constexpr (sizeof...(FieldPtrs) == 0) {
+			_span_begin = _span_end = 0;
+		}
+		else {
+			_span_begin = std::min({get<column_reader_t<FieldPtrs>>(_column_readers).offset...});
+			_span_end = std::max({(get<column_reader_t<FieldPtrs>>(_column_readers).offset
+					+ get<column_reader_t<FieldPtrs>>(_column_readers).reader->size())...});
+		}
+	}
+
+	std::size_t size() const {
+		return _size;
+	}
+
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, output_type &out) const
+	{
+		auto [err, addr, len] = session.visit_abi([&, this](auto abi) {
+			return _compound_layout
+				? abi.decode_df_array(data,
+					_compound_layout->member_offsets.at(DFContainer::DFArrayData),
+					_compound_layout->member_offsets.at(DFContainer::DFArraySize))
+				: abi.decode_vector(data, _item_info);
+		});
+		if (err)
+			co_return err;
+		out.clear();
+		if (len == 0)
+			co_return std::error_code{};
+
+		// Find object addresses
+		if (_item_is_pointer) {
+			MemoryBuffer pointers(addr, len * _item_info.size);
+			if (auto err = co_await session.process().read(pointers))
+				co_return err;
+			out.addresses.reserve(len);
+			session.visit_abi([&](auto abi) {
+				for (std::size_t i = 0; i < len; ++i)
+					if (auto object = abi.get_pointer(pointers.view(i * abi.pointer_size)))
+						out.addresses.push_back(object);
+			});
+		}
+		else {
+			out.addresses.resize(len);
+			for (std::size_t i = 0; i < len; ++i)
+				out.addresses[i] = addr + i * _item_info.size;
+		}
+		auto rows = out.addresses.size();
+		out.resize(rows);
+		if (rows == 0 || _span_end == _span_begin)
+			co_return std::error_code{};
+
+		// Read the span covering the columns from every object
+		auto span_size = _span_end - _span_begin;
+		MemoryBuffer spans(0, rows * span_size);
+		std::vector<MemoryBufferRef> refs(rows);
+		for (std::size_t i = 0; i < rows; ++i)
+			refs[i] = {out.addresses[i] + _span_begin, {spans.data() + i * span_size, span_size}};
+		if (auto err = co_await session.process().readv(refs))
+			co_return err;
+
+		// Decode columns
+		std::vector<cppcoro::task<std::error_code>> tasks;
+		([&, this]() {
+			const auto &[offset, reader] = get<column_reader_t<FieldPtrs>>(_column_readers);
+			auto &column = get<details::member_index<FieldPtrs, FieldPtrs...>()>(out.columns);
+			if constexpr (BatchDecodableType<details::member_type_t<FieldPtrs>>) {
+				// rows are span_size bytes apart in spans
+				reader->decode_n(spans.data() + (offset - _span_begin), span_size, rows, std::ranges::begin(column));
+				return;
+			}
+			for (std::size_t i = 0; i < rows; ++i) {
+				MemoryView row = refs[i];
+				auto item_data = row.subview(offset - _span_begin, reader->size());
+				if constexpr (DecodableType<details::member_type_t<FieldPtrs>>)
+					column[i] = reader->decode(item_data);
+				else
+					tasks.push_back((*reader)(session, item_data, column[i]));
+			}
+		}(), ...);
+		co_return co_await details::when_all_errors(std::move(tasks));
+	}
+};
+
+} // namespace dfs
+
+#endif
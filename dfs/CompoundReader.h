@@ -46,7 +46,7 @@ struct VTable
 	}
 	template <typename T>
 	[[nodiscard]] cppcoro::task<bool> read(ReadSession &session, MemoryView data, T &v) const {
-		std::invoke(FieldPtr, v) = session.abi().get_pointer(data);
+		std::invoke(FieldPtr, v) = session.visit_abi([&](auto abi) { return abi.get_pointer(data); });
 		co_return true;
 	}
 };
@@ -99,18 +99,24 @@ struct Field<FieldPtr, FieldPath, Discriminators...>
 	};
 
 	[[nodiscard]] cppcoro::task<bool> read(ReadSession &session, MemoryView data, Structure &structure) const {
-		try {
-			if (reader)
-				co_await (*reader)(session,
-						data.subview(offset),
-						std::invoke(ptr, structure),
-						std::invoke(Discriminators, structure)...);
+		if (!reader)
 			co_return true;
-		}
-		catch (std::exception &e) {
-			session.log(std::format("{} in {}: {}",
-					FieldPath.str(), parent->debug_name, e.what()));
-			co_return false;
+		auto err = co_await (*reader)(session,
+				data.subview(offset),
+				std::invoke(ptr, structure),
+				std::invoke(Discriminators, structure)...);
+		if (!err)
+			co_return true;
+		// Invalid nested fields were already reported
+		if (err != ItemReaderError::InvalidField)
+			session.report_error(parent, FieldPath.str(), err, data.address + offset);
+		co_return false;
+	}
+
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const {
+		if constexpr (PrefetchableReader<ItemReader<T>>) {
+			if (reader)
+				co_await reader->prefetch(session, data.subview(offset), prefetcher);
 		}
 	}
 };
@@ -150,15 +156,20 @@ struct Base
 	}
 
 	[[nodiscard]] cppcoro::task<bool> read(ReadSession &session, MemoryView data, T &base) const {
-		try {
-			if (reader)
-				co_await reader->read(session, data, base);
+		if (!reader)
 			co_return true;
-		}
-		catch (std::exception &e) {
-			session.log(std::format("read error in base {} (local: {}): {}",
-					reader->type->debug_name, typeid(base).name(), e.what()));
-			co_return false;
+		auto err = co_await reader->read(session, data, base);
+		if (!err)
+			co_return true;
+		if (err != ItemReaderError::InvalidField)
+			session.report_error(reader->type, "base", err, data.address);
+		co_return false;
+	}
+
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const {
+		if constexpr (PrefetchableReader<compound_reader_type_t<T>>) {
+			if (reader)
+				co_await reader->prefetch(session, data, prefetcher);
 		}
 	}
 };
@@ -213,6 +224,19 @@ struct CompoundReaderBase
 			throw std::runtime_error(std::format("nested errors in {}",
 					typeid(T).name()));
 	}
+
+	/**
+	 * Adds the objects referenced by the fields to \p prefetcher.
+	 */
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const
+	{
+		std::vector<cppcoro::task<>> tasks;
+		([&, this](const auto &field) {
+			if constexpr (requires { field.prefetch(session, data, prefetcher); })
+				tasks.push_back(field.prefetch(session, data, prefetcher));
+		}(get<Fields>(fields)), ...);
+		co_await cppcoro::when_all(std::move(tasks));
+	}
 };
 
 /**
@@ -235,12 +259,13 @@ struct StructureReaderSeq: CompoundReaderBase<T, TypeName, Fields...>
 					this->type->debug_name, typeid(T).name()));
 	}
 
-	cppcoro::task<> read(ReadSession &session, MemoryView data, T &out) const
+	cppcoro::task<std::error_code> read(ReadSession &session, MemoryView data, T &out) const
 	{
 		bool success = true;
 		((co_await get<Fields>(this->fields).read(session, data, out) || (success = false)), ...);
 		if (!success)
-			throw std::system_error(ItemReaderError::InvalidField);
+			co_return ItemReaderError::InvalidField;
+		co_return std::error_code{};
 	}
 };
 
@@ -265,13 +290,14 @@ struct StructureReader: CompoundReaderBase<T, TypeName, Fields...>
 					this->type->debug_name, typeid(T).name()));
 	}
 
-	cppcoro::task<> read(ReadSession &session, MemoryView data, T &out) const
+	cppcoro::task<std::error_code> read(ReadSession &session, MemoryView data, T &out) const
 	{
 		std::vector<cppcoro::task<bool>> tasks;
 		(tasks.push_back(get<Fields>(this->fields).read(session, data, out)), ...);
 		auto res = co_await cppcoro::when_all(std::move(tasks));
 		if (!std::ranges::all_of(res, std::identity{}))
-			throw std::system_error(ItemReaderError::InvalidField);
+			co_return ItemReaderError::InvalidField;
+		co_return std::error_code{};
 	}
 };
 
@@ -301,10 +327,10 @@ struct UnionReader: CompoundReaderBase<T, TypeName, Fields...>
 					typeid(T).name(), sizeof...(Fields)));
 	}
 
-	cppcoro::task<> read(ReadSession &session, MemoryView data, T &out, std::size_t discriminator) const
+	cppcoro::task<std::error_code> read(ReadSession &session, MemoryView data, T &out, std::size_t discriminator) const
 	{
 		if (discriminator == std::size_t(-1))
-			co_return;
+			co_return std::error_code{};
 		if (auto res = selectAlternative(
 				[&]<std::size_t I>(index_constant<I>){ return I == discriminator; },
 				[&]<std::size_t I>(index_constant<I>) -> cppcoro::task<bool> {
@@ -312,10 +338,19 @@ struct UnionReader: CompoundReaderBase<T, TypeName, Fields...>
 				},
 				std::index_sequence_for<Fields...>{})) {
 			if (!co_await *res)
-				throw std::system_error(ItemReaderError::InvalidField);
+				co_return ItemReaderError::InvalidField;
+			co_return std::error_code{};
 		}
 		else
-			throw std::system_error(ItemReaderError::InvalidDiscriminator);
+			co_return ItemReaderError::InvalidDiscriminator;
+	}
+
+	/**
+	 * Does nothing, the active member is not known without the discriminator.
+	 */
+	cppcoro::task<> prefetch(ReadSession &, MemoryView, Prefetcher &) const
+	{
+		co_return;
 	}
 };
 
@@ -336,6 +371,82 @@ struct find_base_field<First, Others...>
 	using type = typename find_base_field<Others...>::type;
 };
 
+template <auto MemberPtr>
+struct member_pointer_traits;
+
+template <typename T, typename Structure, T Structure::*MemberPtr>
+struct member_pointer_traits<MemberPtr>
+{
+	using member_type = T;
+	using structure_type = Structure;
+};
+
+template <auto MemberPtr>
+using member_type_t = typename member_pointer_traits<MemberPtr>::member_type;
+
+template <typename F>
+struct is_base_field: std::false_type {};
+
+template <typename T>
+struct is_base_field<Base<T>>: std::true_type {};
+
+template <auto FieldPtr, typename F>
+consteval bool is_field_for()
+{
+	if constexpr (requires { F::ptr; }) {
+		if constexpr (std::is_same_v<std::remove_cv_t<decltype(F::ptr)>, decltype(FieldPtr)>)
+			return F::ptr == FieldPtr;
+	}
+	return false;
+}
+
+template <auto FieldPtr, typename Reader>
+consteval bool reader_has_field();
+
+template <auto FieldPtr, typename F>
+consteval bool field_contains()
+{
+	if constexpr (is_field_for<FieldPtr, F>())
+		return true;
+	else if constexpr (is_base_field<F>::value)
+		return reader_has_field<FieldPtr, std::remove_pointer_t<decltype(F::reader)>>();
+	else
+		return false;
+}
+
+template <auto FieldPtr, typename Reader>
+consteval bool reader_has_field()
+{
+	return []<typename... Fields>(std::type_identity<std::tuple<Fields...>>) {
+		return (field_contains<FieldPtr, Fields>() || ...);
+	}(std::type_identity<decltype(Reader::fields)>{});
+}
+
+/**
+ * Calls \p f with the Field reading \p FieldPtr from \p reader or one of
+ * its bases.
+ */
+template <auto FieldPtr, typename Reader, typename F>
+decltype(auto) visit_field(const Reader &reader, F &&f)
+{
+	return [&]<typename... Fields>(const std::tuple<Fields...> &fields) -> decltype(auto) {
+		constexpr std::array<bool, sizeof...(Fields)> matches = {
+			field_contains<FieldPtr, Fields>()...
+		};
+		constexpr std::size_t index = std::ranges::find(matches, true) - matches.begin();
+		static_assert(index < sizeof...(Fields), "member is not read by the compound reader");
+		const auto &field = get<index>(fields);
+		if constexpr (is_field_for<FieldPtr, std::tuple_element_t<index, std::tuple<Fields...>>>()) {
+			return std::invoke(std::forward<F>(f), field);
+		}
+		else {
+			if (!field.reader)
+				throw std::system_error(ItemReaderError::InvalidField);
+			return visit_field<FieldPtr>(*field.reader, std::forward<F>(f));
+		}
+	}(reader.fields);
+}
+
 } // namespace details
 
 template <typename T, static_string TypeName, typename... Fields> requires requires { typename details::find_base_field<Fields...>::type; }
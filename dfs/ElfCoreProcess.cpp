@@ -0,0 +1,305 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ElfCoreProcess.h"
+
+#include "LinuxProcess.h"
+
+extern "C" {
+#include <elf.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+}
+
+#include <algorithm>
+#include <cstring>
+
+using namespace dfs;
+
+namespace {
+
+struct elf32
+{
+	using Ehdr = Elf32_Ehdr;
+	using Phdr = Elf32_Phdr;
+	using word = uint32_t;
+};
+
+struct elf64
+{
+	using Ehdr = Elf64_Ehdr;
+	using Phdr = Elf64_Phdr;
+	using word = uint64_t;
+};
+
+template <typename T>
+T get(std::span<const uint8_t> data, std::size_t offset)
+{
+	if (offset > data.size() || data.size() - offset < sizeof(T))
+		throw std::runtime_error("Truncated core file");
+	T value;
+	std::memcpy(&value, data.data() + offset, sizeof(T));
+	return value;
+}
+
+constexpr std::size_t align4(std::size_t n) { return (n + 3) & ~std::size_t(3); }
+
+} // namespace
+
+ElfCoreProcess::ElfCoreProcess(const std::filesystem::path &core, const std::filesystem::path &executable)
+{
+	int fd = open(core.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		throw std::system_error(errno, std::system_category(), "Failed to open core file");
+	struct stat st;
+	if (-1 == fstat(fd, &st)) {
+		auto err = errno;
+		close(fd);
+		throw std::system_error(err, std::system_category(), "Failed to stat core file");
+	}
+	_size = st.st_size;
+	void *data = _size > 0
+		? mmap(nullptr, _size, PROT_READ, MAP_PRIVATE, fd, 0)
+		: MAP_FAILED;
+	auto err = errno;
+	close(fd);
+	if (data == MAP_FAILED)
+		throw std::system_error(_size > 0 ? err : EINVAL, std::system_category(), "Failed to map core file");
+	_data = std::shared_ptr<const uint8_t[]>(static_cast<const uint8_t *>(data),
+			[size = _size](const uint8_t *p) { munmap(const_cast<uint8_t *>(p), size); });
+
+	std::span<const uint8_t> file(_data.get(), _size);
+	if (_size < EI_NIDENT || std::memcmp(file.data(), ELFMAG, SELFMAG) != 0)
+		throw std::runtime_error("Not an ELF file");
+	if (file[EI_DATA] != ELFDATA2LSB)
+		throw std::runtime_error("Unsupported ELF byte order");
+	uintptr_t entry;
+	switch (file[EI_CLASS]) {
+	case ELFCLASS32:
+		entry = parse<elf32>();
+		break;
+	case ELFCLASS64:
+		entry = parse<elf64>();
+		break;
+	default:
+		throw std::runtime_error("Unsupported ELF class");
+	}
+	identify(entry, executable);
+}
+
+template <typename Elf>
+uintptr_t ElfCoreProcess::parse()
+{
+	std::span<const uint8_t> file(_data.get(), _size);
+	auto header = get<typename Elf::Ehdr>(file, 0);
+	if (header.e_type != ET_CORE)
+		throw std::runtime_error("Not a core file");
+	if (header.e_phentsize < sizeof(typename Elf::Phdr))
+		throw std::runtime_error("Invalid program header size");
+	uintptr_t entry = 0;
+	for (std::size_t i = 0; i < header.e_phnum; ++i) {
+		auto phdr = get<typename Elf::Phdr>(file, header.e_phoff + i * header.e_phentsize);
+		switch (phdr.p_type) {
+		case PT_LOAD: {
+			if (phdr.p_memsz == 0)
+				break;
+			// truncated cores may miss the end of the data
+			std::size_t file_size = phdr.p_offset < _size
+				? std::min<std::size_t>(phdr.p_filesz, _size - phdr.p_offset)
+				: 0;
+			_segments.push_back({phdr.p_vaddr, phdr.p_memsz, phdr.p_offset, file_size});
+			break;
+		}
+		case PT_NOTE: {
+			if (phdr.p_offset > _size || _size - phdr.p_offset < phdr.p_filesz)
+				throw std::runtime_error("Truncated note segment");
+			auto notes = file.subspan(phdr.p_offset, phdr.p_filesz);
+			std::size_t offset = 0;
+			// Nhdr has the same layout for both classes
+			while (offset + sizeof(Elf64_Nhdr) <= notes.size()) {
+				auto note = get<Elf64_Nhdr>(notes, offset);
+				auto name_offset = offset + sizeof(Elf64_Nhdr);
+				auto desc_offset = name_offset + align4(note.n_namesz);
+				offset = desc_offset + align4(note.n_descsz);
+				if (desc_offset > notes.size() || notes.size() - desc_offset < note.n_descsz)
+					throw std::runtime_error("Truncated note");
+				auto desc = notes.subspan(desc_offset, note.n_descsz);
+				switch (note.n_type) {
+				case NT_FILE:
+					parse_file_note(desc, sizeof(typename Elf::word));
+					break;
+				case NT_AUXV:
+					for (std::size_t j = 0; j + 2*sizeof(typename Elf::word) <= desc.size(); j += 2*sizeof(typename Elf::word))
+						if (get<typename Elf::word>(desc, j) == AT_ENTRY)
+							entry = get<typename Elf::word>(desc, j + sizeof(typename Elf::word));
+					break;
+				}
+			}
+			break;
+		}
+		}
+	}
+	std::ranges::sort(_segments, {}, &segment_t::address);
+	std::ranges::sort(_file_mappings, {}, &FileMapping::start);
+	return entry;
+}
+
+void ElfCoreProcess::parse_file_note(std::span<const uint8_t> desc, std::size_t word_size)
+{
+	// struct {
+	//     long count;
+	//     long page_size;
+	//     struct { long start, end, file_ofs; } mappings[count];
+	//     char filenames[]; // count NUL-terminated strings
+	// };
+	auto get_word = [&](std::size_t offset) -> uint64_t {
+		return word_size == 4
+			? get<uint32_t>(desc, offset)
+			: get<uint64_t>(desc, offset);
+	};
+	auto count = get_word(0);
+	auto page_size = get_word(word_size);
+	auto names_offset = 2*word_size + count*3*word_size;
+	if (names_offset > desc.size())
+		throw std::runtime_error("Truncated NT_FILE note");
+	auto names = std::string_view(reinterpret_cast<const char *>(desc.data()) + names_offset,
+			desc.size() - names_offset);
+	for (std::size_t i = 0; i < count; ++i) {
+		auto entry = 2*word_size + i*3*word_size;
+		auto name_end = names.find('\0');
+		_file_mappings.push_back({
+				get_word(entry),
+				get_word(entry + word_size),
+				get_word(entry + 2*word_size) * page_size,
+				std::string(names.substr(0, name_end))});
+		names.remove_prefix(name_end == std::string_view::npos ? names.size() : name_end + 1);
+	}
+}
+
+void ElfCoreProcess::identify(uintptr_t entry, const std::filesystem::path &executable)
+{
+	auto wine = std::ranges::find_if(_file_mappings, [](const auto &mapping) {
+		return mapping.file_offset == 0 && mapping.path.ends_with("Dwarf Fortress.exe");
+	});
+	if (executable.empty() && wine != _file_mappings.end()) {
+		// Same as WineProcess, but the PE header is read from the
+		// mapped image:
+		//   IMAGE_DOS_HEADER::e_lfanew at 0x3c
+		//   IMAGE_NT_HEADERS::FileHeader.TimeDateStamp at e_lfanew + 8
+		_base_offset = wine->start - 0x140000000ull;
+		uint32_t e_lfanew;
+		if (auto err = copy({wine->start + 0x3c, {reinterpret_cast<uint8_t *>(&e_lfanew), sizeof(e_lfanew)}}))
+			throw std::system_error(err, "Failed to read PE header");
+		_id.resize(4);
+		if (auto err = copy({wine->start + e_lfanew + 8, _id}))
+			throw std::system_error(err, "Failed to read PE header");
+		std::ranges::reverse(_id);
+		return;
+	}
+
+	std::filesystem::path path = executable;
+	if (path.empty()) {
+		auto it = std::ranges::find_if(_file_mappings, [entry](const auto &mapping) {
+			return mapping.start <= entry && entry < mapping.end;
+		});
+		if (entry == 0 || it == _file_mappings.end())
+			throw std::runtime_error("Executable not found in core file");
+		path = it->path;
+	}
+	_id = LinuxProcess::executable_md5(path);
+}
+
+std::span<const uint8_t> ElfCoreProcess::id() const
+{
+	return _id;
+}
+
+intptr_t ElfCoreProcess::base_offset() const
+{
+	return _base_offset;
+}
+
+std::error_code ElfCoreProcess::stop()
+{
+	return {};
+}
+
+std::error_code ElfCoreProcess::cont()
+{
+	return {};
+}
+
+const ElfCoreProcess::segment_t *ElfCoreProcess::find_segment(uintptr_t address) const
+{
+	auto it = std::ranges::upper_bound(_segments, address, {}, &segment_t::address);
+	if (it == _segments.begin())
+		return nullptr;
+	--it;
+	if (address - it->address >= it->memory_size)
+		return nullptr;
+	return &*it;
+}
+
+std::error_code ElfCoreProcess::copy(MemoryBufferRef buffer) const
+{
+	auto address = buffer.address;
+	auto out = buffer.data;
+	while (!out.empty()) {
+		// reads may span several contiguous segments
+		auto segment = find_segment(address);
+		if (!segment)
+			return std::make_error_code(std::errc::bad_address);
+		auto offset = address - segment->address;
+		// memory after file_size was not dumped
+		if (offset >= segment->file_size)
+			return std::make_error_code(std::errc::bad_address);
+		auto len = std::min(out.size(), segment->file_size - offset);
+		std::memcpy(out.data(), _data.get() + segment->file_offset + offset, len);
+		address += len;
+		out = out.subspan(len);
+	}
+	return {};
+}
+
+cppcoro::task<std::error_code> ElfCoreProcess::read(MemoryBufferRef buffer)
+{
+	co_return copy(buffer);
+}
+
+cppcoro::task<std::error_code> ElfCoreProcess::readv(std::span<const MemoryBufferRef> tasks)
+{
+	std::error_code res;
+	for (const auto &buffer: tasks)
+		if (auto err = copy(buffer); err && !res)
+			res = err;
+	co_return res;
+}
+
+cppcoro::task<std::error_code> ElfCoreProcess::pin(uintptr_t address, std::size_t size, PinnedMemory &out)
+{
+	auto segment = find_segment(address);
+	if (segment && address - segment->address + size <= segment->file_size) {
+		auto data = _data.get() + segment->file_offset + (address - segment->address);
+		out = PinnedMemory(_data, {address, {data, size}});
+		co_return std::error_code{};
+	}
+	// Spans several segments or unsaved memory
+	co_return co_await Process::pin(address, size, out);
+}
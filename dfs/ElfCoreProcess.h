@@ -0,0 +1,131 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_ELF_CORE_PROCESS_H
+#define DFS_ELF_CORE_PROCESS_H
+
+#include <dfs/Process.h>
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace dfs {
+
+/**
+ * Reads memory from an ELF core file (produced by `gcore` or the kernel)
+ * instead of a running process (linux-only).
+ *
+ * The core file is mapped in memory, reads are copies from the mapping and
+ * pin() shares the mapping without copying.
+ *
+ * The identity of the process is found from the file mappings stored in the
+ * core:
+ *  - if `Dwarf Fortress.exe` is mapped (wine), the PE timestamp is read from
+ *    the mapped image and the base offset is computed as in WineProcess;
+ *  - otherwise the executable is the file containing the entry point, it is
+ *    identified by its MD5 as in LinuxProcess. The executable must still
+ *    exist, its path can be overridden if it was moved.
+ *
+ * Memory that was not saved in the core (e.g. read-only file mappings with
+ * the default `coredump_filter`) cannot be read, reads fail with
+ * `std::errc::bad_address`.
+ *
+ * stop() and cont() do nothing.
+ *
+ * \ingroup process
+ */
+class ElfCoreProcess: public Process
+{
+public:
+	/**
+	 * Opens the core file \p core.
+	 *
+	 * \p executable overrides the path of the native executable found in
+	 * the core.
+	 *
+	 * \throws std::system_error if the file cannot be opened or mapped
+	 * \throws std::runtime_error if the file is not a supported core file
+	 * or the executable cannot be identified
+	 */
+	ElfCoreProcess(const std::filesystem::path &core, const std::filesystem::path &executable = {});
+	~ElfCoreProcess() override = default;
+
+	std::span<const uint8_t> id() const override;
+	intptr_t base_offset() const override;
+
+	[[nodiscard]] std::error_code stop() override;
+	[[nodiscard]] std::error_code cont() override;
+
+	[[nodiscard]] cppcoro::task<std::error_code> read(MemoryBufferRef buffer) override;
+	[[nodiscard]] cppcoro::task<std::error_code> readv(std::span<const MemoryBufferRef> tasks) override;
+	[[nodiscard]] cppcoro::task<std::error_code> pin(uintptr_t address, std::size_t size, PinnedMemory &out) override;
+
+	/**
+	 * A file mapped in the process (from the NT_FILE note).
+	 */
+	struct FileMapping
+	{
+		uintptr_t start, end;
+		std::size_t file_offset;	///< offset in the file (in bytes)
+		std::string path;
+	};
+
+	/**
+	 * \returns the files mapped in the process, sorted by address
+	 */
+	std::span<const FileMapping> file_mappings() const { return _file_mappings; }
+
+private:
+	/**
+	 * A PT_LOAD segment. Bytes after \ref file_size were not dumped
+	 * (the kernel does not dump some mappings, or the core is truncated)
+	 * and cannot be read.
+	 */
+	struct segment_t
+	{
+		uintptr_t address;
+		std::size_t memory_size;
+		std::size_t file_offset;
+		std::size_t file_size;
+	};
+
+	std::shared_ptr<const uint8_t[]> _data;
+	std::size_t _size;
+	std::vector<segment_t> _segments;
+	std::vector<FileMapping> _file_mappings;
+	std::vector<uint8_t> _id;
+	intptr_t _base_offset = 0;
+
+	/**
+	 * Parses program headers and notes.
+	 *
+	 * \returns the entry point address from the auxiliary vector (or 0)
+	 */
+	template <typename Elf>
+	uintptr_t parse();
+	void parse_file_note(std::span<const uint8_t> desc, std::size_t word_size);
+	void identify(uintptr_t entry, const std::filesystem::path &executable);
+
+	std::error_code copy(MemoryBufferRef buffer) const;
+	const segment_t *find_segment(uintptr_t address) const;
+};
+
+} // namespace dfs
+
+#endif
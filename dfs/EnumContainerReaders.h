@@ -0,0 +1,154 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_ENUM_CONTAINER_READERS_H
+#define DFS_ENUM_CONTAINER_READERS_H
+
+#include <dfs/EnumContainers.h>
+#include <dfs/ItemReader.h>
+
+#include <cstring>
+
+namespace dfs {
+
+/**
+ * Reader for EnumArray.
+ *
+ * It accepts StaticArray with an index enum and the extent of \p E. When the
+ * items are integers with the same size as \p T, the array is copied as a
+ * single block instead of decoding each item.
+ *
+ * \ingroup readers
+ */
+template <CountedEnum E, typename T>
+class ItemReader<EnumArray<E, T>>
+{
+	using array_type = typename EnumArray<E, T>::array_type;
+	static constexpr bool raw_copyable = integral_like<T>::value && std::is_trivially_copyable_v<T>;
+	ItemReader<array_type> _array_reader;
+	bool _raw_copy;
+
+public:
+	using output_type = EnumArray<E, T>;
+
+	ItemReader(ReaderFactory &factory, AnyTypeRef type):
+		_array_reader(factory, check_type(type)),
+		_raw_copy(false)
+	{
+		if constexpr (raw_copyable) {
+			// integers are stored in the host byte order (little endian)
+			ItemReader<T> item_reader(factory, type.get<StaticArray>().itemType());
+			_raw_copy = item_reader.size() == sizeof(T);
+		}
+	}
+
+	std::size_t size() const {
+		return _array_reader.size();
+	}
+
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, EnumArray<E, T> &out) const
+	{
+		if constexpr (raw_copyable) {
+			if (_raw_copy) {
+				std::memcpy(out.data(), data.data.data(), sizeof(array_type));
+				co_return std::error_code{};
+			}
+		}
+		co_return co_await _array_reader(session, data, out);
+	}
+
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const
+	{
+		if constexpr (PrefetchableReader<ItemReader<array_type>>)
+			co_await _array_reader.prefetch(session, data, prefetcher);
+	}
+
+private:
+	// The raw copy relies on the extent being the enum count
+	static AnyTypeRef check_type(AnyTypeRef type)
+	{
+		auto array = type.get_if<StaticArray>();
+		if (!array)
+			throw TypeError(type, typeid(output_type), "not a static array");
+		if (!array->index_enum)
+			throw TypeError(type, typeid(output_type), "array is not indexed by an enum");
+		if (array->extent != enum_count_v<E>)
+			throw TypeError(type, typeid(output_type), std::format("array extent {} is not the enum count {}",
+					array->extent, enum_count_v<E>));
+		return type;
+	}
+};
+
+/**
+ * Reader for EnumBitset.
+ *
+ * It accepts DFContainer::DFFlagArray container types. The flag bytes are
+ * read directly into the bitset words, extra bytes are ignored and missing
+ * bytes are cleared.
+ *
+ * \ingroup readers
+ */
+template <CountedEnum E>
+class ItemReader<EnumBitset<E>>
+{
+	std::size_t _size;
+	std::size_t _bits_offset, _size_offset;
+
+public:
+	using output_type = EnumBitset<E>;
+
+	ItemReader(ReaderFactory &factory, AnyTypeRef type):
+		_size(factory.layout.getTypeInfo(type).size)
+	{
+		auto container = type.get_if<DFContainer>();
+		if (!container || container->container_type != DFContainer::DFFlagArray)
+			throw TypeError(type, typeid(output_type), "incompatible container");
+		if (!container->index_enum)
+			throw TypeError(type, typeid(output_type), "flag array is not indexed by an enum");
+		const auto &layout = factory.layout.compound_layout.at(container->compound.get());
+		_bits_offset = layout.member_offsets.at(DFContainer::DFFlagArrayBits);
+		_size_offset = layout.member_offsets.at(DFContainer::DFFlagArraySize);
+	}
+
+	std::size_t size() const {
+		return _size;
+	}
+
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, EnumBitset<E> &out) const
+	{
+		uintptr_t addr = session.visit_abi([&](auto abi) { return abi.get_pointer(data.subview(_bits_offset)); });
+		uint32_t len = ABI::get_integer<uint32_t>(data.subview(_size_offset));
+		out.clear();
+		auto words = out.words();
+		// words are little endian like the flag bytes
+		auto bytes = std::span<uint8_t>(reinterpret_cast<uint8_t *>(words.data()), words.size_bytes());
+		bytes = bytes.first(std::min<std::size_t>(len, bytes.size()));
+		if (!bytes.empty()) {
+			if (auto err = co_await session.process().read({addr, bytes}))
+				co_return err;
+		}
+		// clear bits past the end of the enum
+		if constexpr (EnumBitset<E>::bit_count % EnumBitset<E>::word_bits != 0)
+			words.back() &= (uint64_t(1) << (EnumBitset<E>::bit_count % EnumBitset<E>::word_bits)) - 1;
+		co_return std::error_code{};
+	}
+};
+
+} // namespace dfs
+
+#endif
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_ENUM_CONTAINERS_H
+#define DFS_ENUM_CONTAINERS_H
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+
+namespace dfs {
+
+/**
+ * Number of values of the enum \p E (greatest value plus one).
+ *
+ * It is found from a `constexpr std::size_t dfs_enum_count(E)` function
+ * declared in the namespace of \p E (as done by `dfs-codegen` for generated
+ * enums), or it can be specialized.
+ *
+ * \ingroup readers
+ */
+template <typename E>
+struct enum_count {};
+
+template <typename E> requires requires { { dfs_enum_count(E{}) } -> std::convertible_to<std::size_t>; }
+struct enum_count<E>: std::integral_constant<std::size_t, dfs_enum_count(E{})> {};
+
+template <typename E>
+inline constexpr std::size_t enum_count_v = enum_count<E>::value;
+
+template <typename E>
+concept CountedEnum = std::is_enum_v<E> && requires {
+	{ enum_count<E>::value } -> std::convertible_to<std::size_t>;
+};
+
+/**
+ * Array of \p T indexed by the enum \p E.
+ *
+ * Its reader is in dfs/EnumContainerReaders.h.
+ *
+ * \sa "ItemReader< EnumArray< E, T > >"
+ *
+ * \ingroup readers
+ */
+template <CountedEnum E, typename T>
+struct EnumArray: std::array<T, enum_count_v<E>>
+{
+	using enum_type = E;
+	using array_type = std::array<T, enum_count_v<E>>;
+
+	using array_type::operator[];
+
+	constexpr T &operator[](E e) noexcept { return array_type::operator[](std::size_t(e)); }
+	constexpr const T &operator[](E e) const noexcept { return array_type::operator[](std::size_t(e)); }
+};
+
+/**
+ * Set of values of the enum \p E stored as a fixed-size bit set.
+ *
+ * Bits are stored in 64-bit words with the same bit order as DF flag arrays.
+ * Its reader is in dfs/EnumContainerReaders.h.
+ *
+ * \sa "ItemReader< EnumBitset< E > >"
+ *
+ * \ingroup readers
+ */
+template <CountedEnum E>
+class EnumBitset
+{
+public:
+	using enum_type = E;
+	using word_type = uint64_t;
+	static constexpr std::size_t word_bits = 64;
+	static constexpr std::size_t bit_count = enum_count_v<E>;
+	static constexpr std::size_t word_count = (bit_count + word_bits - 1) / word_bits;
+
+	static constexpr std::size_t size() noexcept { return bit_count; }
+
+	/**
+	 * \returns true if \p e is set, values outside of the enum range are
+	 * never set.
+	 */
+	constexpr bool test(E e) const noexcept {
+		auto i = std::size_t(e);
+		return i < bit_count && ((_words[i / word_bits] >> (i % word_bits)) & 1);
+	}
+
+	constexpr bool operator[](E e) const noexcept { return test(e); }
+
+	constexpr void set(E e, bool value = true) noexcept {
+		auto i = std::size_t(e);
+		auto mask = word_type(1) << (i % word_bits);
+		_words[i / word_bits] = (_words[i / word_bits] & ~mask) | (word_type(value) << (i % word_bits));
+	}
+
+	constexpr void reset(E e) noexcept { set(e, false); }
+	constexpr void clear() noexcept { _words = {}; }
+
+	constexpr std::size_t count() const noexcept {
+		std::size_t n = 0;
+		for (auto w: _words)
+			n += std::popcount(w);
+		return n;
+	}
+
+	constexpr bool any() const noexcept {
+		word_type acc = 0;
+		for (auto w: _words)
+			acc |= w;
+		return acc != 0;
+	}
+
+	constexpr bool none() const noexcept { return !any(); }
+
+	constexpr EnumBitset &operator&=(const EnumBitset &other) noexcept {
+		for (std::size_t i = 0; i < word_count; ++i)
+			_words[i] &= other._words[i];
+		return *this;
+	}
+
+	constexpr EnumBitset &operator|=(const EnumBitset &other) noexcept {
+		for (std::size_t i = 0; i < word_count; ++i)
+			_words[i] |= other._words[i];
+		return *this;
+	}
+
+	friend constexpr EnumBitset operator&(EnumBitset lhs, const EnumBitset &rhs) noexcept { return lhs &= rhs; }
+	friend constexpr EnumBitset operator|(EnumBitset lhs, const EnumBitset &rhs) noexcept { return lhs |= rhs; }
+	friend constexpr bool operator==(const EnumBitset &, const EnumBitset &) noexcept = default;
+
+	std::span<word_type, word_count> words() noexcept { return _words; }
+	std::span<const word_type, word_count> words() const noexcept { return _words; }
+
+private:
+	std::array<word_type, word_count> _words = {};
+};
+
+} // namespace dfs
+
+#endif
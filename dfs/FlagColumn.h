@@ -0,0 +1,189 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_FLAG_COLUMN_H
+#define DFS_FLAG_COLUMN_H
+
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+namespace dfs {
+
+namespace details {
+
+template <typename T>
+struct flag_word;
+
+template <std::integral T>
+struct flag_word<T>
+{
+	using type = std::make_unsigned_t<T>;
+};
+
+template <typename T> requires std::integral<typename T::underlying_type>
+struct flag_word<T>
+{
+	using type = std::make_unsigned_t<typename T::underlying_type>;
+};
+
+} // namespace details
+
+/**
+ * Integers or bitfields (as generated by `dfs-codegen`) that are stored as a
+ * single word.
+ */
+template <typename T>
+concept FlagType = requires { typename details::flag_word<T>::type; } &&
+		sizeof(T) == sizeof(typename details::flag_word<T>::type) &&
+		std::is_trivially_copyable_v<T>;
+
+/**
+ * Predicate on flag words: every bit from \ref all must be set, no bit from
+ * \ref none may be set and, if \ref any is not zero, at least one of its bits
+ * must be set.
+ *
+ * Masks can be built with the `mask` function of generated bitfields.
+ *
+ * \ingroup readers
+ */
+template <FlagType T>
+struct FlagPredicate
+{
+	using word_type = typename details::flag_word<T>::type;
+
+	word_type any = 0;
+	word_type all = 0;
+	word_type none = 0;
+
+	constexpr bool test(word_type word) const noexcept {
+		return (((word & any) != 0) | (any == 0)) &
+			((word & all) == all) &
+			((word & none) == 0);
+	}
+
+	constexpr bool operator()(const T &value) const noexcept {
+		return test(std::bit_cast<word_type>(value));
+	}
+};
+
+/**
+ * Flags of many objects stored as contiguous words.
+ *
+ * Predicates are evaluated over the whole column with branch-free loops over
+ * the packed words that compilers can vectorize. Results for several columns
+ * (e.g. different flag members of the same objects) can be combined with
+ * bitwise operations on the `uint8_t` selections.
+ *
+ * \sa Columns
+ *
+ * \ingroup readers
+ */
+template <FlagType T>
+class FlagColumn
+{
+public:
+	using value_type = T;
+	using word_type = typename details::flag_word<T>::type;
+	using predicate_type = FlagPredicate<T>;
+
+	FlagColumn() = default;
+
+	/**
+	 * Copies the words from \p values (e.g. a column from Columns).
+	 */
+	explicit FlagColumn(std::span<const T> values):
+		_words(values.size())
+	{
+		for (std::size_t i = 0; i < values.size(); ++i)
+			_words[i] = std::bit_cast<word_type>(values[i]);
+	}
+
+	std::size_t size() const noexcept { return _words.size(); }
+	bool empty() const noexcept { return _words.empty(); }
+
+	void reserve(std::size_t n) { _words.reserve(n); }
+	void clear() noexcept { _words.clear(); }
+	void push_back(const T &value) { _words.push_back(std::bit_cast<word_type>(value)); }
+
+	T operator[](std::size_t i) const noexcept { return std::bit_cast<T>(_words[i]); }
+
+	/**
+	 * \returns the packed words.
+	 */
+	std::span<const word_type> words() const noexcept { return _words; }
+
+	/**
+	 * Writes 1 in \p out for every row matching \p pred and 0 for the
+	 * others.
+	 *
+	 * \p out must have size() elements.
+	 */
+	void select(const predicate_type &pred, std::span<uint8_t> out) const noexcept
+	{
+		const word_type *words = _words.data();
+		const std::size_t n = _words.size();
+		for (std::size_t i = 0; i < n; ++i)
+			out[i] = pred.test(words[i]);
+	}
+
+	/**
+	 * \overload
+	 */
+	std::vector<uint8_t> select(const predicate_type &pred) const
+	{
+		std::vector<uint8_t> out(size());
+		select(pred, out);
+		return out;
+	}
+
+	/**
+	 * \returns the number of rows matching \p pred.
+	 */
+	std::size_t count(const predicate_type &pred) const noexcept
+	{
+		const word_type *words = _words.data();
+		const std::size_t n = _words.size();
+		std::size_t res = 0;
+		for (std::size_t i = 0; i < n; ++i)
+			res += pred.test(words[i]);
+		return res;
+	}
+
+	/**
+	 * \returns the indices of the rows matching \p pred.
+	 */
+	std::vector<std::size_t> find(const predicate_type &pred) const
+	{
+		std::vector<std::size_t> res;
+		for (std::size_t i = 0; i < _words.size(); ++i)
+			if (pred.test(_words[i]))
+				res.push_back(i);
+		return res;
+	}
+
+private:
+	std::vector<word_type> _words;
+};
+
+} // namespace dfs
+
+#endif
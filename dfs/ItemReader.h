@@ -95,13 +95,15 @@ public:
 	{
 		if (_size > sizeof(Int))
 			throw TypeError(type, typeid(Int), std::format("storage is too small ({}, must be at least {})", sizeof(Int), _size));
+		if (_size != 1 && _size != 2 && _size != 4 && _size != 8)
+			throw TypeError(type, typeid(Int), std::format("unsupported integer size {}", _size));
 	}
 
 	std::size_t size() const {
 		return _size;
 	}
 
-	cppcoro::task<> operator()(ReadSession &, MemoryView data, Int &out) const {
+	cppcoro::task<std::error_code> operator()(ReadSession &, MemoryView data, Int &out) const {
 		return (*this)(data, out);
 	}
 
@@ -115,30 +117,109 @@ public:
 		using type = U::underlying_type;
 	};
 
-	cppcoro::task<> operator()(MemoryView data, Int &out) const {
+	cppcoro::task<std::error_code> operator()(MemoryView data, Int &out) const {
+		out = decode(data);
+		co_return std::error_code{};
+	}
+
+	/**
+	 * Decodes the value synchronously.
+	 */
+	Int decode(MemoryView data) const {
+		return visit_integer_type([&]<std::integral T>(std::type_identity<T>) {
+			return decode_as<T>(data.data.data());
+		});
+	}
+
+	/**
+	 * Decodes \p count values stored every \p stride bytes from \p data
+	 * to \p out.
+	 *
+	 * The integer width and sign are chosen once for the whole loop.
+	 *
+	 * \returns the output iterator after the last value
+	 */
+	template <std::output_iterator<Int> It>
+	It decode_n(const uint8_t *data, std::size_t stride, std::size_t count, It out) const {
+		return visit_integer_type([&]<std::integral T>(std::type_identity<T>) {
+			for (std::size_t i = 0; i < count; ++i)
+				*out++ = decode_as<T>(data + i*stride);
+			return out;
+		});
+	}
+
+	/**
+	 * Converts the raw integer \p T read from \p data to \p Int.
+	 */
+	template <std::integral T>
+	static Int decode_as(const uint8_t *data) {
 		using out_int = cast_type<Int>::type;
+		return Int(static_cast<out_int>(ABI::get_integer<T>(data)));
+	}
+
+private:
+	/**
+	 * Calls \p f with `std::type_identity<T>` where \p T is the
+	 * integer type with the size and signedness of the DF type.
+	 */
+	template <typename F>
+	decltype(auto) visit_integer_type(F &&f) const {
 		if (_is_signed) {
 			switch (_size) {
-			case 1: out = static_cast<out_int>(ABI::get_integer<int8_t>(data)); break;
-			case 2: out = static_cast<out_int>(ABI::get_integer<int16_t>(data)); break;
-			case 4: out = static_cast<out_int>(ABI::get_integer<int32_t>(data)); break;
-			case 8: out = static_cast<out_int>(ABI::get_integer<int64_t>(data)); break;
-			default: throw std::system_error(ABIError::InvalidLength);
+			case 1: return f(std::type_identity<int8_t>{});
+			case 2: return f(std::type_identity<int16_t>{});
+			case 4: return f(std::type_identity<int32_t>{});
+			default: return f(std::type_identity<int64_t>{});
 			}
 		}
 		else {
 			switch (_size) {
-			case 1: out = static_cast<out_int>(ABI::get_integer<uint8_t>(data)); break;
-			case 2: out = static_cast<out_int>(ABI::get_integer<uint16_t>(data)); break;
-			case 4: out = static_cast<out_int>(ABI::get_integer<uint32_t>(data)); break;
-			case 8: out = static_cast<out_int>(ABI::get_integer<uint64_t>(data)); break;
-			default: throw std::system_error(ABIError::InvalidLength);
+			case 1: return f(std::type_identity<uint8_t>{});
+			case 2: return f(std::type_identity<uint16_t>{});
+			case 4: return f(std::type_identity<uint32_t>{});
+			default: return f(std::type_identity<uint64_t>{});
 			}
 		}
-		co_return;
 	}
 };
 
+/**
+ * A type whose ItemReader can decode a value synchronously from raw memory
+ * without reading any other memory.
+ */
+template <typename T>
+concept DecodableType = requires (const ItemReader<T> reader, const MemoryView data) {
+	{ reader.decode(data) } -> std::same_as<T>;
+};
+
+/**
+ * A DecodableType whose ItemReader can also decode several values with a
+ * single loop (`decode_n`, see ItemReader<Int>).
+ */
+template <typename T>
+concept BatchDecodableType = DecodableType<T> && requires (const ItemReader<T> reader, const uint8_t *data, T *out) {
+	reader.decode_n(data, std::size_t{}, std::size_t{}, out);
+};
+
+namespace details {
+
+/**
+ * Decodes the location of the characters of a std::string using \p abi (a
+ * StaticABI or DynamicABI), the string header is read from the process if it
+ * does not contain the length (copy-on-write strings).
+ */
+template <typename ABIType>
+cppcoro::task<ABI::string_info> read_string_info(ABIType abi, ReadSession &session, MemoryView data)
+{
+	if constexpr (requires { abi.decode_string(data); }) {
+		if (abi.can_decode_string())
+			co_return abi.decode_string(data);
+	}
+	co_return co_await abi.read_string_info(session.process(), data);
+}
+
+} // namespace details
+
 /**
  * Reader for `std::string`.
  *
@@ -179,23 +260,66 @@ public:
 		return _size;
 	}
 
-	cppcoro::task<> operator()(ReadSession &session, MemoryView data, std::string &out) const
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, std::string &out) const
 	{
 		switch (_primitive_type.type) {
+		case PrimitiveType::StdString:
+			return session.visit_abi([&](auto abi) {
+				return read_std_string(abi, session, data, out);
+			});
 		case PrimitiveType::PtrString:
-			throw std::system_error(ItemReaderError::NotImplemented);
-		case PrimitiveType::StdString: {
-			auto ret = co_await session.abi().read_string(session.process(), data);
-			if (ret.err)
-				throw std::system_error(ret.err);
-			out = std::move(ret.str);
-			break;
-		}
 		default:
-			throw std::system_error(ItemReaderError::NotImplemented);
+			return details::error_task(ItemReaderError::NotImplemented);
+		}
+	}
+
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const
+	{
+		if (_primitive_type.type != PrimitiveType::StdString)
+			co_return;
+		auto info = co_await session.visit_abi([&](auto abi) {
+			return details::read_string_info(abi, session, data);
+		});
+		if (info.err)
+			co_return;
+		// Short strings are stored in the object itself
+		if (!ABI::is_local_string(info, data))
+			prefetcher.add(info.data, info.size);
+	}
+
+private:
+	template <typename ABIType>
+	static cppcoro::task<std::error_code> read_std_string(ABIType abi, ReadSession &session, MemoryView data, std::string &out)
+	{
+		if constexpr (requires { abi.decode_string(data); }) {
+			if (abi.can_decode_string())
+				co_return co_await read_chars(session, data, abi.decode_string(data), out);
 		}
+		// copy-on-write strings
+		auto ret = co_await abi.read_string(session.process(), data);
+		if (ret.err)
+			co_return ret.err;
+		out = std::move(ret.str);
+		co_return std::error_code{};
+	}
+
+	static cppcoro::task<std::error_code> read_chars(ReadSession &session, MemoryView data, ABI::string_info info, std::string &out)
+	{
+		if (info.err)
+			co_return info.err;
+		if (ABI::is_local_string(info, data)) {
+			auto chars = data.subview(info.data - data.address, info.size);
+			out.assign(reinterpret_cast<const char *>(chars.data.data()), info.size);
+			co_return std::error_code{};
+		}
+		std::string str(info.size, '\0');
+		if (auto err = co_await session.process().read({info.data, {reinterpret_cast<uint8_t *>(str.data()), info.size}}))
+			co_return err;
+		out = std::move(str);
+		co_return std::error_code{};
 	}
 };
+
 /**
  * Reader for bit vectors.
  *
@@ -248,50 +372,60 @@ public:
 		return _size;
 	}
 
-	cppcoro::task<> operator()(ReadSession &session, MemoryView data, std::vector<bool> &out) const
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, std::vector<bool> &out) const
 	{
 		return _container.visit(overloaded{
-			[&, this](const PrimitiveType &primitive_type) -> cppcoro::task<> {
+			[&, this](const PrimitiveType &primitive_type) -> cppcoro::task<std::error_code> {
 				switch (primitive_type.type) {
 				case PrimitiveType::StdBitVector:
 					// TODO
 				default:
-					throw std::system_error(ItemReaderError::NotImplemented);
+					return details::error_task(ItemReaderError::NotImplemented);
 				}
 			},
-			[&, this](const DFContainer &container) -> cppcoro::task<> {
+			[&, this](const DFContainer &container) -> cppcoro::task<std::error_code> {
 				switch (container.container_type) {
 				case DFContainer::DFFlagArray:
 					return read_df_flagarray(session, data, out);
 				default:
 					// unreachable
-					throw std::system_error(ItemReaderError::NotImplemented);
+					return details::error_task(ItemReaderError::NotImplemented);
 				}
 			},
-			[&](const AbstractType &) -> cppcoro::task<> {
+			[&](const AbstractType &) -> cppcoro::task<std::error_code> {
 				// unreachable
-				throw std::system_error(ItemReaderError::NotImplemented);
+				return details::error_task(ItemReaderError::NotImplemented);
 			}
 		});
 	}
 
 private:
-	cppcoro::task<> read_df_flagarray(ReadSession &session, MemoryView data, std::vector<bool> &out) const
+	cppcoro::task<std::error_code> read_df_flagarray(ReadSession &session, MemoryView data, std::vector<bool> &out) const
 	{
 		auto bits_offset = _compound_layout->member_offsets.at(DFContainer::DFFlagArrayBits);
 		auto size_offset = _compound_layout->member_offsets.at(DFContainer::DFFlagArraySize);
-		uintptr_t addr = session.abi().get_pointer(data.subview(bits_offset));
-		uint32_t len = session.abi().get_integer<uint32_t>(data.subview(size_offset));
+		uintptr_t addr = session.visit_abi([&](auto abi) { return abi.get_pointer(data.subview(bits_offset)); });
+		uint32_t len = ABI::get_integer<uint32_t>(data.subview(size_offset));
 		MemoryBuffer flagdata(addr, len);
 		if (auto err = co_await session.process().read(flagdata))
-			throw std::system_error(err);
+			co_return err;
 		out.resize(len*8);
 		for (unsigned int i = 0; i < len*8; ++i)
 			out[i] = bool(flagdata[i/8] & (1<<(i%8)));
+		co_return std::error_code{};
 	}
 };
 
 
+/**
+ * An item reader for pointers that can read the pointed object from an
+ * already decoded address (see ItemReader<Ptr>).
+ */
+template <typename Reader>
+concept PointerItemReader = requires (const Reader reader, ReadSession &session, uintptr_t addr, typename Reader::output_type &out) {
+	{ reader.read_pointee(session, addr, out) } -> std::same_as<cppcoro::task<std::error_code>>;
+};
+
 /**
  * Reader for stl-style containers (except std::vector<bool>).
  *
@@ -360,51 +494,111 @@ public:
 		return _size;
 	}
 
+	/**
+	 * Reads the container.
+	 *
+	 * The container header and the items are decoded by code
+	 * instantiated for the ABI of the session (see ReaderFactory::visit_abi).
+	 */
 	template <std::ranges::sized_range... Args> requires ReadableType<value_type, std::ranges::range_value_t<Args>...>
-	cppcoro::task<> operator()(ReadSession &session, MemoryView data, Container &out, Args &&...args) const
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, Container &out, Args &&...args) const
 	{
-		return _container_type.visit(overloaded{
-			[&, this](const StdContainer &container) -> cppcoro::task<> {
-				switch (container.container_type) {
-				case StdContainer::StdVector:
-					return read_std_vector(session, data, out, std::forward<Args>(args)...);
-				default:
-					// unreachable
-					throw std::system_error(ItemReaderError::NotImplemented);
-				}
-			},
-			[&, this](const DFContainer &container) -> cppcoro::task<> {
-				switch (container.container_type) {
-				case DFContainer::DFArray:
-					return read_df_array(session, data, out, std::forward<Args>(args)...);
-				case DFContainer::DFLinkedList:
-					return read_df_linkedlist(session, data, out, std::forward<Args>(args)...);
-				default:
+		return session.visit_abi([&, this](auto abi) {
+			return _container_type.visit(overloaded{
+				[&, this](const StdContainer &container) -> cppcoro::task<std::error_code> {
+					switch (container.container_type) {
+					case StdContainer::StdVector:
+						return read_std_vector(abi, session, data, out, std::forward<Args>(args)...);
+					default:
+						// unreachable
+						return details::error_task(ItemReaderError::NotImplemented);
+					}
+				},
+				[&, this](const DFContainer &container) -> cppcoro::task<std::error_code> {
+					switch (container.container_type) {
+					case DFContainer::DFArray:
+						return read_df_array(abi, session, data, out, std::forward<Args>(args)...);
+					case DFContainer::DFLinkedList:
+						return read_df_linkedlist(abi, session, data, out, std::forward<Args>(args)...);
+					default:
+						// unreachable
+						return details::error_task(ItemReaderError::NotImplemented);
+					}
+				},
+				[&](const AbstractType &) -> cppcoro::task<std::error_code> {
 					// unreachable
-					throw std::system_error(ItemReaderError::NotImplemented);
+					return details::error_task(ItemReaderError::NotImplemented);
 				}
-			},
-			[&](const AbstractType &) -> cppcoro::task<> {
-				// unreachable
-				throw std::system_error(ItemReaderError::NotImplemented);
-			}
+			});
 		});
 	}
 
+	/**
+	 * Adds the items of vectors and DF arrays to \p prefetcher. Linked
+	 * lists are not supported as each node depends on the previous one.
+	 */
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const
+	{
+		if (auto container = _container_type.get_if<StdContainer>()) {
+			if (container->container_type != StdContainer::StdVector)
+				co_return;
+			auto vec_info = session.visit_abi([&](auto abi) { return abi.decode_vector(data, _item_info); });
+			if (!vec_info.err)
+				prefetcher.add_array(vec_info.data, vec_info.size, _item_info.size, _item_reader);
+		}
+		else if (auto container = _container_type.get_if<DFContainer>()) {
+			if (container->container_type != DFContainer::DFArray)
+				co_return;
+			auto array_info = session.visit_abi([&](auto abi) { return decode_df_array(abi, data); });
+			prefetcher.add_array(array_info.data, array_info.size, _item_info.size, _item_reader);
+		}
+	}
+
 private:
-	template <typename... Args>
-	cppcoro::task<> read_contiguous_data(ReadSession &session, uintptr_t addr, std::size_t len, Container &out, Args &&...args) const
+	template <typename ABIType>
+	ABI::vector_info decode_df_array(ABIType abi, MemoryView data) const
+	{
+		return abi.decode_df_array(data,
+				_compound_layout->member_offsets[DFContainer::DFArrayData],
+				_compound_layout->member_offsets[DFContainer::DFArraySize]);
+	}
+
+	template <typename ABIType, typename... Args>
+	cppcoro::task<std::error_code> read_contiguous_data(ABIType abi, ReadSession &session, uintptr_t addr, std::size_t len, Container &out, Args &&...args) const
 	{
 		using std::size, std::begin;
 		if (len == 0)
-			co_return;
+			co_return std::error_code{};
 		MemoryBuffer item_data(addr, len * _item_info.size);
 		if (auto err = co_await session.process().read(item_data))
-			throw std::system_error(err);
+			co_return err;
 		out.resize(len);
 		if (!((size(args) == len) && ...))
-			throw std::runtime_error("extra args size does not match container size");
-		std::vector<cppcoro::task<>> tasks;
+			co_return ItemReaderError::SizeMismatch;
+		if constexpr (BatchDecodableType<value_type> && sizeof...(Args) == 0) {
+			// The integer type is chosen once for all items
+			_item_reader.decode_n(item_data.data(), _item_info.size, len, begin(out));
+			co_return std::error_code{};
+		}
+		else if constexpr (DecodableType<value_type> && sizeof...(Args) == 0) {
+			// No need for a coroutine per item
+			auto it = begin(out);
+			for (std::size_t i = 0; i < len; ++i)
+				*it++ = _item_reader.decode(item_data.view(i*_item_info.size, _item_info.size));
+			co_return std::error_code{};
+		}
+		else if constexpr (PointerItemReader<ItemReader<value_type>> && sizeof...(Args) == 0) {
+			// Decode the pointers with the pointer size of the ABI
+			std::vector<cppcoro::task<std::error_code>> tasks;
+			tasks.reserve(len);
+			auto it = begin(out);
+			for (std::size_t i = 0; i < len; ++i)
+				tasks.push_back(_item_reader.read_pointee(session,
+						abi.get_pointer(item_data.data() + i*abi.pointer_size),
+						*it++));
+			co_return co_await details::when_all_errors(std::move(tasks));
+		}
+		std::vector<cppcoro::task<std::error_code>> tasks;
 		tasks.reserve(len);
 		[&, this](auto out, auto... args) {
 			for (std::size_t i = 0; i < len; ++i)
@@ -413,45 +607,42 @@ private:
 					     *out++,
 					     *args++...));
 		}(begin(out), begin(std::forward<Args>(args))...);
-		co_await cppcoro::when_all(std::move(tasks));
+		co_return co_await details::when_all_errors(std::move(tasks));
 	}
 
-	template <typename... Args>
-	cppcoro::task<> read_std_vector(ReadSession &session, MemoryView data, Container &out, Args &&...args) const
+	template <typename ABIType, typename... Args>
+	cppcoro::task<std::error_code> read_std_vector(ABIType abi, ReadSession &session, MemoryView data, Container &out, Args &&...args) const
 	{
-		auto vec_info = co_await session.abi().read_vector(session.process(), data, _item_info);
+		auto vec_info = abi.decode_vector(data, _item_info);
 		if (vec_info.err)
-			throw std::system_error(vec_info.err);
-		co_await read_contiguous_data(session, vec_info.data, vec_info.size, out, std::forward<Args>(args)...);
+			co_return vec_info.err;
+		co_return co_await read_contiguous_data(abi, session, vec_info.data, vec_info.size, out, std::forward<Args>(args)...);
 	}
 
-	template <typename... Args>
-	cppcoro::task<> read_df_array(ReadSession &session, MemoryView data, Container &out, Args &&...args) const
+	template <typename ABIType, typename... Args>
+	cppcoro::task<std::error_code> read_df_array(ABIType abi, ReadSession &session, MemoryView data, Container &out, Args &&...args) const
 	{
-		auto data_offset = _compound_layout->member_offsets.at(DFContainer::DFArrayData);
-		auto size_offset = _compound_layout->member_offsets.at(DFContainer::DFArraySize);
-		uintptr_t addr = session.abi().get_pointer(data.subview(data_offset));
-		uint16_t len = session.abi().get_integer<uint32_t>(data.subview(size_offset));
-		co_await read_contiguous_data(session, addr, len, out, std::forward<Args>(args)...);
+		auto array_info = decode_df_array(abi, data);
+		co_return co_await read_contiguous_data(abi, session, array_info.data, array_info.size, out, std::forward<Args>(args)...);
 	}
 
-	template <typename... Args>
-	cppcoro::task<> read_df_linkedlist(ReadSession &session, MemoryView data, Container &out, Args &&...args) const
+	template <typename ABIType, typename... Args>
+	cppcoro::task<std::error_code> read_df_linkedlist(ABIType abi, ReadSession &session, MemoryView data, Container &out, Args &&...args) const
 	{
 		using std::size, std::begin;
 		auto item_offset = _compound_layout->member_offsets.at(DFContainer::DFLinkedListItem);
 		auto next_offset = _compound_layout->member_offsets.at(DFContainer::DFLinkedListNext);
 		std::vector<MemoryBuffer> nodes;
-		while (uintptr_t next_addr = session.abi().get_pointer(data.subview(next_offset))) {
+		while (uintptr_t next_addr = abi.get_pointer(data.subview(next_offset))) {
 			auto &next_node = nodes.emplace_back(next_addr, _size);
 			if (auto err = co_await session.process().read(next_node))
-				throw std::system_error(err);
+				co_return err;
 			data = next_node;
 		}
 		out.resize(nodes.size());
 		if (!((size(args) == nodes.size()) && ...))
-			throw std::runtime_error("extra args size does not match container size");
-		std::vector<cppcoro::task<>> item_tasks;
+			co_return ItemReaderError::SizeMismatch;
+		std::vector<cppcoro::task<std::error_code>> item_tasks;
 		[&, this](auto out, auto... args) {
 			for (std::size_t i = 0; i < nodes.size(); ++i)
 				item_tasks.push_back(_item_reader(session,
@@ -459,7 +650,7 @@ private:
 						*out++,
 						*args++...));
 		}(begin(out), begin(std::forward<Args>(args))...);
-		co_await cppcoro::when_all(std::move(item_tasks));
+		co_return co_await details::when_all_errors(std::move(item_tasks));
 	}
 };
 
@@ -501,13 +692,30 @@ public:
 		return _item_info.size * N;
 	}
 
-	cppcoro::task<> operator()(ReadSession &session, MemoryView data, std::array<T, N> &out) const
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, std::array<T, N> &out) const
 	{
-		std::vector<cppcoro::task<>> tasks;
-		tasks.reserve(N);
-		for (std::size_t i = 0; i < N; ++i)
-			tasks.push_back(_item_reader(session, data.subview(i*_item_info.size, _item_info.size), out[i]));
-		co_await cppcoro::when_all(std::move(tasks));
+		if constexpr (BatchDecodableType<T>) {
+			_item_reader.decode_n(data.data.data(), _item_info.size, N, out.begin());
+			co_return std::error_code{};
+		}
+		else {
+			std::vector<cppcoro::task<std::error_code>> tasks;
+			tasks.reserve(N);
+			for (std::size_t i = 0; i < N; ++i)
+				tasks.push_back(_item_reader(session, data.subview(i*_item_info.size, _item_info.size), out[i]));
+			co_return co_await details::when_all_errors(std::move(tasks));
+		}
+	}
+
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const
+	{
+		if constexpr (PrefetchableReader<ItemReader<T>>) {
+			std::vector<cppcoro::task<>> tasks;
+			tasks.reserve(N);
+			for (std::size_t i = 0; i < N; ++i)
+				tasks.push_back(_item_reader.prefetch(session, data.subview(i*_item_info.size, _item_info.size), prefetcher));
+			co_await cppcoro::when_all(std::move(tasks));
+		}
 	}
 };
 
@@ -540,10 +748,23 @@ public:
 		return _compound_reader->info.size;
 	}
 
+	/**
+	 * The compound reader used for reading \p Struct.
+	 */
+	const compound_reader_type_t<Struct> *compound_reader() const {
+		return _compound_reader;
+	}
+
 	template <typename... Args> requires CompoundReaderWithArgs<compound_reader_type_t<Struct>, Args...>
-	cppcoro::task<> operator()(ReadSession &session, MemoryView data, Struct &out, Args &&...args) const
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, Struct &out, Args &&...args) const
+	{
+		co_return co_await _compound_reader->read(session, data, out, std::forward<Args>(args)...);
+	}
+
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const
 	{
-		co_await _compound_reader->read(session, data, out, std::forward<Args>(args)...);
+		if constexpr (PrefetchableReader<compound_reader_type_t<Struct>>)
+			co_await _compound_reader->prefetch(session, data, prefetcher);
 	}
 };
 
@@ -609,20 +830,20 @@ public:
 		return _size;
 	}
 
-	cppcoro::task<> operator()(ReadSession &session, MemoryView data, output_type &out, std::size_t discriminator) const
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, output_type &out, std::size_t discriminator) const
 	{
 		if (auto res = selectAlternative(
 				[&]<std::size_t I>(index_constant<I>){ return I == discriminator; },
-				[&]<std::size_t I>(index_constant<I>) -> cppcoro::task<> {
-					if (auto reader = get<I>(_readers))
+				[&]<std::size_t I>(index_constant<I>) -> cppcoro::task<std::error_code> {
+					if (const auto &reader = get<I>(_readers))
 						return (*reader)(session, data, out.template emplace<I+index_offset>());
-					return {};
+					// the reader failed to initialize
+					return details::error_task(ItemReaderError::TypeMismatch);
 				},
 				std::make_index_sequence<alternative_count>{}))
-			co_await *res;
-		else
-			out = {};
-
+			co_return co_await *res;
+		out = {};
+		co_return std::error_code{};
 	}
 };
 
@@ -645,29 +866,36 @@ public:
 
 	virtual ~PointerReader() = default;
 
-	virtual cppcoro::task<std::unique_ptr<T>> make_unique(ReadSession &session, uintptr_t addr) const = 0;
-	virtual cppcoro::task<std::shared_ptr<T>> make_shared(ReadSession &session, uintptr_t addr) const = 0;
+	virtual cppcoro::task<std::error_code> make_unique(ReadSession &session, uintptr_t addr, std::unique_ptr<T> &out) const = 0;
+	virtual cppcoro::task<std::error_code> make_shared(ReadSession &session, uintptr_t addr, std::shared_ptr<T> &out) const = 0;
+	virtual void prefetch(ReadSession &session, uintptr_t addr, Prefetcher &prefetcher) const = 0;
 
 protected:
 	const PointerType &pointer;
 
 	template <typename Base>
-	cppcoro::task<std::shared_ptr<T>> make_shared_impl(ReadSession &session, uintptr_t addr) const
+	cppcoro::task<std::error_code> make_shared_impl(ReadSession &session, uintptr_t addr, std::shared_ptr<T> &out) const
 	{
 		auto object_factory = [this](ReadSession &session, uintptr_t addr) {
 			return [](const PointerReader<T> &self, ReadSession &session, uintptr_t addr)
-				-> cppcoro::shared_task<std::shared_ptr<void>> {
-					co_return co_await self.make_unique(session, addr);
+				-> cppcoro::shared_task<ReadSession::shared_object> {
+					std::unique_ptr<T> ptr;
+					auto err = co_await self.make_unique(session, addr, ptr);
+					co_return ReadSession::shared_object{std::move(ptr), err};
 			}(*this, session, addr);
 		};
 		if (addr == 0) {
-			co_return nullptr;
+			out = nullptr;
+			co_return std::error_code{};
 		}
 		else {
-			auto ptr = co_await session.getSharedObject<Base>(addr, object_factory);
-			co_return static_pointer_cast<T>(std::move(ptr));
+			// copy the result, the task may be a temporary (type mismatch)
+			auto res = co_await session.getSharedObject<Base>(addr, object_factory);
+			if (res.err)
+				co_return res.err;
+			out = static_pointer_cast<T>(res.ptr);
+			co_return std::error_code{};
 		}
-
 	}
 };
 
@@ -687,21 +915,30 @@ public:
 
 	~StaticPointerReader() override = default;
 
-	cppcoro::task<std::unique_ptr<T>> make_unique(ReadSession &session, uintptr_t addr) const override
+	cppcoro::task<std::error_code> make_unique(ReadSession &session, uintptr_t addr, std::unique_ptr<T> &out) const override
 	{
-		if (addr == 0)
-			co_return nullptr;
+		if (addr == 0) {
+			out = nullptr;
+			co_return std::error_code{};
+		}
 		MemoryBuffer item_data(addr, _item_info.size);
 		if (auto err = co_await session.process().read(item_data))
-			throw std::system_error(err);
+			co_return err;
 		auto res = std::make_unique<T>();
-		co_await _item_reader(session, item_data, *res);
-		co_return res;
+		if (auto err = co_await _item_reader(session, item_data, *res))
+			co_return err;
+		out = std::move(res);
+		co_return std::error_code{};
 	}
 
-	cppcoro::task<std::shared_ptr<T>> make_shared(ReadSession &session, uintptr_t addr) const override
+	cppcoro::task<std::error_code> make_shared(ReadSession &session, uintptr_t addr, std::shared_ptr<T> &out) const override
 	{
-		return PointerReader<T>::template make_shared_impl<T>(session, addr);
+		return PointerReader<T>::template make_shared_impl<T>(session, addr, out);
+	}
+
+	void prefetch(ReadSession &, uintptr_t addr, Prefetcher &prefetcher) const override
+	{
+		prefetcher.add(addr, _item_info.size, _item_reader);
 	}
 };
 
@@ -721,24 +958,36 @@ public:
 
 	~PolymorphicPointerReader() override = default;
 
-	cppcoro::task<std::unique_ptr<T>> make_unique(ReadSession &session, uintptr_t addr) const override
+	cppcoro::task<std::error_code> make_unique(ReadSession &session, uintptr_t addr, std::unique_ptr<T> &out) const override
 	{
-		if (addr == 0)
-			co_return nullptr;
-		auto ptr = co_await _polymorphic_reader->read(session, addr);
+		if (addr == 0) {
+			out = nullptr;
+			co_return std::error_code{};
+		}
+		std::unique_ptr<base> ptr;
+		if (auto err = co_await _polymorphic_reader->read(session, addr, ptr))
+			co_return err;
 		if constexpr (std::is_same_v<T, base>) {
-			co_return ptr;
+			out = std::move(ptr);
 		}
 		else {
-			if (dynamic_cast<T *>(ptr.get()))
-				co_return std::unique_ptr<T>(static_cast<T *>(ptr.release()));
-			throw std::system_error(ItemReaderError::CastError);
+			if (!dynamic_cast<T *>(ptr.get()))
+				co_return ItemReaderError::CastError;
+			out.reset(static_cast<T *>(ptr.release()));
 		}
+		co_return std::error_code{};
 	}
 
-	cppcoro::task<std::shared_ptr<T>> make_shared(ReadSession &session, uintptr_t addr) const override
+	cppcoro::task<std::error_code> make_shared(ReadSession &session, uintptr_t addr, std::shared_ptr<T> &out) const override
 	{
-		return PointerReader<T>::template make_shared_impl<base>(session, addr);
+		return PointerReader<T>::template make_shared_impl<base>(session, addr, out);
+	}
+
+	void prefetch(ReadSession &session, uintptr_t addr, Prefetcher &prefetcher) const override
+	{
+		// The actual type is unknown until the vtable is read, only
+		// prefetch the vtable pointer.
+		prefetcher.add(addr, session.abi().pointer.size);
 	}
 };
 
@@ -796,10 +1045,27 @@ public:
 		return _size;
 	}
 
-	cppcoro::task<> operator()(ReadSession &session, MemoryView data, Ptr &out) const
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, Ptr &out) const
 	{
-		auto addr = session.abi().get_pointer(data);
-		out = co_await ((*_reader).*traits::make_pointer)(session, addr);
+		auto addr = session.visit_abi([&](auto abi) { return abi.get_pointer(data); });
+		return read_pointee(session, addr, out);
+	}
+
+	/**
+	 * Reads the object at \p addr, the already decoded value of the
+	 * pointer (used by container readers decoding every pointer in a
+	 * single loop).
+	 */
+	cppcoro::task<std::error_code> read_pointee(ReadSession &session, uintptr_t addr, Ptr &out) const
+	{
+		return ((*_reader).*traits::make_pointer)(session, addr, out);
+	}
+
+	cppcoro::task<> prefetch(ReadSession &session, MemoryView data, Prefetcher &prefetcher) const
+	{
+		auto addr = session.visit_abi([&](auto abi) { return abi.get_pointer(data); });
+		_reader->prefetch(session, addr, prefetcher);
+		co_return;
 	}
 };
 
@@ -20,8 +20,14 @@
 
 extern "C" {
 #include <openssl/evp.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 }
 
+#include <cstdlib>
+#include <format>
 #include <fstream>
 
 #include "linux/proc_utils.h"
@@ -30,28 +36,104 @@ using namespace dfs;
 
 LinuxProcess::LinuxProcess(int pid):
 	LinuxProcessCommon(pid),
+	_md5(executable_md5(proc::path(pid) / "exe")),
 	_base_offset(0)
 {
-	if (auto exe = std::ifstream(proc::path(pid) / "exe")) {
-		exe.exceptions(std::ios_base::badbit | std::ios_base::failbit);
-		std::vector<char> buffer(4096);
-		std::streamsize len;
-		std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>
-			md5_ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
-		if (!md5_ctx)
-			throw std::runtime_error("EVP_MD_CTX_new");
-		if (!EVP_DigestInit(md5_ctx.get(), EVP_md5()))
-			throw std::runtime_error("EVP_DigestInit");
-		while ((len = exe.readsome(buffer.data(), buffer.size())) > 0) {
-			if (!EVP_DigestUpdate(md5_ctx.get(), buffer.data(), len))
-				throw std::runtime_error("EVP_DigestUpdate");
+}
+
+static std::filesystem::path fingerprint_cache_dir()
+{
+	if (auto cache = std::getenv("XDG_CACHE_HOME"); cache && *cache)
+		return std::filesystem::path(cache) / "dfs" / "fingerprints";
+	if (auto home = std::getenv("HOME"); home && *home)
+		return std::filesystem::path(home) / ".cache" / "dfs" / "fingerprints";
+	return {};
+}
+
+static std::vector<uint8_t> md5_fd(int fd, std::size_t size)
+{
+	std::vector<uint8_t> md5(EVP_MD_size(EVP_md5()));
+	if (size > 0) {
+		if (void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); data != MAP_FAILED) {
+			madvise(data, size, MADV_SEQUENTIAL);
+			auto ok = EVP_Digest(data, size, md5.data(), nullptr, EVP_md5(), nullptr);
+			munmap(data, size);
+			if (!ok)
+				throw std::runtime_error("EVP_Digest");
+			return md5;
+		}
+	}
+	// mmap is not available, read the file with a large buffer
+	std::unique_ptr<EVP_MD_CTX, decltype(&EVP_MD_CTX_free)>
+		md5_ctx(EVP_MD_CTX_new(), EVP_MD_CTX_free);
+	if (!md5_ctx)
+		throw std::runtime_error("EVP_MD_CTX_new");
+	if (!EVP_DigestInit(md5_ctx.get(), EVP_md5()))
+		throw std::runtime_error("EVP_DigestInit");
+	std::vector<char> buffer(1 << 20);
+	while (true) {
+		auto len = ::read(fd, buffer.data(), buffer.size());
+		if (len == 0)
+			break;
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::system_category(), "read executable");
+		}
+		if (!EVP_DigestUpdate(md5_ctx.get(), buffer.data(), len))
+			throw std::runtime_error("EVP_DigestUpdate");
+	}
+	if (!EVP_DigestFinal(md5_ctx.get(), md5.data(), nullptr))
+		throw std::runtime_error("EVP_DigestFinal");
+	return md5;
+}
+
+std::vector<uint8_t> LinuxProcess::executable_md5(const std::filesystem::path &path)
+{
+	int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+	if (fd == -1)
+		throw std::system_error(errno, std::system_category(), "Failed to open executable");
+	std::unique_ptr<int, decltype([](int *fd) { close(*fd); })> fd_guard(&fd);
+	struct stat st;
+	if (-1 == fstat(fd, &st))
+		throw std::system_error(errno, std::system_category(), "Failed to stat executable");
+
+	std::filesystem::path cache_file;
+	if (auto cache_dir = fingerprint_cache_dir(); !cache_dir.empty())
+		cache_file = cache_dir / std::format("{:x}-{}-{}-{}.{:09}.md5",
+				st.st_dev, st.st_ino, st.st_size,
+				st.st_mtim.tv_sec, st.st_mtim.tv_nsec);
+
+	std::vector<uint8_t> md5(EVP_MD_size(EVP_md5()));
+	if (!cache_file.empty()) {
+		if (std::ifstream cached(cache_file, std::ios::binary); cached) {
+			cached.read(reinterpret_cast<char *>(md5.data()), md5.size());
+			if (cached.gcount() == std::streamsize(md5.size()) && cached.peek() == EOF)
+				return md5;
+		}
+	}
+
+	md5 = md5_fd(fd, st.st_size);
+
+	if (!cache_file.empty()) {
+		// Write to a temporary file and rename it, so that concurrent
+		// readers never see a partial entry.
+		std::error_code ec;
+		std::filesystem::create_directories(cache_file.parent_path(), ec);
+		auto tmp_file = cache_file;
+		tmp_file += std::format(".{}.tmp", getpid());
+		bool written = false;
+		if (std::ofstream out(tmp_file, std::ios::binary | std::ios::trunc); out) {
+			out.write(reinterpret_cast<const char *>(md5.data()), md5.size());
+			out.close();
+			written = !out.fail();
 		}
-		_md5.resize(EVP_MD_size(EVP_md5()));
-		if (!EVP_DigestFinal(md5_ctx.get(), _md5.data(), nullptr))
-			throw std::runtime_error("EVP_DigestFinal");
+		if (written)
+			std::filesystem::rename(tmp_file, cache_file, ec);
+		if (!written || ec)
+			std::filesystem::remove(tmp_file, ec);
 	}
-	else
-		throw std::runtime_error("Failed to open executable");
+	return md5;
 }
 
 std::span<const uint8_t> LinuxProcess::id() const
@@ -21,6 +21,7 @@
 
 #include <dfs/LinuxProcessCommon.h>
 
+#include <filesystem>
 #include <vector>
 
 namespace dfs {
@@ -34,6 +35,20 @@ public:
 	std::span<const uint8_t> id() const override;
 	intptr_t base_offset() const override;
 
+	/**
+	 * Computes the MD5 checksum identifying the executable \p path.
+	 *
+	 * Checksums are cached on disk in `$XDG_CACHE_HOME/dfs/fingerprints`
+	 * (or `~/.cache/dfs/fingerprints`), keyed by the device, inode, size
+	 * and modification time of the file. The cache is shared by all
+	 * programs using this library, the file is only hashed when it
+	 * changed. Cache errors are ignored.
+	 *
+	 * \throws std::system_error if the file cannot be read
+	 * \throws std::runtime_error if hashing fails
+	 */
+	static std::vector<uint8_t> executable_md5(const std::filesystem::path &path);
+
 private:
 	std::vector<uint8_t> _md5;
 	intptr_t _base_offset;
@@ -36,7 +36,8 @@ struct no_fallback {};	///< no fallback, throws an error
  * derived types that may be read.
  *
  * If a unknown type is read, \c PolymorphicReader will fall back to the base
- * type if it is not abstract, or a null pointer if it is, and log a warning.
+ * type if it is not abstract, or a null pointer if it is, and report an
+ * ItemReaderError::UnknownVTable error to the session.
  * The \p Base type may define a nested alias type `fallback` to \ref
  * fallback_nullptr, \ref fallback_base, or \ref no_fallback to suppress the
  * warning.
@@ -84,62 +85,63 @@ struct PolymorphicReader
 		}(std::index_sequence_for<Base, Ts...>{});
 	}
 
-	cppcoro::task<std::unique_ptr<Base>> read(ReadSession &session, uintptr_t addr) const
+	cppcoro::task<std::error_code> read(ReadSession &session, uintptr_t addr, std::unique_ptr<Base> &out) const
 	{
-		if (addr == 0)
-			co_return nullptr;
+		if (addr == 0) {
+			out = nullptr;
+			co_return std::error_code{};
+		}
 		uintptr_t vtable = 0;
 		if (auto err = co_await session.process().read({addr, {reinterpret_cast<uint8_t *>(&vtable), session.abi().pointer.size}}))
-			throw std::system_error(err);
+			co_return err;
 		vtable -= session.process().base_offset();
-		std::unique_ptr<Base> base_ptr;
-		auto read_type = [&]<std::size_t I>(index_constant<I>) -> cppcoro::task<> {
+		auto read_type = [&]<std::size_t I>(index_constant<I>) -> cppcoro::task<std::error_code> {
 			using T = std::tuple_element_t<I, std::tuple<Base, Ts...>>;
 			if constexpr (!std::is_abstract_v<T>) {
 				auto ptr = std::make_unique<T>();
 				auto size = get<I>(readers)->info.size;
 				MemoryBuffer data(addr, size);
 				if (auto err = co_await session.process().read(data))
-					throw std::system_error(err);
-				co_await get<I>(readers)->read(session, data, *ptr);
-				base_ptr = std::move(ptr);
+					co_return err;
+				if (auto err = co_await get<I>(readers)->read(session, data, *ptr))
+					co_return err;
+				out = std::move(ptr);
+				co_return std::error_code{};
 			}
 			else
-				throw std::runtime_error("trying to instantiate abstract type");
+				co_return ItemReaderError::AbstractType;
 		};
 		if (auto res = selectAlternative(
 				[&]<std::size_t I>(index_constant<I>) { return vtable == vtables[I]; },
 				read_type,
 				std::index_sequence_for<Base, Ts...>{})) {
-			co_await *res;
+			co_return co_await *res;
+		}
+		if constexpr (requires { typename Base::fallback; }) {
+			if constexpr (std::same_as<typename Base::fallback, fallback_nullptr>) {
+				out = nullptr;
+				co_return std::error_code{};
+			}
+			else if constexpr (std::same_as<typename Base::fallback, fallback_base>) {
+				static_assert(!std::is_abstract_v<Base>);
+				co_return co_await read_type(index_constant<0>{});
+			}
+			else if constexpr (std::same_as<typename Base::fallback, no_fallback>) {
+				co_return ItemReaderError::UnknownVTable;
+			}
+			else static_assert(requires (Base) { requires false; }, "unsupported fallback type");
 		}
 		else {
-			if constexpr (requires { typename Base::fallback; }) {
-				if constexpr (std::same_as<typename Base::fallback, fallback_nullptr>) {
-					// leave base_ptr empty
-				}
-				else if constexpr (std::same_as<typename Base::fallback, fallback_base>) {
-					static_assert(!std::is_abstract_v<Base>);
-					co_await read_type(index_constant<0>{});
-				}
-				else if constexpr (std::same_as<typename Base::fallback, no_fallback>) {
-					throw std::runtime_error("unknown vtable address");
-				}
-				else static_assert(requires (Base) { requires false; }, "unsupported fallback type");
+			// Fall back to the base type, or a null pointer if it is abstract
+			session.report_error(get<0>(readers)->type, "vtable", ItemReaderError::UnknownVTable, addr, vtable);
+			if constexpr (!std::is_abstract_v<Base>) {
+				co_return co_await read_type(index_constant<0>{});
 			}
 			else {
-				session.log(std::format("unknown vtable address for {}: {:x}", typeid(Base).name(), vtable));
-				if constexpr (!std::is_abstract_v<Base>) {
-					session.log(std::format("falling back to base type"));
-					co_await read_type(index_constant<0>{});
-				}
-				else {
-					session.log(std::format("falling back to null pointer"));
-					// leave base_ptr empty
-				}
+				out = nullptr;
+				co_return std::error_code{};
 			}
 		}
-		co_return base_ptr;
 	}
 };
 
@@ -37,6 +37,16 @@ cppcoro::task<std::error_code> Process::readv(std::span<const MemoryBufferRef> t
 	co_return std::error_code{};
 }
 
+cppcoro::task<std::error_code> Process::pin(uintptr_t address, std::size_t size, PinnedMemory &out)
+{
+	auto data = std::make_shared<uint8_t[]>(size);
+	MemoryBufferRef buffer = {address, {data.get(), size}};
+	if (auto err = co_await read(buffer))
+		co_return err;
+	out = PinnedMemory(std::move(data), buffer);
+	co_return std::error_code{};
+}
+
 void Process::sync(cppcoro::task<> &&task)
 {
 	cppcoro::sync_wait(std::move(task));
@@ -45,32 +55,42 @@ void Process::sync(cppcoro::task<> &&task)
 static constexpr std::size_t PageSize = 4096;
 
 ProcessCache::chunk_t::chunk_t(std::size_t len):
-	data(std::make_unique<uint8_t[]>(len)),
+	data(std::make_shared<uint8_t[]>(len)),
 	size(len)
 {
 }
 
-cppcoro::task<std::error_code> ProcessCache::read(MemoryBufferRef buffer)
+std::vector<ProcessCache::cache_t::iterator> ProcessCache::get_chunks(uintptr_t address, std::size_t size, const std::shared_ptr<read_batch> &batch)
 {
 	auto chunk_end = [](auto &chunk_pair){ return chunk_pair.first + chunk_pair.second.size; };
-	auto read_chunk = [this](auto hint, uintptr_t start_page, uintptr_t end_page)
-			-> decltype(_cache)::iterator {
+	auto read_chunk = [this, &batch](auto hint, uintptr_t start_page, uintptr_t end_page)
+			-> cache_t::iterator {
 		auto chunk_len = end_page-start_page;
 		auto it = _cache.emplace_hint(hint, start_page, chunk_len);
-		it->second.task = [](Process &p, MemoryBufferRef buffer) -> cppcoro::shared_task<std::error_code> {
-			co_return co_await p.read(buffer);
+		MemoryBufferRef buffer = {start_page, {it->second.data.get(), chunk_len}};
+		if (batch) {
+			batch->buffers.push_back(buffer);
+			it->second.task = [](std::shared_ptr<read_batch> batch, std::size_t index)
+					-> cppcoro::shared_task<std::error_code> {
+				co_return (co_await batch->task)[index];
+			}(batch, batch->buffers.size()-1);
+		}
+		else {
+			it->second.task = [](Process &p, MemoryBufferRef buffer) -> cppcoro::shared_task<std::error_code> {
+				co_return co_await p.read(buffer);
 
-		}(process(), {start_page, {it->second.data.get(), chunk_len}});
+			}(process(), buffer);
+		}
 		return it;
 	};
 
-	auto start_page = buffer.address & ~(static_cast<uintptr_t>(PageSize)-1);
-	auto end_page = ((buffer.address+buffer.data.size()-1) & ~(static_cast<uintptr_t>(PageSize)-1))+PageSize;
-	auto ub = _cache.upper_bound(buffer.address);
-	decltype(_cache)::iterator it;
-	std::vector<decltype(_cache)::iterator> chunks;
-	if (ub == _cache.begin() || chunk_end(*prev(ub)) <= buffer.address) {
-		if (ub != _cache.end() && buffer.address+buffer.data.size() > ub->first)
+	auto start_page = address & ~(static_cast<uintptr_t>(PageSize)-1);
+	auto end_page = ((address+size-1) & ~(static_cast<uintptr_t>(PageSize)-1))+PageSize;
+	auto ub = _cache.upper_bound(address);
+	cache_t::iterator it;
+	std::vector<cache_t::iterator> chunks;
+	if (ub == _cache.begin() || chunk_end(*prev(ub)) <= address) {
+		if (ub != _cache.end() && address+size > ub->first)
 			it = read_chunk(ub, start_page, ub->first);
 		else
 			it = read_chunk(ub, start_page, end_page);
@@ -91,6 +111,12 @@ cppcoro::task<std::error_code> ProcessCache::read(MemoryBufferRef buffer)
 		}
 		chunks.push_back(it);
 	}
+	return chunks;
+}
+
+cppcoro::task<std::error_code> ProcessCache::read(MemoryBufferRef buffer)
+{
+	auto chunks = get_chunks(buffer.address, buffer.data.size());
 	std::vector<cppcoro::shared_task<std::error_code>> tasks;
 	tasks.reserve(chunks.size());
 	for (auto chunk: chunks)
@@ -118,6 +144,47 @@ cppcoro::task<std::error_code> ProcessCache::read(MemoryBufferRef buffer)
 	co_return ret;
 }
 
+cppcoro::task<std::error_code> ProcessCache::readv(std::span<const MemoryBufferRef> tasks)
+{
+	auto batch = std::make_shared<read_batch>();
+	for (const auto &buffer: tasks)
+		if (!buffer.data.empty())
+			get_chunks(buffer.address, buffer.data.size(), batch);
+	if (!batch->buffers.empty()) {
+		batch->task = [](Process &p, std::vector<MemoryBufferRef> buffers)
+				-> cppcoro::shared_task<std::vector<std::error_code>> {
+			std::vector<std::error_code> res(buffers.size());
+			if (co_await p.readv(buffers)) {
+				// Find which chunks failed
+				for (std::size_t i = 0; i < buffers.size(); ++i)
+					res[i] = co_await p.read(buffers[i]);
+			}
+			co_return res;
+		}(process(), batch->buffers);
+	}
+	// All chunks are now in the cache, copy them with the single reads
+	co_return co_await Process::readv(tasks);
+}
+
+cppcoro::task<std::error_code> ProcessCache::pin(uintptr_t address, std::size_t size, PinnedMemory &out)
+{
+	if (size == 0) {
+		out = {};
+		co_return std::error_code{};
+	}
+	auto chunks = get_chunks(address, size);
+	if (chunks.size() != 1) // the block overlaps several chunks, it needs to be copied
+		co_return co_await Process::pin(address, size, out);
+	auto chunk_addr = chunks.front()->first;
+	auto data = chunks.front()->second.data;
+	auto task = chunks.front()->second.task;
+	if (auto err = co_await task)
+		co_return err;
+	MemoryView view = {address, {data.get()+(address-chunk_addr), size}};
+	out = PinnedMemory(std::move(data), view);
+	co_return std::error_code{};
+}
+
 ProcessVectorizer::ProcessVectorizer(std::unique_ptr<Process> &&process, std::size_t max_size):
 	ProcessWrapper(std::move(process)),
 	_max_total_size(max_size)
@@ -135,6 +135,53 @@ public:
 	}
 };
 
+/**
+ * A view over raw memory that shares the ownership of its storage.
+ *
+ * Unlike MemoryView, the data stays valid as long as the object (or any
+ * copy or sub-view) is alive, even after the storage was removed from a
+ * ProcessCache.
+ *
+ * \sa Process::pin
+ */
+class PinnedMemory
+{
+	std::shared_ptr<const uint8_t[]> _owner;
+	MemoryView _view = {};
+
+public:
+	PinnedMemory() = default;
+	/**
+	 * Constructs a view on \p view whose storage is kept alive by \p owner.
+	 */
+	PinnedMemory(std::shared_ptr<const uint8_t[]> owner, MemoryView view):
+		_owner(std::move(owner)),
+		_view(view)
+	{
+	}
+
+	uintptr_t address() const { return _view.address; }
+	std::span<const uint8_t> data() const { return _view.data; }
+	std::size_t size() const { return _view.data.size(); }
+	bool empty() const { return _view.data.empty(); }
+
+	operator MemoryView() const { return _view; }
+
+	/**
+	 * \returns a sub-view of \p length from \p offset sharing the same storage
+	 */
+	PinnedMemory subview(std::size_t offset, std::size_t length) const {
+		return {_owner, _view.subview(offset, length)};
+	}
+	/**
+	 * \returns a sub-view from \p offset to the end of this view sharing
+	 * the same storage
+	 */
+	PinnedMemory subview(std::size_t offset) const {
+		return {_owner, _view.subview(offset)};
+	}
+};
+
 /**
  * Interface for interacting with Dwarf Fortress processes.
  */
@@ -211,6 +258,20 @@ public:
 		return read_sync({address, {reinterpret_cast<uint8_t *>(&dest), sizeof(dest)}});
 	}
 
+	/**
+	 * Makes a block of memory available without copying it into a
+	 * caller-provided buffer.
+	 *
+	 * The default implementation reads the block in a newly allocated
+	 * buffer. Process types that already store the memory (e.g.
+	 * ProcessCache) may share their storage instead.
+	 *
+	 * \param[in] address address of the block
+	 * \param[in] size size of the block
+	 * \param[out] out view on the block data
+	 */
+	[[nodiscard]] virtual cppcoro::task<std::error_code> pin(uintptr_t address, std::size_t size, PinnedMemory &out);
+
 	/**
 	 * Wait for the reading task to finish.
 	 */
@@ -242,6 +303,13 @@ public:
 	std::error_code stop() override { return _p->stop(); }
 	std::error_code cont() override { return _p->cont(); }
 
+	/**
+	 * Forwards to the wrapped process, so that it can share its storage.
+	 */
+	[[nodiscard]] cppcoro::task<std::error_code> pin(uintptr_t address, std::size_t size, PinnedMemory &out) override {
+		return _p->pin(address, size, out);
+	}
+
 	void sync(cppcoro::task<> &&task) override { _p->sync(std::move(task)); }
 
 protected:
@@ -267,15 +335,43 @@ public:
 	std::error_code stop() override { _cache.clear(); return ProcessWrapper::stop(); }
 	std::error_code cont() override { _cache.clear(); return ProcessWrapper::cont(); }
 	[[nodiscard]] cppcoro::task<std::error_code> read(MemoryBufferRef buffer) override;
+	/**
+	 * Reads multiple blocks of memory.
+	 *
+	 * All the pages missing from the cache are read with a single
+	 * readv() call on the wrapped process.
+	 */
+	[[nodiscard]] cppcoro::task<std::error_code> readv(std::span<const MemoryBufferRef> tasks) override;
+	/**
+	 * Pins cached pages.
+	 *
+	 * If the block is contained in a single cached chunk, the chunk
+	 * storage is shared without copy. The chunk is kept alive by \p out
+	 * after the cache is cleared.
+	 */
+	[[nodiscard]] cppcoro::task<std::error_code> pin(uintptr_t address, std::size_t size, PinnedMemory &out) override;
 
 private:
 	struct chunk_t {
-		std::unique_ptr<uint8_t[]> data;
+		std::shared_ptr<uint8_t[]> data;
 		std::size_t size;
 		cppcoro::shared_task<std::error_code> task;
 		chunk_t(std::size_t);
 	};
-	std::map<uintptr_t, chunk_t> _cache;
+	using cache_t = std::map<uintptr_t, chunk_t>;
+	cache_t _cache;
+	struct read_batch {
+		std::vector<MemoryBufferRef> buffers;
+		cppcoro::shared_task<std::vector<std::error_code>> task;
+	};
+
+	/**
+	 * Find or create the chunks covering \p size bytes at \p address.
+	 *
+	 * If \p batch is not null, missing chunks are added to the batch
+	 * instead of being read individually.
+	 */
+	std::vector<cache_t::iterator> get_chunks(uintptr_t address, std::size_t size, const std::shared_ptr<read_batch> &batch = nullptr);
 };
 
 /**
@@ -0,0 +1,152 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ProcessDiscovery.h"
+
+#include "LinuxProcess.h"
+#include "WineProcess.h"
+
+extern "C" {
+#include <unistd.h>
+}
+
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "linux/proc_utils.h"
+
+using namespace dfs;
+
+static std::string read_comm(int pid)
+{
+	std::string comm;
+	if (std::ifstream file(proc::path(pid) / "comm"); file)
+		std::getline(file, comm);
+	return comm;
+}
+
+// Start time (in clock ticks since boot) from /proc/<pid>/stat, or 0 if the
+// process does not exist anymore.
+static unsigned long long read_start_time(int pid)
+{
+	std::string stat;
+	if (std::ifstream file(proc::path(pid) / "stat"); file)
+		std::getline(file, stat);
+	// comm (2nd field) is between parentheses and may contain spaces
+	auto comm_end = stat.rfind(')');
+	if (comm_end == std::string::npos)
+		return 0;
+	std::istringstream fields(stat.substr(comm_end + 1));
+	std::string field;
+	// starttime is the 22nd field, the 20th after comm
+	for (int i = 0; i < 20; ++i)
+		if (!(fields >> field))
+			return 0;
+	unsigned long long start_time = 0;
+	std::from_chars(field.data(), field.data() + field.size(), start_time);
+	return start_time;
+}
+
+ProcessDiscovery::ProcessDiscovery(const Structures &structures):
+	log([](std::string_view msg) { std::cerr << msg << std::endl; }),
+	_structures(structures)
+{
+}
+
+std::vector<ProcessDiscovery::Candidate> ProcessDiscovery::candidates() const
+{
+	std::vector<Candidate> res;
+	int self = getpid();
+	std::error_code ec;
+	for (const auto &entry: std::filesystem::directory_iterator("/proc", ec)) {
+		auto name = entry.path().filename().native();
+		int pid = 0;
+		auto r = std::from_chars(name.data(), name.data() + name.size(), pid);
+		if (r.ec != std::errc{} || r.ptr != name.data() + name.size() || pid == self)
+			continue;
+		auto comm = read_comm(pid);
+		if (comm.empty())
+			continue;
+		if (std::ranges::find(native_names, comm) != native_names.end())
+			res.push_back({pid, Type::Native});
+		else if (std::ranges::find(wine_names, comm) != wine_names.end())
+			res.push_back({pid, Type::Wine});
+	}
+	if (ec)
+		throw std::system_error(ec, "Failed to list /proc");
+	return res;
+}
+
+ProcessDiscovery::Found ProcessDiscovery::identify(const Candidate &candidate) const
+{
+	Found res = {candidate.pid, candidate.type, nullptr, nullptr};
+	std::unique_ptr<Process> process;
+	try {
+		switch (candidate.type) {
+		case Type::Native:
+			process = std::make_unique<LinuxProcess>(candidate.pid);
+			break;
+		case Type::Wine:
+			process = std::make_unique<WineProcess>(candidate.pid);
+			break;
+		}
+	}
+	catch (std::exception &e) {
+		log(std::format("process {}: {}", candidate.pid, e.what()));
+		return res;
+	}
+	res.version = _structures.versionById(process->id());
+	if (!res.version)
+		log(std::format("process {}: unknown version", candidate.pid));
+	res.process = std::move(process);
+	return res;
+}
+
+std::vector<ProcessDiscovery::Found> ProcessDiscovery::scan()
+{
+	_seen.clear();
+	return poll();
+}
+
+std::vector<ProcessDiscovery::Found> ProcessDiscovery::poll()
+{
+	std::vector<Found> res;
+	std::map<int, unsigned long long> seen;
+	for (const auto &candidate: candidates()) {
+		auto start_time = read_start_time(candidate.pid);
+		if (start_time == 0)
+			continue; // the process exited
+		if (auto it = _seen.find(candidate.pid); it != _seen.end() && it->second == start_time) {
+			seen.emplace(candidate.pid, start_time);
+			continue;
+		}
+		auto found = identify(candidate);
+		// Processes that could not be opened are retried on the next
+		// poll (wine may not have mapped the executable yet), unknown
+		// versions are not.
+		if (found.process)
+			seen.emplace(candidate.pid, start_time);
+		if (found.version)
+			res.push_back(std::move(found));
+	}
+	_seen = std::move(seen);
+	return res;
+}
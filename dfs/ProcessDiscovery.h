@@ -0,0 +1,131 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_PROCESS_DISCOVERY_H
+#define DFS_PROCESS_DISCOVERY_H
+
+#include <dfs/Process.h>
+#include <dfs/Structures.h>
+
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace dfs {
+
+/**
+ * Finds running Dwarf Fortress processes (linux-only).
+ *
+ * Processes are listed from `/proc` using cheap checks first: only the
+ * processes whose name (`/proc/<pid>/comm`) matches \ref native_names or
+ * \ref wine_names are considered. Candidates are then identified by creating
+ * a LinuxProcess or WineProcess and matching their id with
+ * Structures::versionById. Native executable checksums are cached (see
+ * LinuxProcess::executable_md5), so identifying a known executable does not
+ * hash it again.
+ *
+ * \ingroup process
+ */
+class ProcessDiscovery
+{
+public:
+	enum class Type {
+		Native,	///< linux executable, opened as LinuxProcess
+		Wine,	///< windows executable running in wine, opened as WineProcess
+	};
+
+	/**
+	 * A process that passed the cheap checks.
+	 */
+	struct Candidate
+	{
+		int pid;
+		Type type;
+	};
+
+	/**
+	 * An identified Dwarf Fortress process.
+	 */
+	struct Found
+	{
+		int pid;
+		Type type;
+		std::unique_ptr<Process> process;	///< ready-to-use process
+		const Structures::VersionInfo *version;	///< matching version (null if unknown)
+	};
+
+	/**
+	 * Process names (as in `/proc/<pid>/comm`, truncated to 15
+	 * characters) of native Dwarf Fortress executables.
+	 */
+	std::vector<std::string> native_names = {"dwarfort", "Dwarf_Fortress"};
+	/**
+	 * Process names of Dwarf Fortress running in wine.
+	 */
+	std::vector<std::string> wine_names = {"Dwarf Fortress.", "Dwarf Fortress.exe"};
+
+	/**
+	 * Log function for processes that are rejected after being
+	 * identified as candidates (default to writing to `std::cerr`).
+	 */
+	std::function<void (std::string_view)> log;
+
+	ProcessDiscovery(const Structures &structures);
+
+	/**
+	 * Lists processes matching the names, without opening them.
+	 */
+	std::vector<Candidate> candidates() const;
+
+	/**
+	 * Identifies \p candidate.
+	 *
+	 * \returns the process and its version. \ref Found::process is null
+	 * if the process cannot be opened, \ref Found::version is null if its
+	 * version is unknown (errors are logged).
+	 */
+	Found identify(const Candidate &candidate) const;
+
+	/**
+	 * Lists and identifies every Dwarf Fortress process with a known
+	 * version.
+	 */
+	std::vector<Found> scan();
+
+	/**
+	 * Like scan() but only returns processes that were not returned
+	 * by a previous call to scan() or poll(). Processes are tracked by pid
+	 * and start time, so a reused pid is reported again.
+	 *
+	 * Call it periodically to watch for new processes (`/proc` does not
+	 * support inotify).
+	 */
+	std::vector<Found> poll();
+
+private:
+	const Structures &_structures;
+	/// start time of processes already seen, by pid
+	std::map<int, unsigned long long> _seen;
+};
+
+} // namespace dfs
+
+#endif
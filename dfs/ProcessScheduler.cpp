@@ -0,0 +1,186 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ProcessScheduler.h"
+
+#include <cppcoro/when_all.hpp>
+
+#include <iostream>
+
+using namespace dfs;
+
+ProcessScheduler::ProcessScheduler(const Structures &structures, std::size_t thread_count):
+	log([](process_id id, std::string_view str){
+		std::cerr << std::format("[process {}] {}", id, str) << std::endl;
+	}),
+	_structures(structures)
+{
+	thread_count = std::max<std::size_t>(thread_count, 1);
+	_threads.reserve(thread_count);
+	for (std::size_t i = 0; i < thread_count; ++i)
+		_threads.emplace_back(&ProcessScheduler::worker, this);
+}
+
+ProcessScheduler::~ProcessScheduler()
+{
+	{
+		std::lock_guard lock(_mutex);
+		_stopping = true;
+	}
+	_work_cv.notify_all();
+	for (auto &thread: _threads)
+		thread.join();
+}
+
+ProcessScheduler::process_id ProcessScheduler::add(std::unique_ptr<Process> &&process, bool stop_process)
+{
+	auto version = _structures.versionById(process->id());
+	if (!version)
+		throw std::runtime_error("version not found");
+	auto entry = std::make_shared<process_entry>();
+	entry->process = std::move(process);
+	entry->stop_process = stop_process;
+	std::lock_guard lock(_mutex);
+	auto &factory = _factories[version];
+	if (!factory)
+		factory = std::make_unique<ReaderFactory>(_structures, *version);
+	entry->factory = factory.get();
+	entry->id = _next_id++;
+	_processes.emplace(entry->id, entry);
+	return entry->id;
+}
+
+void ProcessScheduler::remove(process_id id)
+{
+	std::shared_ptr<process_entry> entry;
+	std::deque<queued_job> dropped;
+	{
+		std::lock_guard lock(_mutex);
+		auto it = _processes.find(id);
+		if (it == _processes.end())
+			return;
+		entry = std::move(it->second);
+		_processes.erase(it);
+		std::erase(_ready, entry);
+		dropped = std::move(entry->queue);
+		entry->queue.clear();
+	}
+	_idle_cv.notify_all();
+	// dropped jobs and the process (if not running) are destroyed outside the lock
+}
+
+std::future<bool> ProcessScheduler::submit(process_id id, job_t job)
+{
+	std::unique_lock lock(_mutex);
+	auto &entry = _processes.at(id);
+	auto &queued = entry->queue.emplace_back(std::move(job), std::promise<bool>{}, clock::now(), false);
+	auto future = queued.result.get_future();
+	if (!entry->running && entry->queue.size() == 1) {
+		_ready.push_back(entry);
+		lock.unlock();
+		_work_cv.notify_one();
+	}
+	return future;
+}
+
+void ProcessScheduler::wait()
+{
+	std::unique_lock lock(_mutex);
+	_idle_cv.wait(lock, [this]() { return _ready.empty() && _running == 0; });
+}
+
+ProcessScheduler::Metrics ProcessScheduler::metrics(process_id id) const
+{
+	std::lock_guard lock(_mutex);
+	const auto &entry = _processes.at(id);
+	auto metrics = entry->metrics;
+	metrics.queued_jobs = entry->queue.size();
+	return metrics;
+}
+
+void ProcessScheduler::worker()
+{
+	std::unique_lock lock(_mutex);
+	while (true) {
+		_work_cv.wait(lock, [this]() { return _stopping || !_ready.empty(); });
+		if (_stopping)
+			return;
+		auto entry = std::move(_ready.front());
+		_ready.pop_front();
+		auto jobs = std::move(entry->queue);
+		entry->queue.clear();
+		entry->running = true;
+		++_running;
+		lock.unlock();
+
+		run_session(*entry, jobs);
+		jobs.clear();
+
+		lock.lock();
+		entry->running = false;
+		--_running;
+		// Go to the back of the ready queue if more jobs were submitted
+		if (!entry->queue.empty() && _processes.contains(entry->id))
+			_ready.push_back(entry);
+		_idle_cv.notify_all();
+		if (entry.use_count() == 1) { // removed while running
+			lock.unlock();
+			entry.reset();
+			lock.lock();
+		}
+	}
+}
+
+void ProcessScheduler::run_session(process_entry &entry, std::deque<queued_job> &jobs)
+{
+	auto start = clock::now();
+	{
+		ReadSession session(*entry.factory, *entry.process, entry.stop_process);
+		session.log = [this, id = entry.id](std::string_view str) { log(id, str); };
+		std::vector<cppcoro::task<>> tasks;
+		tasks.reserve(jobs.size());
+		for (std::size_t i = 0; i < jobs.size(); ++i)
+			tasks.push_back([](ReadSession &session, queued_job &job) -> cppcoro::task<> {
+				try {
+					co_await job.job(session);
+					job.success = true;
+				}
+				catch (std::exception &e) {
+					session.log(std::format("job failed: {}", e.what()));
+				}
+			}(session, jobs[i]));
+		static_cast<void>(session.sync(cppcoro::when_all(std::move(tasks))));
+	}
+	auto end = clock::now();
+
+	{
+		std::lock_guard lock(_mutex);
+		auto &metrics = entry.metrics;
+		++metrics.sessions;
+		metrics.jobs += jobs.size();
+		metrics.session_time += end - start;
+		metrics.max_session_time = std::max(metrics.max_session_time, end - start);
+		for (const auto &job: jobs) {
+			metrics.wait_time += start - job.queued_at;
+			if (!job.success)
+				++metrics.failed_jobs;
+		}
+	}
+	for (auto &job: jobs)
+		job.result.set_value(job.success);
+}
@@ -0,0 +1,165 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_PROCESS_SCHEDULER_H
+#define DFS_PROCESS_SCHEDULER_H
+
+#include <dfs/Reader.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <map>
+#include <mutex>
+#include <thread>
+
+namespace dfs {
+
+/**
+ * Runs read sessions for several processes on a thread pool.
+ *
+ * Jobs are submitted for a given process and run inside a ReadSession for
+ * this process. A process is only used by one thread at a time: all the jobs
+ * queued for a process when its turn comes are run concurrently in the same
+ * session, then the process goes back to the end of the ready queue. Processes
+ * with pending jobs are served in round-robin order.
+ *
+ * Processes running the same version share a ReaderFactory.
+ *
+ * \ingroup readers
+ */
+class ProcessScheduler
+{
+public:
+	using process_id = std::size_t;
+	using clock = std::chrono::steady_clock;
+	/**
+	 * A job reads from the session it is given.
+	 */
+	using job_t = std::function<cppcoro::task<> (ReadSession &)>;
+
+	struct Metrics
+	{
+		std::size_t sessions = 0;	///< number of sessions run
+		std::size_t jobs = 0;		///< number of jobs run
+		std::size_t failed_jobs = 0;	///< number of jobs that threw an exception
+		std::size_t queued_jobs = 0;	///< number of jobs currently waiting
+		clock::duration session_time = {};	///< total time spent in sessions
+		clock::duration max_session_time = {};	///< longest session
+		clock::duration wait_time = {};	///< total time jobs spent waiting in the queue
+	};
+
+	/**
+	 * Constructs a scheduler using \p thread_count worker threads (at
+	 * least one).
+	 */
+	ProcessScheduler(const Structures &structures,
+			std::size_t thread_count = std::thread::hardware_concurrency());
+	/**
+	 * Waits for the running sessions to finish. Jobs that did not start
+	 * are dropped (their future will throw std::future_error).
+	 */
+	~ProcessScheduler();
+
+	ProcessScheduler(const ProcessScheduler &) = delete;
+	ProcessScheduler &operator=(const ProcessScheduler &) = delete;
+
+	/**
+	 * Adds \p process to the scheduler.
+	 *
+	 * \p stop_process is passed to the sessions of this process.
+	 *
+	 * \throws std::runtime_error if the process version is not found or
+	 * the reader factory cannot be created
+	 */
+	process_id add(std::unique_ptr<Process> &&process, bool stop_process = true);
+	/**
+	 * Removes a process. Its queued jobs are dropped, a running session
+	 * finishes before the process is destroyed.
+	 */
+	void remove(process_id id);
+
+	/**
+	 * Queues \p job for the process \p id.
+	 *
+	 * \returns a future set to false if the job threw an exception (the
+	 * error is logged), true otherwise.
+	 *
+	 * \throws std::out_of_range if there is no process \p id
+	 */
+	std::future<bool> submit(process_id id, job_t job);
+
+	/**
+	 * Waits until there is no job queued or running.
+	 */
+	void wait();
+
+	/**
+	 * \returns the metrics for the process \p id.
+	 *
+	 * \throws std::out_of_range if there is no process \p id
+	 */
+	Metrics metrics(process_id id) const;
+
+	/**
+	 * Log function for sessions (default to writing to `std::cerr` with
+	 * the process id).
+	 *
+	 * It is called from worker threads and must not be modified while
+	 * jobs are running.
+	 */
+	std::function<void (process_id, std::string_view)> log;
+
+private:
+	struct queued_job
+	{
+		job_t job;
+		std::promise<bool> result;
+		clock::time_point queued_at;
+		bool success;
+	};
+	struct process_entry
+	{
+		process_id id;
+		std::unique_ptr<Process> process;
+		ReaderFactory *factory;
+		bool stop_process;
+		std::deque<queued_job> queue;
+		bool running = false;
+		Metrics metrics;
+	};
+
+	const Structures &_structures;
+	mutable std::mutex _mutex;
+	std::condition_variable _work_cv, _idle_cv;
+	std::map<const Structures::VersionInfo *, std::unique_ptr<ReaderFactory>> _factories;
+	std::map<process_id, std::shared_ptr<process_entry>> _processes;
+	std::deque<std::shared_ptr<process_entry>> _ready;
+	process_id _next_id = 0;
+	std::size_t _running = 0;
+	bool _stopping = false;
+	std::vector<std::thread> _threads;
+
+	void worker();
+	void run_session(process_entry &entry, std::deque<queued_job> &jobs);
+};
+
+} // namespace dfs
+
+#endif
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "ReadErrorSummary.h"
+
+#include "Compound.h"
+
+#include <algorithm>
+#include <format>
+
+using namespace dfs;
+
+ReadErrorLimiter::ReadErrorLimiter(std::size_t burst, clock::duration period):
+	_burst(burst),
+	_period(period),
+	_tokens(burst),
+	_last(clock::now())
+{
+}
+
+std::size_t ReadErrorLimiter::acquire(std::size_t lines)
+{
+	std::lock_guard lock(_mutex);
+	auto now = clock::now();
+	if (_period.count() > 0) {
+		auto elapsed = std::chrono::duration<double>(now - _last) / _period;
+		_tokens = std::min<double>(_burst, _tokens + elapsed * _burst);
+	}
+	_last = now;
+	auto allowed = std::min<std::size_t>(lines, static_cast<std::size_t>(_tokens));
+	_tokens -= allowed;
+	_suppressed += lines - allowed;
+	return allowed;
+}
+
+std::size_t ReadErrorLimiter::take_suppressed()
+{
+	std::lock_guard lock(_mutex);
+	return std::exchange(_suppressed, 0);
+}
+
+void ReadErrorSummary::add(const ReadError &error)
+{
+	auto [it, inserted] = _entries.try_emplace({error.compound, error.member, error.err, error.value});
+	auto &entry = it->second;
+	if (inserted) {
+		entry.compound = error.compound;
+		entry.member = error.member;
+		entry.err = error.err;
+		entry.value = error.value;
+	}
+	++entry.count;
+	if (entry.samples.size() < max_samples)
+		entry.samples.push_back(error.address);
+	++_count;
+}
+
+void ReadErrorSummary::merge(const ReadErrorSummary &other)
+{
+	for (const auto &[key, other_entry]: other._entries) {
+		auto [it, inserted] = _entries.try_emplace(key, other_entry);
+		if (inserted) {
+			if (it->second.samples.size() > max_samples)
+				it->second.samples.resize(max_samples);
+			continue;
+		}
+		auto &entry = it->second;
+		entry.count += other_entry.count;
+		for (auto address: other_entry.samples) {
+			if (entry.samples.size() >= max_samples)
+				break;
+			entry.samples.push_back(address);
+		}
+	}
+	_count += other._count;
+}
+
+void ReadErrorSummary::clear()
+{
+	_entries.clear();
+	_count = 0;
+}
+
+std::vector<const ReadErrorSummary::Entry *> ReadErrorSummary::entries() const
+{
+	std::vector<const Entry *> res;
+	res.reserve(_entries.size());
+	for (const auto &[key, entry]: _entries)
+		res.push_back(&entry);
+	std::ranges::stable_sort(res, std::ranges::greater{}, &Entry::count);
+	return res;
+}
+
+std::string ReadErrorSummary::format(const Entry &entry)
+{
+	std::string res = std::format("{} in {}: {}",
+			entry.member,
+			entry.compound ? entry.compound->debug_name : "unknown type",
+			entry.err.message());
+	if (entry.value != 0)
+		res += std::format(" {:#x}", entry.value);
+	if (entry.count > 1)
+		res += std::format(" ({} errors)", entry.count);
+	if (!entry.samples.empty()) {
+		res += " at";
+		for (auto address: entry.samples)
+			res += std::format(" {:#x}", address);
+		if (entry.samples.size() < entry.count)
+			res += " ...";
+	}
+	return res;
+}
+
+void ReadErrorSummary::log(const std::function<void (std::string_view)> &log,
+		std::size_t max_lines,
+		ReadErrorLimiter *limiter) const
+{
+	if (_entries.empty())
+		return;
+	auto sorted = entries();
+	auto lines = std::min(max_lines, sorted.size());
+	if (limiter) {
+		auto requested = lines;
+		lines = limiter->acquire(requested);
+		if (lines == 0)
+			return;
+		// lines not allowed in this call are counted in the last line
+		auto suppressed = limiter->take_suppressed();
+		if (suppressed > requested - lines)
+			log(std::format("{} read error lines were suppressed",
+					suppressed - (requested - lines)));
+	}
+	for (std::size_t i = 0; i < lines; ++i)
+		log(format(*sorted[i]));
+	if (lines < sorted.size())
+		log(std::format("{} more read error types ({} errors in total)",
+				sorted.size() - lines, _count));
+}
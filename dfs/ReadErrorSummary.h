@@ -0,0 +1,160 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_READ_ERROR_SUMMARY_H
+#define DFS_READ_ERROR_SUMMARY_H
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <tuple>
+#include <vector>
+
+namespace dfs {
+
+struct Compound;
+
+/**
+ * An error while reading a member of a compound.
+ *
+ * \ingroup readers
+ */
+struct ReadError
+{
+	const Compound *compound;	///< DF type containing the member
+	std::string_view member;	///< path of the member (must outlive the summary)
+	std::error_code err;		///< error code
+	uintptr_t address;		///< address of the member data
+	uintptr_t value = 0;		///< invalid value that caused the error (e.g. an unknown vtable address), or 0
+};
+
+/**
+ * Limits the number of error lines logged over time.
+ *
+ * It is a token bucket: up to \p burst lines can be logged at once, and lines
+ * are allowed again at a rate of \p burst per \p period.
+ *
+ * It can be shared between threads.
+ *
+ * \ingroup readers
+ */
+class ReadErrorLimiter
+{
+public:
+	using clock = std::chrono::steady_clock;
+
+	ReadErrorLimiter(std::size_t burst, clock::duration period);
+
+	/**
+	 * Takes up to \p lines tokens.
+	 *
+	 * \returns the number of lines that can be logged, the others are
+	 * counted as suppressed
+	 */
+	std::size_t acquire(std::size_t lines);
+
+	/**
+	 * \returns the number of lines suppressed since the last call
+	 */
+	std::size_t take_suppressed();
+
+private:
+	std::mutex _mutex;
+	std::size_t _burst;
+	clock::duration _period;
+	double _tokens;
+	clock::time_point _last;
+	std::size_t _suppressed = 0;
+};
+
+/**
+ * Error records collected during a read session.
+ *
+ * Errors are grouped by compound, member, error code and value. Each group counts
+ * its errors and keeps the addresses of the first \ref max_samples ones.
+ * Nothing is formatted until the summary is consumed.
+ *
+ * \ingroup readers
+ */
+class ReadErrorSummary
+{
+public:
+	struct Entry
+	{
+		const Compound *compound;
+		std::string_view member;
+		std::error_code err;
+		uintptr_t value = 0;		///< see ReadError::value
+		std::size_t count = 0;		///< number of errors
+		std::vector<uintptr_t> samples;	///< addresses of the first errors
+	};
+
+	/**
+	 * Maximum number of addresses kept for each entry.
+	 */
+	std::size_t max_samples = 4;
+
+	/**
+	 * Records \p error.
+	 */
+	void add(const ReadError &error);
+	/**
+	 * Adds all the entries from \p other.
+	 */
+	void merge(const ReadErrorSummary &other);
+	void clear();
+
+	bool empty() const { return _entries.empty(); }
+	/**
+	 * \returns the total number of errors recorded
+	 */
+	std::size_t count() const { return _count; }
+	/**
+	 * \returns the entries, most frequent first
+	 */
+	std::vector<const Entry *> entries() const;
+
+	/**
+	 * Formats \p entry as a single line.
+	 */
+	static std::string format(const Entry &entry);
+
+	/**
+	 * Logs one line per entry, most frequent first.
+	 *
+	 * At most \p max_lines entries are logged. If \p limiter is not null,
+	 * it may suppress more lines.
+	 */
+	void log(const std::function<void (std::string_view)> &log,
+			std::size_t max_lines = 10,
+			ReadErrorLimiter *limiter = nullptr) const;
+
+private:
+	using key_t = std::tuple<const Compound *, std::string_view, std::error_code, uintptr_t>;
+	std::map<key_t, Entry> _entries;
+	std::size_t _count = 0;
+};
+
+} // namespace dfs
+
+#endif
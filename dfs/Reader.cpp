@@ -19,6 +19,7 @@
 #include "Reader.h"
 
 #include <iostream>
+#include <set>
 
 using namespace dfs;
 
@@ -37,6 +38,8 @@ public:
 		case ItemReaderError::CastError: return "cast error";
 		case ItemReaderError::InvalidField: return "invalid field";
 		case ItemReaderError::InvalidDiscriminator: return "invalid discriminator";
+		case ItemReaderError::UnknownVTable: return "unknown vtable address";
+		case ItemReaderError::SizeMismatch: return "size mismatch";
 		default: return "unknown error";
 		}
 	}
@@ -63,18 +66,137 @@ ReaderFactory::ReaderFactory(const Structures &structures, const Structures::Ver
 {
 }
 
-ReadSession::ReadSession(ReaderFactory &factory, Process &process):
+void ReaderFactory::freeze()
+{
+	std::lock_guard lock(_mutex);
+	// Frozen lookups only use the snapshots
+	_compound_readers.publish(true);
+	_polymorphic_readers.publish(true);
+	_frozen.store(true, std::memory_order_release);
+}
+
+void ReaderFactory::end_construction()
+{
+	if (--_construction_depth != 0)
+		return;
+	_constructed.clear();
+	_compound_readers.publish(false);
+	_polymorphic_readers.publish(false);
+}
+
+void ReaderFactory::publish_all()
+{
+	std::lock_guard lock(_mutex);
+	_compound_readers.publish(true);
+	_polymorphic_readers.publish(true);
+}
+
+void ReaderFactory::reader_cache::publish(bool force)
+{
+	auto current = snapshot.load(std::memory_order_relaxed);
+	std::size_t published = current ? current->size() : 0;
+	// failed readers are removed, so the published readers are a subset
+	if (published == readers.size())
+		return; // nothing new
+	if (!force && readers.size() - published < std::max<std::size_t>(published, 1))
+		return; // batch with later readers
+	auto next = std::make_unique<snapshot_t>();
+	next->reserve(readers.size());
+	for (const auto &[key, reader]: readers)
+		next->emplace(key, reader.get());
+	snapshot.store(next.get(), std::memory_order_release);
+	snapshots.push_back(std::move(next));
+}
+
+cppcoro::task<std::size_t> Prefetcher::run(ReadSession &session, std::size_t max_depth)
+{
+	std::set<std::pair<uintptr_t, const void *>> visited;
+	std::size_t depth = 0;
+	while (!_next.empty() && depth < max_depth) {
+		auto level = std::move(_next);
+		_next.clear();
+		std::erase_if(level, [&](const request &r) {
+			return !visited.emplace(r.address, r.reader).second;
+		});
+		if (level.empty())
+			break;
+		++depth;
+		std::vector<MemoryBuffer> buffers;
+		std::vector<MemoryBufferRef> refs;
+		buffers.reserve(level.size());
+		refs.reserve(level.size());
+		for (const auto &r: level) {
+			auto &buffer = buffers.emplace_back(r.address, r.size);
+			refs.push_back({r.address, {buffer.data(), buffer.size()}});
+		}
+		std::vector<bool> valid(level.size(), true);
+		if (co_await session.process().readv(refs)) {
+			// Find the invalid blocks, the others are already cached
+			for (std::size_t i = 0; i < refs.size(); ++i)
+				valid[i] = !co_await session.process().read(refs[i]);
+		}
+		if (depth == max_depth)
+			break;
+		std::vector<cppcoro::task<>> tasks;
+		auto extract = [](const request &r, ReadSession &session, MemoryView data, Prefetcher &prefetcher)
+				-> cppcoro::task<> {
+			try {
+				co_await r.extractor(r.reader, session, data, prefetcher);
+			}
+			catch (std::exception &) {
+				// ignored, the actual read will report it
+			}
+		};
+		for (std::size_t i = 0; i < level.size(); ++i) {
+			const auto &r = level[i];
+			if (!r.extractor || !valid[i])
+				continue;
+			if (r.item_size == 0)
+				tasks.push_back(extract(r, session, refs[i], *this));
+			else for (std::size_t offset = 0; offset < r.size; offset += r.item_size)
+				tasks.push_back(extract(r, session, MemoryView(refs[i]).subview(offset, r.item_size), *this));
+		}
+		co_await cppcoro::when_all(std::move(tasks));
+	}
+	_next.clear();
+	co_return depth;
+}
+
+ReadSession::ReadSession(ReaderFactory &factory, Process &process, bool stop_process):
 	log([this](std::string_view str){_factory.log(str);}),
+	error_handler([this](const ReadErrorSummary &errors) {
+		errors.log(log, 10, &_factory.error_limiter);
+	}),
 	_factory(factory),
-	_process(process)
+	_process(process),
+	_stopped(stop_process)
 {
-	if (auto err = _process.stop())
-		log(std::format("Failed to stop process: {}", err.message()));
+	if (_stopped) {
+		if (auto err = _process.stop())
+			log(std::format("Failed to stop process: {}", err.message()));
+	}
 }
 
 ReadSession::~ReadSession()
 {
-	if (auto err = _process.cont())
-		log(std::format("Failed to resume process: {}", err.message()));
+	// Resume the process before calling the user error handler
+	if (_stopped) {
+		if (auto err = _process.cont())
+			log(std::format("Failed to resume process: {}", err.message()));
+	}
+	try {
+		flush_errors();
+	}
+	catch (std::exception &e) {
+		log(std::format("Error handler failed: {}", e.what()));
+	}
 }
 
+void ReadSession::flush_errors()
+{
+	if (_errors.empty())
+		return;
+	if (error_handler)
+		error_handler(_errors);
+	_errors.clear();
+}
@@ -22,7 +22,11 @@
 #include <dfs/Structures.h>
 #include <dfs/MemoryLayout.h>
 #include <dfs/Pointer.h>
+#include <dfs/ReadErrorSummary.h>
+#include <dfs/StaticABI.h>
 
+#include <atomic>
+#include <mutex>
 #include <typeindex>
 #include <cppcoro/shared_task.hpp>
 #include <cppcoro/sync_wait.hpp>
@@ -49,6 +53,8 @@ enum class ItemReaderError {
 	CastError,
 	InvalidField,
 	InvalidDiscriminator,
+	UnknownVTable,
+	SizeMismatch,
 };
 
 /**
@@ -128,6 +134,7 @@ public:
 
 class ReaderFactory;
 class ReadSession;
+class Prefetcher;
 
 /**
  * A type that can read a compound (union, struct or class).
@@ -153,7 +160,7 @@ concept CompoundReaderWithArgs = CompoundReaderConcept<T> && requires (
 		typename T::output_type out,
 		Args &&...args)
 {
-	{ t.read(session, data, out, std::forward<Args>(args)...) } -> std::same_as<cppcoro::task<>>;
+	{ t.read(session, data, out, std::forward<Args>(args)...) } -> std::same_as<cppcoro::task<std::error_code>>;
 };
 
 /**
@@ -164,12 +171,13 @@ concept PolymorphicReaderConcept = requires (
 		T t,
 		ReaderFactory factory,
 		ReadSession session,
-		const uintptr_t addr)
+		const uintptr_t addr,
+		std::unique_ptr<typename T::output_type> out)
 {
 	typename T::output_type;
 	requires std::default_initializable<T>;
 	t.setLayout(factory);
-	{ std::as_const(t).read(session, addr) } -> std::same_as<cppcoro::task<std::unique_ptr<typename T::output_type>>>;
+	{ std::as_const(t).read(session, addr, out) } -> std::same_as<cppcoro::task<std::error_code>>;
 };
 
 /**
@@ -248,11 +256,15 @@ struct polymorphic_base<T>
  * type is unsupported.
  *
  * It must have a method `std::size_t size() const` returning the size of the
- * DF object. And one or more `cppcoro::task<> operator()(ReadSession &session,
- * MemoryView data, output_type &out, ...)` where `data` is a view on DF memory
- * of the required size and `out` the variable that must be initialized. It can
- * takes extra parameters as needed, for example variant and union require an
- * index for the type alternative to read.
+ * DF object. And one or more `cppcoro::task<std::error_code>
+ * operator()(ReadSession &session, MemoryView data, output_type &out, ...)`
+ * where `data` is a view on DF memory of the required size and `out` the
+ * variable that must be initialized. It can takes extra parameters as needed,
+ * for example variant and union require an index for the type alternative to
+ * read.
+ *
+ * Read errors are returned instead of thrown: invalid memory is common while
+ * DF is running and exceptions are slow to propagate through coroutines.
  *
  * \todo concept
  *
@@ -275,7 +287,50 @@ concept ReadableType = requires (
 {
 	requires std::constructible_from<ItemReader<T>, ReaderFactory &, AnyTypeRef>;
 	{ std::as_const(reader).size() } -> std::convertible_to<std::size_t>;
-	{ reader(session, data, out, std::forward<Args>(args)...) } -> std::same_as<cppcoro::task<>>;
+	{ reader(session, data, out, std::forward<Args>(args)...) } -> std::same_as<cppcoro::task<std::error_code>>;
+};
+
+namespace details {
+
+/**
+ * A task immediately returning \p err.
+ */
+inline cppcoro::task<std::error_code> error_task(std::error_code err)
+{
+	co_return err;
+}
+
+/**
+ * Waits for all \p tasks and returns the first error.
+ */
+inline cppcoro::task<std::error_code> when_all_errors(std::vector<cppcoro::task<std::error_code>> tasks)
+{
+	auto res = co_await cppcoro::when_all(std::move(tasks));
+	for (auto err: res)
+		if (err)
+			co_return err;
+	co_return std::error_code{};
+}
+
+} // namespace details
+
+/**
+ * A reader (ItemReader or compound reader) that can tell where the objects
+ * referenced by the data it reads are located.
+ *
+ * `prefetch(session, data, prefetcher)` must add the blocks that will be
+ * needed for reading \p data to \p prefetcher, without reading them.
+ *
+ * \sa Prefetcher
+ */
+template <typename T>
+concept PrefetchableReader = requires (
+		const T reader,
+		ReadSession session,
+		const MemoryView data,
+		Prefetcher prefetcher)
+{
+	{ reader.prefetch(session, data, prefetcher) } -> std::same_as<cppcoro::task<>>;
 };
 
 /**
@@ -289,11 +344,21 @@ concept ReadableType = requires (
  *
  * Errors happening during reader initialization will be logged with \ref log
  * (default to writing to `std::cerr`), and a exception will be thrown.
+ *
+ * The factory can be shared between threads. Each reader is created only
+ * once, creation is serialized (it may be reentrant), but getting an already
+ * created reader does not lock. \ref log must not be modified while the
+ * factory is in use by other threads.
  */
 class ReaderFactory
 {
 public:
 	std::function<void (std::string_view)> log;
+	/**
+	 * Rate limit for read error lines logged by the sessions using this
+	 * factory.
+	 */
+	ReadErrorLimiter error_limiter{10, std::chrono::seconds(10)};
 	const Structures &structures;
         const ABI abi;
 	const MemoryLayout layout;
@@ -309,6 +374,17 @@ public:
 	 */
 	ReaderFactory(const Structures &structures, const Structures::VersionInfo &version);
 
+	/**
+	 * Calls \p f with the StaticABI for \ref abi if it was enabled at
+	 * compile time, or a DynamicABI otherwise.
+	 *
+	 * \sa dfs::visit_abi
+	 */
+	template <typename F>
+	decltype(auto) visit_abi(F &&f) const {
+		return dfs::visit_abi(abi, std::forward<F>(f));
+	}
+
 	/**
 	 * Creates a reader for local type \p T from DF type \p type.
 	 */
@@ -324,15 +400,10 @@ public:
 	 */
 	template <ReadableStructure T>
 	auto getCompoundReader() {
-		auto [it, inserted] = _readers.try_emplace(std::type_index(typeid(T)));
-		if (inserted) {
-			auto ptr = std::make_shared<compound_reader_type_t<T>>(structures);
-			it->second = ptr;
-			ptr->setLayout(*this); // may reenter
-			return ptr.get();
-		}
-		else
-			return static_cast<compound_reader_type_t<T> *>(it->second.get());
+		using reader_type = compound_reader_type_t<T>;
+		return get_reader<reader_type>(_compound_readers, typeid(T), [this]() {
+			return std::make_shared<reader_type>(structures);
+		});
 	}
 
 	/**
@@ -342,20 +413,242 @@ public:
 	 */
 	template <typename T> requires PolymorphicReaderConcept<polymorphic_reader_type_t<T>>
 	auto getPolymorphicReader() {
-		auto [it, inserted] = _polymorphic_readers.try_emplace(std::type_index(typeid(T)));
-		if (inserted) {
-			auto ptr = std::make_shared<polymorphic_reader_type_t<T>>();
-			it->second = ptr;
+		using reader_type = polymorphic_reader_type_t<T>;
+		return get_reader<reader_type>(_polymorphic_readers, typeid(T), []() {
+			return std::make_shared<reader_type>();
+		});
+	}
+
+	/**
+	 * Creates the compound and polymorphic readers for all \p Ts ahead
+	 * of time, including the readers for their fields and bases.
+	 *
+	 * Errors for every type are collected before throwing, so that all
+	 * type errors are reported at once. They are also logged with \ref
+	 * log.
+	 *
+	 * It must not be called while other threads use the factory.
+	 *
+	 * \throws std::runtime_error listing every error
+	 */
+	template <typename... Ts>
+	void prepare() {
+		std::vector<std::string> errors;
+		std::size_t failed = 0;
+		{
+			// Restores the log even if preparing throws
+			struct log_guard {
+				std::function<void (std::string_view)> &log, previous;
+				~log_guard() { log = std::move(previous); }
+			} guard{log, std::move(log)};
+			log = [&](std::string_view str) {
+				errors.emplace_back(str);
+				guard.previous(str);
+			};
+			(prepare_type<Ts>(errors, failed), ...);
+		}
+		publish_all();
+		if (!errors.empty()) {
+			std::string message = std::format("failed to prepare {} reader(s):", failed);
+			for (const auto &error: errors) {
+				message += "\n";
+				message += error;
+			}
+			throw std::runtime_error(message);
+		}
+	}
+
+	/**
+	 * Forbids creating new readers.
+	 *
+	 * After this call, getting a reader is only a lookup without any
+	 * locking, and getting a reader that was not created before throws
+	 * std::logic_error.
+	 *
+	 * It must not be called while readers are being created.
+	 */
+	void freeze();
+	bool frozen() const { return _frozen.load(std::memory_order_acquire); }
+
+private:
+	/**
+	 * Readers are owned by \ref readers (guarded by \ref _mutex) and
+	 * published in immutable snapshots once fully initialized, so that
+	 * lookups after warm-up do not need any lock. Old snapshots are kept
+	 * alive until the factory is destroyed as they may still be in use.
+	 *
+	 * Publishing is batched: a new snapshot is only made when the
+	 * unpublished readers are at least as many as the published ones (or
+	 * when forced by \ref prepare or \ref freeze), so that all the kept
+	 * snapshots are less than twice as big as the last one. Unpublished
+	 * readers are found with the lock.
+	 */
+	struct reader_cache
+	{
+		using snapshot_t = std::unordered_map<std::type_index, void *>;
+
+		std::unordered_map<std::type_index, std::shared_ptr<void>> readers;
+		std::atomic<const snapshot_t *> snapshot = nullptr;
+		std::vector<std::unique_ptr<const snapshot_t>> snapshots;
+
+		void *find(std::type_index key) const {
+			auto current = snapshot.load(std::memory_order_acquire);
+			if (!current)
+				return nullptr;
+			auto it = current->find(key);
+			return it == current->end() ? nullptr : it->second;
+		}
+		void publish(bool force);
+	};
+
+	std::recursive_mutex _mutex;
+	std::size_t _construction_depth = 0;
+	/// Readers created since the outermost construction began
+	std::vector<std::pair<reader_cache *, std::type_index>> _constructed;
+	std::atomic<bool> _frozen = false;
+	reader_cache _compound_readers;
+	reader_cache _polymorphic_readers;
+
+	template <typename Reader, typename Make>
+	Reader *get_reader(reader_cache &cache, std::type_index key, Make &&make) {
+		if (auto reader = cache.find(key))
+			return static_cast<Reader *>(reader);
+		if (frozen())
+			throw std::logic_error(std::format("no reader for {} in frozen factory", key.name()));
+		std::lock_guard lock(_mutex);
+		// The reader may have been created by another thread, or it
+		// is being created by this thread (reentrant setLayout).
+		if (auto it = cache.readers.find(key); it != cache.readers.end())
+			return static_cast<Reader *>(it->second.get());
+		auto ptr = make();
+		cache.readers.emplace(key, ptr);
+		auto first = _constructed.size();
+		_constructed.emplace_back(&cache, key);
+		++_construction_depth;
+		try {
 			ptr->setLayout(*this); // may reenter
-			return ptr.get();
 		}
+		catch (...) {
+			// Remove the reader and the readers created while
+			// setting its layout, as they may point to it. None of
+			// them is published yet.
+			for (auto [c, k]: std::span(_constructed).subspan(first))
+				c->readers.erase(k);
+			_constructed.erase(_constructed.begin() + first, _constructed.end());
+			end_construction();
+			throw;
+		}
+		end_construction();
+		return ptr.get();
+	}
+
+	// Counts T in failed if it throws or logs errors
+	template <typename T>
+	void prepare_type(std::vector<std::string> &errors, std::size_t &failed) {
+		constexpr bool polymorphic = requires {
+			requires PolymorphicReaderConcept<polymorphic_reader_type_t<T>>;
+		};
+		static_assert(ReadableStructure<T> || polymorphic,
+				"T has no compound or polymorphic reader");
+		auto error_count = errors.size();
+		try {
+			if constexpr (ReadableStructure<T>)
+				getCompoundReader<T>();
+			if constexpr (polymorphic)
+				getPolymorphicReader<T>();
+		}
+		catch (std::exception &e) {
+			errors.push_back(std::format("{}: {}", typeid(T).name(), e.what()));
+		}
+		if (errors.size() != error_count)
+			++failed;
+	}
+
+	// Publishes new readers when the outermost construction ends
+	void end_construction();
+	// Publishes every reader without batching
+	void publish_all();
+};
+
+/**
+ * Reads the object graph breadth-first before it is actually read.
+ *
+ * Blocks added to the prefetcher are read level by level: all the blocks of
+ * a level are read with a single Process::readv call, then the readers
+ * associated with the blocks extract the addresses of the next level (see
+ * PrefetchableReader). The number of dependent reads grows with the depth of
+ * the graph instead of the number of objects.
+ *
+ * The data read is discarded, it is only useful when the session process
+ * keeps it (ProcessCache). Errors are ignored, the actual read will report
+ * them.
+ *
+ * \sa ReadSession::prefetch_depth
+ */
+class Prefetcher
+{
+public:
+	/**
+	 * Adds a block of \p size bytes at \p address that does not reference
+	 * other objects.
+	 */
+	void add(uintptr_t address, std::size_t size) {
+		if (address && size)
+			_next.push_back({address, size, 0, nullptr, nullptr});
+	}
+
+	/**
+	 * Adds an object of \p size bytes at \p address that will be read by
+	 * \p reader.
+	 */
+	template <typename Reader>
+	void add(uintptr_t address, std::size_t size, const Reader &reader) {
+		if (!address || !size)
+			return;
+		if constexpr (PrefetchableReader<Reader>)
+			_next.push_back({address, size, 0, &reader, &extract<Reader>});
+		else
+			add(address, size);
+	}
+
+	/**
+	 * Adds an array of \p count objects of \p item_size bytes at \p
+	 * address that will be read by \p reader.
+	 */
+	template <typename Reader>
+	void add_array(uintptr_t address, std::size_t count, std::size_t item_size, const Reader &reader) {
+		if (!address || !count || !item_size)
+			return;
+		if constexpr (PrefetchableReader<Reader>)
+			_next.push_back({address, count*item_size, item_size, &reader, &extract<Reader>});
 		else
-			return static_cast<polymorphic_reader_type_t<T> *>(it->second.get());
+			add(address, count*item_size);
 	}
 
+	/**
+	 * Reads the blocks added and the blocks they reference, up to \p
+	 * max_depth levels.
+	 *
+	 * \returns the number of levels read
+	 */
+	cppcoro::task<std::size_t> run(ReadSession &session, std::size_t max_depth);
+
 private:
-	std::unordered_map<std::type_index, std::shared_ptr<void>> _readers;
-	std::unordered_map<std::type_index, std::shared_ptr<void>> _polymorphic_readers;
+	using extractor_t = cppcoro::task<> (*)(const void *reader, ReadSession &session, MemoryView data, Prefetcher &prefetcher);
+	struct request
+	{
+		uintptr_t address;
+		std::size_t size;
+		std::size_t item_size;	///< 0 for a single object
+		const void *reader;
+		extractor_t extractor;
+	};
+	std::vector<request> _next;
+
+	template <typename Reader>
+	static cppcoro::task<> extract(const void *reader, ReadSession &session, MemoryView data, Prefetcher &prefetcher) {
+		return static_cast<const Reader *>(reader)->prefetch(session, data, prefetcher);
+	}
 };
 
 /**
@@ -374,24 +667,39 @@ private:
  * \ref addSharedObjectsCache.
  *
  * Errors during reading will be logged using \ref log (will default to using
- * ReaderFactory::log) and \ref sync will return \c false.
+ * ReaderFactory::log) and \ref sync will return \c false. Errors in fields
+ * are collected (see \ref report_error) and passed to \ref error_handler
+ * when \ref sync returns.
  */
 class ReadSession
 {
 public:
 	std::function<void (std::string_view)> log;
+	/**
+	 * Called with the errors collected when \ref sync returns or the
+	 * session ends.
+	 *
+	 * The default handler logs the most frequent errors with \ref log,
+	 * limited by ReaderFactory::error_limiter.
+	 */
+	std::function<void (const ReadErrorSummary &)> error_handler;
 
 	/**
 	 * Creates a new session, using readers from \p factory and reads
 	 * memory from \p process.
 	 *
-	 * \p process is stopped.
+	 * \p process is stopped, unless \p stop_process is false. Memory may
+	 * change while being read when the process is not stopped, and
+	 * wrappers clearing their state when the process is stopped or
+	 * resumed (e.g. ProcessCache) must not be used.
 	 */
-	ReadSession(ReaderFactory &factory, Process &process);
+	ReadSession(ReaderFactory &factory, Process &process, bool stop_process = true);
 	/**
 	 * Finish the session.
 	 *
-	 * The process is resumed.
+	 * The process is resumed if it was stopped, then the remaining errors
+	 * are passed to \ref error_handler. Exceptions from the handler are
+	 * logged.
 	 */
 	~ReadSession();
 
@@ -403,6 +711,24 @@ public:
 	Process &process() { return _process; }
 	const ABI &abi() const { return _factory.abi; }
 
+	/**
+	 * \copydoc ReaderFactory::visit_abi
+	 */
+	template <typename F>
+	decltype(auto) visit_abi(F &&f) const {
+		return _factory.visit_abi(std::forward<F>(f));
+	}
+
+	/**
+	 * Number of levels of the object graph prefetched by \ref read before
+	 * actually reading (0 disables prefetching).
+	 *
+	 * It only makes sense when \ref process is a ProcessCache.
+	 *
+	 * \sa Prefetcher
+	 */
+	std::size_t prefetch_depth = 0;
+
 	/**
 	 * Find the address and type of the global specified by \p path.
 	 */
@@ -423,10 +749,16 @@ public:
 	cppcoro::task<> read(Pointer ptr, T &var)
 	{
 		auto reader = _factory.make_item_reader<T>(ptr.type);
+		if (prefetch_depth) {
+			Prefetcher prefetcher;
+			prefetcher.add(ptr.address, reader.size(), reader);
+			co_await prefetcher.run(*this, prefetch_depth);
+		}
 		MemoryBuffer data(ptr.address, reader.size());
 		if (auto err = co_await _process.read(data))
 			throw std::system_error(err);
-		co_await reader(*this, data, var);
+		if (auto err = co_await reader(*this, data, var))
+			throw std::system_error(err);
 	}
 
 	/**
@@ -449,14 +781,41 @@ public:
 			_process.sync([](Reads &&... reads) -> cppcoro::task<> {
 				co_await cppcoro::when_all(std::forward<Reads>(reads)...);
 			}(std::forward<Reads>(reads)...));
+			flush_errors();
 			return true;
 		}
 		catch (std::exception &e) {
+			flush_errors();
 			log(std::format("failed to read data: {}\n", e.what()));
 			return false;
 		}
 	}
 
+	/**
+	 * Records an error while reading \p member from \p compound at \p
+	 * address.
+	 *
+	 * Nothing is formatted, errors are passed to \ref error_handler
+	 * when \ref sync returns or the session ends.
+	 *
+	 * \p member must outlive the session (e.g. a string literal). \p
+	 * value is the invalid value read, if any (see ReadError::value).
+	 */
+	void report_error(const Compound *compound, std::string_view member, std::error_code err, uintptr_t address, uintptr_t value = 0) {
+		_errors.add({compound, member, err, address, value});
+	}
+
+	/**
+	 * The errors recorded since the last call to \ref flush_errors.
+	 */
+	const ReadErrorSummary &errors() const { return _errors; }
+
+	/**
+	 * Passes the errors recorded with \ref report_error to \ref
+	 * error_handler and clears them.
+	 */
+	void flush_errors();
+
 	/**
 	 * Same as read(Pointer, T &) but runs synchronously.
 	 */
@@ -475,6 +834,15 @@ public:
 		return sync(read(std::forward<Rng>(path), var));
 	}
 
+	/**
+	 * Result of reading a shared object.
+	 */
+	struct shared_object
+	{
+		std::shared_ptr<void> ptr;
+		std::error_code err = {};
+	};
+
 	/**
 	 * Get the `std::shared_ptr<T>` from \p address from cache if it was
 	 * already read, or using \p object_factory if not.
@@ -482,15 +850,17 @@ public:
 	 * For polymorphic types \p T must be the base type.
 	 *
 	 * \p object_factory must accept a reference to this session and the
-	 * address as parameter and return a
-	 * `cppcoro::shared_task<std::shared_ptr<void>>`.
+	 * address as parameter and return a `cppcoro::shared_task<shared_object>`.
+	 *
+	 * If the address was already read with a different type, the task
+	 * result is ItemReaderError::TypeMismatch.
 	 */
 	template <typename T, std::invocable<ReadSession &, uintptr_t> F>
-	cppcoro::shared_task<std::shared_ptr<void>> getSharedObject(uintptr_t address, F &&object_factory)
+	cppcoro::shared_task<shared_object> getSharedObject(uintptr_t address, F &&object_factory)
 	{
 		static_assert(std::is_same_v<
 				std::invoke_result_t<F, ReadSession &, uintptr_t>,
-				cppcoro::shared_task<std::shared_ptr<void>>
+				cppcoro::shared_task<shared_object>
 			>);
 		std::type_index type = typeid(T);
 		auto external = _external_shared_objects.find(type);
@@ -499,11 +869,13 @@ public:
 			: _shared_objects;
 		auto [it, inserted] = cache.try_emplace(
 				address,
-				std::make_pair(type, cppcoro::shared_task<std::shared_ptr<void>>{}));
+				std::make_pair(type, cppcoro::shared_task<shared_object>{}));
 		if (inserted)
 			it->second.second = std::invoke(object_factory, *this, address);
 		else if (it->second.first != type)
-			throw std::system_error(ItemReaderError::TypeMismatch);
+			return []() -> cppcoro::shared_task<shared_object> {
+				co_return shared_object{nullptr, ItemReaderError::TypeMismatch};
+			}();
 		return it->second.second;
 	}
 
@@ -512,7 +884,7 @@ public:
 	 *
 	 * \sa addSharedObjectsCache
 	 */
-	using shared_objects_cache_t = std::unordered_map<uintptr_t, std::pair<std::type_index, cppcoro::shared_task<std::shared_ptr<void>>>>;
+	using shared_objects_cache_t = std::unordered_map<uintptr_t, std::pair<std::type_index, cppcoro::shared_task<shared_object>>>;
 
 	/**
 	 * Add a external cache for type \p T.
@@ -533,8 +905,10 @@ public:
 private:
 	ReaderFactory &_factory;
 	Process &_process;
+	bool _stopped;
 	shared_objects_cache_t _shared_objects;
 	std::map<std::type_index, shared_objects_cache_t *> _external_shared_objects;
+	ReadErrorSummary _errors;
 };
 
 ///< \}
@@ -0,0 +1,241 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Snapshot.h"
+
+#include <fstream>
+
+using namespace dfs::snapshot;
+
+static constexpr std::size_t align(std::size_t offset)
+{
+	return (offset + Alignment - 1) & ~(Alignment - 1);
+}
+
+static std::size_t value_size(ColumnType type)
+{
+	switch (type) {
+	case ColumnType::Int8:
+	case ColumnType::UInt8:
+	case ColumnType::Bool:
+		return 1;
+	case ColumnType::Int16:
+	case ColumnType::UInt16:
+		return 2;
+	case ColumnType::Int32:
+	case ColumnType::UInt32:
+	case ColumnType::Float32:
+		return 4;
+	case ColumnType::Int64:
+	case ColumnType::UInt64:
+	case ColumnType::Float64:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+Writer::Table &Writer::add_table(std::string name, std::size_t rows)
+{
+	return _tables.emplace_back(std::move(name), rows);
+}
+
+void Writer::write(std::ostream &out) const
+{
+	// Compute the file layout: headers, names, then column data
+	std::size_t column_count = 0;
+	for (const auto &table: _tables)
+		column_count += table.columns.size();
+	std::size_t offset = sizeof(FileHeader)
+		+ _tables.size() * sizeof(TableEntry)
+		+ column_count * sizeof(ColumnEntry);
+
+	std::vector<TableEntry> table_entries;
+	std::vector<ColumnEntry> column_entries;
+	std::string names;
+	auto add_name = [&](const std::string &name) {
+		auto name_offset = names.size();
+		names += name;
+		names += '\0';
+		return name_offset;
+	};
+	auto columns_offset = sizeof(FileHeader) + _tables.size() * sizeof(TableEntry);
+	for (const auto &table: _tables) {
+		table_entries.push_back({
+			.name_offset = add_name(table.name),
+			.name_size = uint32_t(table.name.size()),
+			.column_count = uint32_t(table.columns.size()),
+			.row_count = table.rows,
+			.columns_offset = columns_offset,
+		});
+		columns_offset += table.columns.size() * sizeof(ColumnEntry);
+		for (const auto &column: table.columns) {
+			auto data_size = column.data.size();
+			if (column.type == ColumnType::String)
+				data_size += (column.string_ends.size() + 1) * sizeof(uint64_t);
+			column_entries.push_back({
+				.name_offset = add_name(column.name),
+				.name_size = uint32_t(column.name.size()),
+				.type = column.type,
+				.data_offset = 0,
+				.data_size = data_size,
+			});
+		}
+	}
+	for (auto &entry: table_entries)
+		entry.name_offset += offset;
+	for (auto &entry: column_entries)
+		entry.name_offset += offset;
+	offset = align(offset + names.size());
+	for (auto &entry: column_entries) {
+		entry.data_offset = offset;
+		offset = align(offset + entry.data_size);
+	}
+
+	// Write everything in order
+	static constexpr char padding[Alignment] = {};
+	std::size_t pos = 0;
+	auto put = [&](const void *data, std::size_t size) {
+		out.write(reinterpret_cast<const char *>(data), size);
+		pos += size;
+	};
+	auto pad = [&]() {
+		put(padding, align(pos) - pos);
+	};
+	FileHeader header = {};
+	std::memcpy(header.magic, Magic, sizeof(Magic));
+	header.version = FormatVersion;
+	header.table_count = _tables.size();
+	put(&header, sizeof(header));
+	put(table_entries.data(), table_entries.size() * sizeof(TableEntry));
+	put(column_entries.data(), column_entries.size() * sizeof(ColumnEntry));
+	put(names.data(), names.size());
+	pad();
+	for (const auto &table: _tables)
+		for (const auto &column: table.columns) {
+			if (column.type == ColumnType::String) {
+				uint64_t begin = 0;
+				put(&begin, sizeof(begin));
+				put(column.string_ends.data(), column.string_ends.size() * sizeof(uint64_t));
+			}
+			put(column.data.data(), column.data.size());
+			pad();
+		}
+	if (!out)
+		throw std::runtime_error("failed to write snapshot");
+}
+
+void Writer::write(const std::filesystem::path &path) const
+{
+	std::ofstream file(path, std::ios::binary | std::ios::trunc);
+	if (!file)
+		throw std::runtime_error(std::format("failed to open {}", path.string()));
+	write(file);
+}
+
+std::string_view View::Column::string(std::size_t row) const
+{
+	if (_type != ColumnType::String)
+		throw std::invalid_argument("column type mismatch");
+	if (row >= _rows)
+		throw std::out_of_range("invalid row");
+	auto offsets = reinterpret_cast<const uint64_t *>(_data.data());
+	auto chars = reinterpret_cast<const char *>(offsets + _rows + 1);
+	return {chars + offsets[row], chars + offsets[row+1]};
+}
+
+const View::Column *View::Table::column(std::string_view name) const
+{
+	auto it = std::ranges::find(_columns, name, &Column::name);
+	return it == _columns.end() ? nullptr : &*it;
+}
+
+View::View(std::span<const uint8_t> data)
+{
+	if (reinterpret_cast<uintptr_t>(data.data()) % Alignment != 0)
+		throw std::runtime_error("snapshot data is not aligned");
+	auto get_range = [&](uint64_t offset, uint64_t size) {
+		if (offset > data.size() || size > data.size() - offset)
+			throw std::runtime_error("snapshot offset out of bounds");
+		return data.subspan(offset, size);
+	};
+	auto get_name = [&](uint64_t offset, uint32_t size) {
+		auto bytes = get_range(offset, size);
+		return std::string_view(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+	};
+
+	auto header = reinterpret_cast<const FileHeader *>(get_range(0, sizeof(FileHeader)).data());
+	if (std::memcmp(header->magic, Magic, sizeof(Magic)) != 0)
+		throw std::runtime_error("invalid snapshot magic");
+	if (header->version != FormatVersion)
+		throw std::runtime_error(std::format("unsupported snapshot version {}", header->version));
+
+	auto tables = reinterpret_cast<const TableEntry *>(get_range(
+			sizeof(FileHeader),
+			uint64_t(header->table_count) * sizeof(TableEntry)).data());
+	_tables.resize(header->table_count);
+	for (std::size_t i = 0; i < _tables.size(); ++i) {
+		const auto &entry = tables[i];
+		auto &table = _tables[i];
+		if (entry.columns_offset % Alignment != 0)
+			throw std::runtime_error("snapshot columns are not aligned");
+		table._name = get_name(entry.name_offset, entry.name_size);
+		table._rows = entry.row_count;
+		auto columns = reinterpret_cast<const ColumnEntry *>(get_range(
+				entry.columns_offset,
+				uint64_t(entry.column_count) * sizeof(ColumnEntry)).data());
+		table._columns.resize(entry.column_count);
+		for (std::size_t j = 0; j < table._columns.size(); ++j) {
+			const auto &col_entry = columns[j];
+			auto &column = table._columns[j];
+			if (col_entry.data_offset % Alignment != 0)
+				throw std::runtime_error("snapshot column data is not aligned");
+			column._name = get_name(col_entry.name_offset, col_entry.name_size);
+			column._type = col_entry.type;
+			column._rows = table._rows;
+			column._data = get_range(col_entry.data_offset, col_entry.data_size);
+			if (column._type == ColumnType::String) {
+				// offsets must be increasing and within the characters
+				auto offset_count = column._data.size() / sizeof(uint64_t);
+				if (offset_count == 0 || offset_count - 1 < column._rows)
+					throw std::runtime_error("snapshot string column is too small");
+				auto offsets = reinterpret_cast<const uint64_t *>(column._data.data());
+				auto chars_size = column._data.size() - (column._rows + 1) * sizeof(uint64_t);
+				if (offsets[0] != 0 || offsets[column._rows] > chars_size)
+					throw std::runtime_error("invalid snapshot string column");
+				for (std::size_t k = 0; k < column._rows; ++k)
+					if (offsets[k] > offsets[k+1])
+						throw std::runtime_error("invalid snapshot string column");
+			}
+			else {
+				auto size = value_size(column._type);
+				if (size == 0)
+					throw std::runtime_error(std::format("unknown snapshot column type {}",
+							static_cast<uint32_t>(column._type)));
+				if (column._data.size() % size != 0 || column._data.size() / size != column._rows)
+					throw std::runtime_error("snapshot column size does not match row count");
+			}
+		}
+	}
+}
+
+const View::Table *View::table(std::string_view name) const
+{
+	auto it = std::ranges::find(_tables, name, &Table::name);
+	return it == _tables.end() ? nullptr : &*it;
+}
@@ -0,0 +1,460 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_SNAPSHOT_H
+#define DFS_SNAPSHOT_H
+
+#include <dfs/Columns.h>
+
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <ostream>
+
+/**
+ * Columnar snapshot files.
+ *
+ * Tables of read objects are stored column by column in a file that can be
+ * memory-mapped and used without parsing the rows. The format is described in
+ * \ref snapshot "Snapshot".
+ *
+ * \ingroup readers
+ */
+namespace dfs::snapshot {
+
+/**
+ * Type of the values in a column.
+ */
+enum class ColumnType: uint32_t
+{
+	Int8 = 1,
+	UInt8,
+	Int16,
+	UInt16,
+	Int32,
+	UInt32,
+	Int64,
+	UInt64,
+	Float32,
+	Float64,
+	Bool,	///< one byte per value
+	String,	///< `row count + 1` offsets (`uint64_t`) followed by the characters
+};
+
+/**
+ * \name On-disk structures
+ *
+ * All integers use the native byte order.
+ *
+ * \{
+ */
+inline constexpr char Magic[8] = {'D', 'F', 'S', 'S', 'N', 'A', 'P', '\0'};
+inline constexpr uint32_t FormatVersion = 1;
+/**
+ * Alignment of every table, column and data offset.
+ */
+inline constexpr std::size_t Alignment = 8;
+
+struct FileHeader
+{
+	char magic[8];
+	uint32_t version;
+	uint32_t table_count;
+};
+static_assert(sizeof(FileHeader) == 16);
+
+struct TableEntry
+{
+	uint64_t name_offset;
+	uint32_t name_size;
+	uint32_t column_count;
+	uint64_t row_count;
+	uint64_t columns_offset;	///< offset of the ColumnEntry array
+};
+static_assert(sizeof(TableEntry) == 32);
+
+struct ColumnEntry
+{
+	uint64_t name_offset;
+	uint32_t name_size;
+	ColumnType type;
+	uint64_t data_offset;
+	uint64_t data_size;
+};
+static_assert(sizeof(ColumnEntry) == 32);
+/// \}
+
+/**
+ * Type traits for values that can be stored in a column.
+ *
+ * Integers, floating point numbers, bool, enums, bitfields generated by
+ * dfs-codegen (stored as their underlying type) and std::string are
+ * supported.
+ */
+template <typename T>
+struct column_traits;
+
+namespace details {
+
+template <typename T>
+consteval ColumnType arithmetic_column_type()
+{
+	if constexpr (std::is_same_v<T, bool>)
+		return ColumnType::Bool;
+	else if constexpr (std::is_floating_point_v<T>)
+		return sizeof(T) == 4 ? ColumnType::Float32 : ColumnType::Float64;
+	else {
+		constexpr bool s = std::is_signed_v<T>;
+		switch (sizeof(T)) {
+		case 1: return s ? ColumnType::Int8 : ColumnType::UInt8;
+		case 2: return s ? ColumnType::Int16 : ColumnType::UInt16;
+		case 4: return s ? ColumnType::Int32 : ColumnType::UInt32;
+		case 8: return s ? ColumnType::Int64 : ColumnType::UInt64;
+		}
+	}
+}
+
+template <typename T>
+struct fixed_column_traits
+{
+	using storage_type = T;
+	static constexpr ColumnType type = arithmetic_column_type<T>();
+};
+
+} // namespace details
+
+template <typename T> requires std::is_arithmetic_v<T>
+	&& (std::is_floating_point_v<T> ? sizeof(T) == 4 || sizeof(T) == 8 : sizeof(T) <= 8)
+struct column_traits<T>: details::fixed_column_traits<T>
+{
+	static T get(T value) { return value; }
+};
+
+template <typename T> requires std::is_enum_v<T>
+struct column_traits<T>: details::fixed_column_traits<std::underlying_type_t<T>>
+{
+	static std::underlying_type_t<T> get(T value) {
+		return static_cast<std::underlying_type_t<T>>(value);
+	}
+};
+
+template <typename T> requires std::is_integral_v<typename T::underlying_type>
+	&& (sizeof(T) == sizeof(typename T::underlying_type))
+	&& std::is_trivially_copyable_v<T>
+struct column_traits<T>: details::fixed_column_traits<typename T::underlying_type>
+{
+	static typename T::underlying_type get(const T &value) {
+		return static_cast<typename T::underlying_type>(value);
+	}
+};
+
+template <>
+struct column_traits<std::string>
+{
+	static constexpr ColumnType type = ColumnType::String;
+};
+
+/**
+ * A type that can be stored in a column.
+ */
+template <typename T>
+concept ColumnValue = requires { column_traits<std::remove_cvref_t<T>>::type; };
+
+namespace details {
+
+/**
+ * Calls \p f with `std::type_identity<F>` for every Field type \p F in \p
+ * Reader or its bases.
+ */
+template <typename Reader, typename F>
+void for_each_field_type(F &&f)
+{
+	[&]<typename... Fields>(std::type_identity<std::tuple<Fields...>>) {
+		([&]() {
+			if constexpr (dfs::details::is_base_field<Fields>::value)
+				for_each_field_type<std::remove_pointer_t<decltype(Fields::reader)>>(f);
+			else if constexpr (requires { Fields::ptr; Fields::path; })
+				f(std::type_identity<Fields>{});
+		}(), ...);
+	}(std::type_identity<decltype(Reader::fields)>{});
+}
+
+/**
+ * \returns the path of the Field reading \p FieldPtr in \p Reader.
+ */
+template <auto FieldPtr, typename Reader>
+std::string field_name()
+{
+	static_assert(dfs::details::reader_has_field<FieldPtr, Reader>(), "member has no field");
+	std::string name;
+	for_each_field_type<Reader>([&]<typename F>(std::type_identity<F>) {
+		if constexpr (dfs::details::is_field_for<FieldPtr, F>())
+			name = path::to_string(F::path);
+	});
+	return name;
+}
+
+} // namespace details
+
+/**
+ * Builds a snapshot file from tables of objects.
+ *
+ * Tables are kept in memory until \ref write is called.
+ */
+class Writer
+{
+public:
+	struct Column
+	{
+		std::string name;
+		ColumnType type;
+		std::size_t rows = 0;
+		std::vector<uint8_t> data;
+		std::vector<uint64_t> string_ends; ///< end offsets of strings in data
+	};
+	struct Table
+	{
+		std::string name;
+		std::size_t rows;
+		std::vector<Column> columns;
+	};
+
+	/**
+	 * Adds an empty table with \p rows rows.
+	 *
+	 * The returned reference stays valid when other tables are added.
+	 */
+	Table &add_table(std::string name, std::size_t rows);
+
+	/**
+	 * Adds a column to \p table from \p values.
+	 *
+	 * \throws std::invalid_argument if the value count is different from
+	 * the table row count.
+	 */
+	template <std::ranges::input_range R> requires ColumnValue<std::ranges::range_value_t<R>>
+	static void add_column(Table &table, std::string name, R &&values)
+	{
+		using traits = column_traits<std::remove_cvref_t<std::ranges::range_value_t<R>>>;
+		auto &column = table.columns.emplace_back(std::move(name), traits::type);
+		for (const auto &value: values) {
+			if constexpr (traits::type == ColumnType::String) {
+				column.data.insert(column.data.end(), value.begin(), value.end());
+				column.string_ends.push_back(column.data.size());
+			}
+			else {
+				typename traits::storage_type v = traits::get(value);
+				auto pos = column.data.size();
+				column.data.resize(pos + sizeof(v));
+				std::memcpy(column.data.data() + pos, &v, sizeof(v));
+			}
+			++column.rows;
+		}
+		if (column.rows != table.rows) {
+			table.columns.pop_back();
+			throw std::invalid_argument("column size does not match the table row count");
+		}
+	}
+
+	/**
+	 * Adds a table with a row for each object in \p objects.
+	 *
+	 * There is a column for every Field in the compound reader of \p T (and
+	 * its bases) whose member satisfies ColumnValue. Members that are
+	 * structures are flattened, their column names are prefixed with the
+	 * member path. Other members are ignored.
+	 */
+	template <ReadableStructure T>
+	Table &add(std::string name, std::span<const T> objects)
+	{
+		auto &table = add_table(std::move(name), objects.size());
+		add_fields<compound_reader_type_t<T>>(table, "", objects, std::identity{});
+		return table;
+	}
+	/**
+	 * \overload
+	 */
+	template <ReadableStructure T>
+	Table &add(std::string name, const std::vector<T> &objects)
+	{
+		return add(std::move(name), std::span<const T>(objects));
+	}
+	/**
+	 * Adds a table with a row for each non-null object in \p pointers.
+	 *
+	 * DF object lists (e.g. `world.units.active`) are vectors of pointers,
+	 * they are read as ranges of `std::unique_ptr<T>` or
+	 * `std::shared_ptr<T>`. Columns are the same as for a range of `T`.
+	 */
+	template <std::ranges::input_range R, typename Ptr = std::remove_cvref_t<std::ranges::range_value_t<R>>>
+		requires ReadableStructure<typename pointer_reader_traits<Ptr>::value_type>
+	Table &add(std::string name, R &&pointers)
+	{
+		using T = typename pointer_reader_traits<Ptr>::value_type;
+		std::vector<const T *> objects;
+		for (const auto &ptr: pointers)
+			if (ptr)
+				objects.push_back(ptr.get());
+		auto &table = add_table(std::move(name), objects.size());
+		add_fields<compound_reader_type_t<T>>(table, "", std::span<const T *const>(objects),
+				[](const T *object) -> const T & { return *object; });
+		return table;
+	}
+
+	/**
+	 * Adds a table with an "address" column and a column for each member
+	 * of \p columns.
+	 */
+	template <ReadableStructure T, auto... FieldPtrs>
+	Table &add(std::string name, const Columns<T, FieldPtrs...> &columns)
+	{
+		auto &table = add_table(std::move(name), columns.size());
+		add_column(table, "address", columns.addresses | std::views::transform([](uintptr_t addr) {
+			return uint64_t(addr);
+		}));
+		(add_column(table,
+			details::field_name<FieldPtrs, compound_reader_type_t<T>>(),
+			columns.template column<FieldPtrs>()), ...);
+		return table;
+	}
+
+	const std::deque<Table> &tables() const { return _tables; }
+
+	/**
+	 * Writes the snapshot to \p out.
+	 *
+	 * \throws std::runtime_error if writing failed
+	 */
+	void write(std::ostream &out) const;
+	/**
+	 * Writes the snapshot to the file \p path.
+	 *
+	 * \throws std::runtime_error if writing failed
+	 */
+	void write(const std::filesystem::path &path) const;
+
+private:
+	std::deque<Table> _tables;
+
+	template <typename Reader, typename T, typename Get>
+	static void add_fields(Table &table, const std::string &prefix, std::span<const T> objects, Get get)
+	{
+		details::for_each_field_type<Reader>([&]<typename F>(std::type_identity<F>) {
+			using member_type = dfs::details::member_type_t<F::ptr>;
+			auto member = [get](const T &object) -> const member_type & {
+				return std::invoke(F::ptr, get(object));
+			};
+			auto name = prefix + path::to_string(F::path);
+			if constexpr (ColumnValue<member_type>)
+				add_column(table, std::move(name), objects | std::views::transform(member));
+			else if constexpr (ReadableStructure<member_type> && !std::is_union_v<member_type>)
+				add_fields<compound_reader_type_t<member_type>>(table, name + ".", objects, member);
+		});
+	}
+};
+
+/**
+ * Read-only access to a snapshot in memory (usually a memory-mapped file).
+ *
+ * Only the headers are parsed and checked, column data is accessed directly.
+ * The memory must outlive the view and be aligned to \ref Alignment.
+ */
+class View
+{
+public:
+	class Column
+	{
+	public:
+		std::string_view name() const { return _name; }
+		ColumnType type() const { return _type; }
+		std::size_t size() const { return _rows; }
+		/**
+		 * Raw column data.
+		 */
+		std::span<const uint8_t> data() const { return _data; }
+
+		/**
+		 * \returns the values of a fixed size column.
+		 *
+		 * \throws std::invalid_argument if the type of the column
+		 * does not match \p T
+		 */
+		template <typename T> requires (ColumnValue<T> && !std::is_same_v<T, std::string>)
+		std::span<const T> values() const {
+			using storage_type = typename column_traits<T>::storage_type;
+			static_assert(sizeof(T) == sizeof(storage_type));
+			if (column_traits<T>::type != _type)
+				throw std::invalid_argument("column type mismatch");
+			return {reinterpret_cast<const T *>(_data.data()), _rows};
+		}
+
+		/**
+		 * \returns the string at \p row from a string column.
+		 *
+		 * \throws std::invalid_argument if this is not a string column
+		 */
+		std::string_view string(std::size_t row) const;
+
+	private:
+		std::string_view _name;
+		ColumnType _type;
+		std::size_t _rows;
+		std::span<const uint8_t> _data;
+
+		friend class View;
+	};
+
+	class Table
+	{
+	public:
+		std::string_view name() const { return _name; }
+		std::size_t size() const { return _rows; }
+		const std::vector<Column> &columns() const { return _columns; }
+		/**
+		 * \returns the column named \p name or nullptr if it does not exist.
+		 */
+		const Column *column(std::string_view name) const;
+
+	private:
+		std::string_view _name;
+		std::size_t _rows;
+		std::vector<Column> _columns;
+
+		friend class View;
+	};
+
+	/**
+	 * Parses the headers of the snapshot in \p data.
+	 *
+	 * \throws std::runtime_error if the data is not a valid snapshot
+	 */
+	View(std::span<const uint8_t> data);
+
+	const std::vector<Table> &tables() const { return _tables; }
+	/**
+	 * \returns the table named \p name or nullptr if it does not exist.
+	 */
+	const Table *table(std::string_view name) const;
+
+private:
+	std::vector<Table> _tables;
+};
+
+} // namespace dfs::snapshot
+
+#endif
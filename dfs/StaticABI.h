@@ -0,0 +1,229 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_STATIC_ABI_H
+#define DFS_STATIC_ABI_H
+
+#include <dfs/ABI.h>
+
+namespace dfs {
+
+/**
+ * ABI known at compile time.
+ *
+ * It provides the decoding functions from ABI as static members, pointer
+ * width and container layouts are constants that can be inlined in the code
+ * instantiated for this ABI.
+ *
+ * \sa visit_abi()
+ *
+ * \ingroup memory_layout
+ */
+template <ABI::Arch arch, ABI::StdLib std_lib>
+struct StaticABI
+{
+	using uintptr_type = ABI::uintptr<arch>::type;
+
+	static constexpr ABI::Arch architecture = arch;
+	static constexpr ABI::StdLib std_library = std_lib;
+	static constexpr std::size_t pointer_size = sizeof(uintptr_type);
+
+	constexpr StaticABI() = default;
+	/**
+	 * Same as the default constructor, for code instantiated with either
+	 * StaticABI or DynamicABI.
+	 */
+	constexpr explicit StaticABI(const ABI &) {}
+
+	/**
+	 * \returns true if \p abi is this ABI.
+	 */
+	static bool matches(const ABI &abi) {
+		return abi.architecture == arch && abi.std_library == std_lib;
+	}
+
+	/**
+	 * \copydoc ABI::get_pointer
+	 */
+	static uintptr_t get_pointer(const uint8_t *data) {
+		return ABI::get_integer<uintptr_type>(data);
+	}
+	/**
+	 * \overload
+	 */
+	static uintptr_t get_pointer(MemoryView data) { return get_pointer(data.data.data()); }
+
+	/**
+	 * \copydoc ABI::decode_vector
+	 */
+	static ABI::vector_info decode_vector(MemoryView data, const TypeInfo &item_type_info) {
+		return ABI::decode_vector_common<arch>(data, item_type_info);
+	}
+
+	/**
+	 * \copydoc ABI::decode_df_array
+	 */
+	static ABI::vector_info decode_df_array(MemoryView data, std::size_t data_offset, std::size_t size_offset) {
+		return {{}, get_pointer(data.subview(data_offset)), ABI::get_integer<uint16_t>(data.subview(size_offset))};
+	}
+
+	/**
+	 * \returns true if decode_string can be used (strings are not
+	 * copy-on-write).
+	 */
+	static constexpr bool can_decode_string() {
+		return std_lib != ABI::StdLib::GNUCOW;
+	}
+
+	/**
+	 * \copydoc ABI::decode_string
+	 *
+	 * Only available if can_decode_string() is true.
+	 */
+	static ABI::string_info decode_string(MemoryView data) requires (std_lib != ABI::StdLib::GNUCOW) {
+		if constexpr (std_lib == ABI::StdLib::GNUCXX11)
+			return ABI::decode_string_gcc_sso<arch>(data);
+		else
+			return ABI::decode_string_msvc2015<arch>(data);
+	}
+
+	/**
+	 * \copydoc ABI::read_string
+	 */
+	static cppcoro::task<ABI::string_result> read_string(Process &process, MemoryView data) {
+		if constexpr (std_lib == ABI::StdLib::GNUCOW)
+			return ABI::read_string_gcc_cow<arch>(process, data);
+		else if constexpr (std_lib == ABI::StdLib::GNUCXX11)
+			return ABI::read_string_gcc_sso<arch>(process, data);
+		else
+			return ABI::read_string_msvc2015<arch>(process, data);
+	}
+
+	/**
+	 * \copydoc ABI::read_string_info
+	 */
+	static cppcoro::task<ABI::string_info> read_string_info(Process &process, MemoryView data) {
+		if constexpr (std_lib == ABI::StdLib::GNUCOW)
+			return ABI::read_string_info_gcc_cow<arch>(process, data);
+		else if constexpr (std_lib == ABI::StdLib::GNUCXX11)
+			return ABI::read_string_info_gcc_sso<arch>(process, data);
+		else
+			return ABI::read_string_info_msvc2015<arch>(process, data);
+	}
+};
+
+namespace static_abi {
+using GCC_32 = StaticABI<ABI::Arch::X86, ABI::StdLib::GNUCOW>;
+using GCC_64 = StaticABI<ABI::Arch::AMD64, ABI::StdLib::GNUCOW>;
+using GCC_CXX11_32 = StaticABI<ABI::Arch::X86, ABI::StdLib::GNUCXX11>;
+using GCC_CXX11_64 = StaticABI<ABI::Arch::AMD64, ABI::StdLib::GNUCXX11>;
+using MSVC2015_32 = StaticABI<ABI::Arch::X86, ABI::StdLib::MSVC2015>;
+using MSVC2015_64 = StaticABI<ABI::Arch::AMD64, ABI::StdLib::MSVC2015>;
+} // namespace static_abi
+
+/**
+ * ABI only known at run time with the same interface as StaticABI.
+ *
+ * Its functions are called through the ABI function pointers.
+ *
+ * \ingroup memory_layout
+ */
+class DynamicABI
+{
+	const ABI &_abi;
+
+public:
+	const std::size_t pointer_size;
+
+	DynamicABI(const ABI &abi):
+		_abi(abi),
+		pointer_size(abi.pointer.size)
+	{
+	}
+
+	uintptr_t get_pointer(const uint8_t *data) const { return _abi.get_pointer(data); }
+	uintptr_t get_pointer(MemoryView data) const { return _abi.get_pointer(data); }
+
+	ABI::vector_info decode_vector(MemoryView data, const TypeInfo &item_type_info) const {
+		return _abi.decode_vector(data, item_type_info);
+	}
+
+	ABI::vector_info decode_df_array(MemoryView data, std::size_t data_offset, std::size_t size_offset) const {
+		return _abi.decode_df_array(data, data_offset, size_offset);
+	}
+
+	bool can_decode_string() const { return _abi.decode_string != nullptr; }
+
+	ABI::string_info decode_string(MemoryView data) const {
+		return _abi.decode_string(data);
+	}
+
+	cppcoro::task<ABI::string_result> read_string(Process &process, MemoryView data) const {
+		return _abi.read_string(process, data);
+	}
+
+	cppcoro::task<ABI::string_info> read_string_info(Process &process, MemoryView data) const {
+		return _abi.read_string_info(process, data);
+	}
+};
+
+/**
+ * Calls \p f with the StaticABI matching \p abi if it was enabled at compile
+ * time, or with a DynamicABI wrapping \p abi otherwise.
+ *
+ * Static ABIs are enabled by defining `DFS_STATIC_ABI_<name>` (e.g.
+ * `DFS_STATIC_ABI_GCC_CXX11_64`), this is done by the `DFS_STATIC_ABIS` CMake
+ * option. Every enabled ABI adds an instantiation of \p f.
+ *
+ * \p f must return the same type for every ABI.
+ *
+ * \ingroup memory_layout
+ */
+template <typename F>
+decltype(auto) visit_abi(const ABI &abi, F &&f)
+{
+#ifdef DFS_STATIC_ABI_GCC_32
+	if (static_abi::GCC_32::matches(abi))
+		return std::forward<F>(f)(static_abi::GCC_32{});
+#endif
+#ifdef DFS_STATIC_ABI_GCC_64
+	if (static_abi::GCC_64::matches(abi))
+		return std::forward<F>(f)(static_abi::GCC_64{});
+#endif
+#ifdef DFS_STATIC_ABI_GCC_CXX11_32
+	if (static_abi::GCC_CXX11_32::matches(abi))
+		return std::forward<F>(f)(static_abi::GCC_CXX11_32{});
+#endif
+#ifdef DFS_STATIC_ABI_GCC_CXX11_64
+	if (static_abi::GCC_CXX11_64::matches(abi))
+		return std::forward<F>(f)(static_abi::GCC_CXX11_64{});
+#endif
+#ifdef DFS_STATIC_ABI_MSVC2015_32
+	if (static_abi::MSVC2015_32::matches(abi))
+		return std::forward<F>(f)(static_abi::MSVC2015_32{});
+#endif
+#ifdef DFS_STATIC_ABI_MSVC2015_64
+	if (static_abi::MSVC2015_64::matches(abi))
+		return std::forward<F>(f)(static_abi::MSVC2015_64{});
+#endif
+	return std::forward<F>(f)(DynamicABI{abi});
+}
+
+} // namespace dfs
+
+#endif
@@ -0,0 +1,215 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_STATIC_LAYOUT_READER_H
+#define DFS_STATIC_LAYOUT_READER_H
+
+#include <dfs/CompoundReader.h>
+#include <dfs/ItemReader.h>
+
+#include <algorithm>
+
+namespace dfs {
+
+namespace details {
+
+/**
+ * The fixed-width integer type a static field of type \p T is decoded as.
+ */
+template <typename T>
+struct static_integer { using type = T; };
+
+template <typename T> requires std::is_enum_v<T>
+struct static_integer<T> { using type = std::underlying_type_t<T>; };
+
+template <typename T> requires std::constructible_from<T, typename T::underlying_type>
+struct static_integer<T> { using type = typename T::underlying_type; };
+
+template <typename Rep, typename Period>
+struct static_integer<std::chrono::duration<Rep, Period>> { using type = Rep; };
+
+template <>
+struct static_integer<bool> { using type = uint8_t; };
+
+} // namespace details
+
+/**
+ * A Field whose offset is known at compile time for one version.
+ *
+ * The offset is still computed from the memory layout by Field::init,
+ * StaticLayoutStructureReader only uses \p Offset after checking they are the
+ * same.
+ *
+ * \sa StaticLayoutStructureReader
+ *
+ * \ingroup readers
+ */
+template <auto FieldPtr, static_string FieldPath, std::size_t Offset, auto... Discriminators>
+struct StaticField: Field<FieldPtr, FieldPath, Discriminators...>
+{
+	static constexpr std::size_t static_offset = Offset;
+	static constexpr std::string_view static_path = FieldPath.str();
+	/**
+	 * The field can be decoded directly from the structure data without
+	 * an asynchronous read.
+	 */
+	static constexpr bool decodable = sizeof...(Discriminators) == 0 &&
+			integral_like<details::member_type_t<FieldPtr>>::value;
+	/**
+	 * The integer type read at \p Offset when the field is decodable, its
+	 * size must match the runtime type size.
+	 */
+	using static_integer_type = details::static_integer<details::member_type_t<FieldPtr>>::type;
+};
+
+namespace details {
+
+template <typename F>
+concept StaticFieldReader = requires {
+	{ F::static_offset } -> std::convertible_to<std::size_t>;
+	{ F::static_path } -> std::convertible_to<std::string_view>;
+};
+
+template <typename F>
+concept DecodableStaticFieldReader = StaticFieldReader<F> && F::decodable;
+
+} // namespace details
+
+/**
+ * A CompoundReaderConcept implementation for structures with offsets computed
+ * at compile time for one version (as generated by `dfs-codegen
+ * --static-layout`).
+ *
+ * \p Version must have a static `id` member comparable to
+ * Structures::VersionInfo::id. \p Fields may contain StaticField along with
+ * any other field types accepted by StructureReader.
+ *
+ * When the factory version is \p Version and every StaticField offset and
+ * integer size matches the runtime layout, the decodable static fields are
+ * decoded synchronously with ABI::get_integer from their constant offsets and
+ * only the remaining fields are read as tasks (if there are none, no task is
+ * created). Otherwise (other version or mismatching layout), it reads like
+ * StructureReader using the runtime offsets.
+ *
+ * \ingroup readers
+ */
+template <typename T, static_string TypeName, typename Version, typename... Fields>
+struct StaticLayoutStructureReader: CompoundReaderBase<T, TypeName, Fields...>
+{
+	using output_type = T;
+
+	/**
+	 * true if the static offsets are used (set by setLayout).
+	 */
+	bool static_layout = false;
+
+	StaticLayoutStructureReader(const Structures &structures):
+		CompoundReaderBase<T, TypeName, Fields...>(structures)
+	{
+		if (this->type->is_union)
+			throw std::runtime_error(std::format("{} is a union (in {})",
+					this->type->debug_name, typeid(T).name()));
+	}
+
+	void setLayout(ReaderFactory &factory)
+	{
+		CompoundReaderBase<T, TypeName, Fields...>::setLayout(factory);
+		static_layout = std::ranges::equal(factory.version.id, Version::id);
+		if (!static_layout)
+			return;
+		((checkOffset(factory, get<Fields>(this->fields)) || (static_layout = false)), ...);
+	}
+
+	cppcoro::task<std::error_code> read(ReadSession &session, MemoryView data, T &out) const
+	{
+		std::vector<cppcoro::task<bool>> tasks;
+		if (static_layout) {
+			(decodeStatic<Fields>(data, out), ...);
+			if constexpr (async_field_count == 0)
+				co_return std::error_code{};
+			tasks.reserve(async_field_count);
+			([&](const auto &field) {
+				using F = std::remove_cvref_t<decltype(field)>;
+				if constexpr (!details::DecodableStaticFieldReader<F>)
+					tasks.push_back(field.read(session, data, out));
+			}(get<Fields>(this->fields)), ...);
+		}
+		else {
+			tasks.reserve(sizeof...(Fields));
+			(tasks.push_back(get<Fields>(this->fields).read(session, data, out)), ...);
+		}
+		auto res = co_await cppcoro::when_all(std::move(tasks));
+		if (!std::ranges::all_of(res, std::identity{}))
+			co_return ItemReaderError::InvalidField;
+		co_return std::error_code{};
+	}
+
+private:
+	/**
+	 * Number of fields still read as tasks when using the static layout.
+	 */
+	static constexpr std::size_t async_field_count =
+			(std::size_t(!details::DecodableStaticFieldReader<Fields>) + ... + 0);
+
+	template <typename F>
+	void decodeStatic(MemoryView data, T &out) const
+	{
+		if constexpr (details::DecodableStaticFieldReader<F>) {
+			using member_type = details::member_type_t<F::ptr>;
+			std::invoke(F::ptr, out) = ItemReader<member_type>::template decode_as<typename F::static_integer_type>(
+					data.data.data() + F::static_offset);
+		}
+	}
+
+	template <typename F>
+	bool checkOffset(ReaderFactory &factory, const F &field) const
+	{
+		if constexpr (details::StaticFieldReader<F>) {
+			if (field.reader && field.offset != F::static_offset) {
+				factory.log(std::format("static offset {} for {} in {} does not match the layout ({}), using dynamic offsets",
+						F::static_offset, F::static_path, this->type->debug_name,
+						field.offset));
+				return false;
+			}
+		}
+		if constexpr (details::DecodableStaticFieldReader<F>) {
+			if (!field.reader) {
+				factory.log(std::format("static field {} in {} has no reader, using dynamic offsets",
+						F::static_path, this->type->debug_name));
+				return false;
+			}
+			if (field.reader->size() != sizeof(typename F::static_integer_type)) {
+				factory.log(std::format("static field {} in {} has size {} but the layout uses {}, using dynamic offsets",
+						F::static_path, this->type->debug_name,
+						sizeof(typename F::static_integer_type), field.reader->size()));
+				return false;
+			}
+		}
+		return true;
+	}
+};
+
+template <typename T, static_string TypeName, typename Version, typename... Fields> requires requires { typename details::find_base_field<Fields...>::type; }
+struct compound_reader_parent<StaticLayoutStructureReader<T, TypeName, Version, Fields...>>
+{
+	using type = typename details::find_base_field<Fields...>::type;
+};
+
+} // namespace dfs
+
+#endif
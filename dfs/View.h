@@ -0,0 +1,406 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_VIEW_H
+#define DFS_VIEW_H
+
+#include <dfs/CompoundReader.h>
+#include <dfs/ItemReader.h>
+
+#include <cassert>
+#include <cstring>
+#include <iterator>
+#include <string_view>
+
+namespace dfs {
+
+/**
+ * \defgroup views Views
+ *
+ * Views reference pinned process memory (see Process::pin) and decode
+ * values only when they are accessed. More information in \ref views.
+ *
+ * \ingroup readers
+ * \{
+ */
+
+/**
+ * A view over a structure \p T in pinned process memory.
+ *
+ * Members are decoded on access using the fields from the compound reader of
+ * \p T. Only members with a Field in the compound reader (or one of its Base)
+ * are accessible.
+ *
+ * A default constructed view (or a view read from a null pointer) is empty.
+ */
+template <ReadableStructure T>
+class View
+{
+public:
+	using reader_type = compound_reader_type_t<T>;
+
+	View() = default;
+	View(const reader_type *reader, PinnedMemory memory):
+		_reader(reader),
+		_memory(std::move(memory))
+	{
+	}
+
+	/**
+	 * \returns false if the view is empty.
+	 */
+	explicit operator bool() const { return _reader != nullptr; }
+
+	/**
+	 * Address of the viewed object.
+	 */
+	uintptr_t address() const { return _memory.address(); }
+
+	/**
+	 * Raw memory of the viewed object.
+	 */
+	const PinnedMemory &memory() const { return _memory; }
+
+	/**
+	 * Decodes the member \p FieldPtr.
+	 *
+	 * Integral-like members are returned by value, structure members are
+	 * returned as a View sharing the same memory.
+	 *
+	 * \throws std::system_error if the field reader failed to initialize
+	 */
+	template <auto FieldPtr> requires
+		ReadableStructure<details::member_type_t<FieldPtr>> ||
+		DecodableType<details::member_type_t<FieldPtr>>
+	auto get() const
+	{
+		using M = details::member_type_t<FieldPtr>;
+		return details::visit_field<FieldPtr>(*_reader, [this](const auto &field) {
+			if (!field.reader)
+				throw std::system_error(ItemReaderError::InvalidField);
+			auto data = _memory.subview(field.offset, field.reader->size());
+			if constexpr (ReadableStructure<M>)
+				return View<M>(field.reader->compound_reader(), std::move(data));
+			else
+				return field.reader->decode(data);
+		});
+	}
+
+	/**
+	 * Reads the member \p FieldPtr using its ItemReader.
+	 *
+	 * This is required for members that need to read more memory
+	 * (containers, pointers, ...). The view must be kept alive until the
+	 * returned task completes.
+	 *
+	 * \returns the read error, or ItemReaderError::InvalidField if the
+	 * field reader failed to initialize
+	 */
+	template <auto FieldPtr>
+	cppcoro::task<std::error_code> read(ReadSession &session, details::member_type_t<FieldPtr> &out) const
+	{
+		return details::visit_field<FieldPtr>(*_reader, [&, this](const auto &field) -> cppcoro::task<std::error_code> {
+			if (!field.reader)
+				return details::error_task(ItemReaderError::InvalidField);
+			return (*field.reader)(session, _memory.subview(field.offset), out);
+		});
+	}
+
+private:
+	const reader_type *_reader = nullptr;
+	PinnedMemory _memory;
+};
+
+/**
+ * A view over the items of a vector of integral-like values in pinned
+ * process memory.
+ *
+ * Items are decoded when accessed. \p T must have the same size as the DF
+ * item type.
+ */
+template <typename T> requires (integral_like<T>::value && std::is_trivially_copyable_v<T>)
+class VectorView
+{
+public:
+	using value_type = T;
+
+	class iterator
+	{
+		const uint8_t *_ptr = nullptr;
+	public:
+		using value_type = T;
+		using difference_type = std::ptrdiff_t;
+
+		iterator() = default;
+		explicit iterator(const uint8_t *ptr): _ptr(ptr) {}
+
+		T operator*() const {
+			T value;
+			std::memcpy(&value, _ptr, sizeof(T));
+			return value;
+		}
+		iterator &operator++() { _ptr += sizeof(T); return *this; }
+		iterator operator++(int) { auto it = *this; _ptr += sizeof(T); return it; }
+		bool operator==(const iterator &) const = default;
+	};
+
+	VectorView() = default;
+	explicit VectorView(PinnedMemory memory):
+		_memory(std::move(memory))
+	{
+		assert(_memory.size() % sizeof(T) == 0);
+	}
+
+	std::size_t size() const { return _memory.size() / sizeof(T); }
+	bool empty() const { return _memory.empty(); }
+
+	T operator[](std::size_t index) const {
+		return *iterator(_memory.data().data() + index*sizeof(T));
+	}
+
+	iterator begin() const { return iterator(_memory.data().data()); }
+	iterator end() const { return iterator(_memory.data().data() + _memory.size()); }
+
+	/**
+	 * Raw memory of the items.
+	 */
+	const PinnedMemory &memory() const { return _memory; }
+
+private:
+	PinnedMemory _memory;
+};
+
+/**
+ * A view over the characters of a string in pinned process memory.
+ */
+class StringView
+{
+public:
+	StringView() = default;
+	explicit StringView(PinnedMemory memory):
+		_memory(std::move(memory))
+	{
+	}
+
+	std::size_t size() const { return _memory.size(); }
+	bool empty() const { return _memory.empty(); }
+
+	std::string_view str() const {
+		return {reinterpret_cast<const char *>(_memory.data().data()), _memory.size()};
+	}
+	operator std::string_view() const { return str(); }
+
+	/**
+	 * Raw memory of the characters.
+	 */
+	const PinnedMemory &memory() const { return _memory; }
+
+private:
+	PinnedMemory _memory;
+};
+
+/// \}
+
+/**
+ * Reader for View.
+ *
+ * It accepts the compound for \p T or a pointer to it. A null pointer gives an
+ * empty view.
+ *
+ * \ingroup readers
+ */
+template <ReadableStructure T>
+class ItemReader<View<T>>
+{
+	const compound_reader_type_t<T> *_compound_reader;
+	bool _is_pointer;
+	std::size_t _size;
+
+public:
+	using output_type = View<T>;
+
+	ItemReader(ReaderFactory &factory, AnyTypeRef type):
+		_compound_reader(factory.getCompoundReader<T>()),
+		_is_pointer([&]() {
+			if (_compound_reader->type == type.get_if<Compound>())
+				return false;
+			if (auto pointer = type.get_if<PointerType>()) {
+				if (pointer->type_params.size() != 1)
+					throw std::invalid_argument("PointerType requires 1 type parameter");
+				if (_compound_reader->type == pointer->itemType().get_if<Compound>())
+					return true;
+			}
+			throw TypeError(type, typeid(output_type), "invalid type");
+		}()),
+		_size(_is_pointer
+			? factory.abi.pointer.size
+			: _compound_reader->info.size)
+	{
+	}
+
+	std::size_t size() const {
+		return _size;
+	}
+
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, View<T> &out) const
+	{
+		auto addr = _is_pointer
+			? session.visit_abi([&](auto abi) { return abi.get_pointer(data); })
+			: data.address;
+		if (addr == 0) {
+			out = {};
+			co_return std::error_code{};
+		}
+		PinnedMemory memory;
+		if (auto err = co_await session.process().pin(addr, _compound_reader->info.size, memory))
+			co_return err;
+		out = View<T>(_compound_reader, std::move(memory));
+		co_return std::error_code{};
+	}
+};
+
+/**
+ * Reader for VectorView.
+ *
+ * It accepts StdContainer::StdVector and DFContainer::DFArray whose items can
+ * be read as \p T with the same size.
+ *
+ * \ingroup readers
+ */
+template <typename T>
+class ItemReader<VectorView<T>>
+{
+	AnyTypeRef _container_type;
+	std::size_t _size;
+	TypeInfo _item_info;
+	const CompoundLayout *_compound_layout = nullptr;
+
+public:
+	using output_type = VectorView<T>;
+
+	ItemReader(ReaderFactory &factory, AnyTypeRef type):
+		_container_type(type),
+		_size(factory.layout.getTypeInfo(type).size),
+		_item_info(factory.layout.getTypeInfo(type.visit(overloaded{
+			[](const StdContainer &container) -> AnyTypeRef {
+				switch (container.container_type) {
+				case StdContainer::StdVector:
+					return container.itemType();
+				default:
+					throw TypeError(container, typeid(output_type), "incompatible container");
+				}
+			},
+			[](const DFContainer &container) -> AnyTypeRef {
+				switch (container.container_type) {
+				case DFContainer::DFArray:
+					return container.itemType();
+				default:
+					throw TypeError(container, typeid(output_type), "incompatible container");
+				}
+			},
+			[&](const AbstractType &) -> AnyTypeRef {
+				throw TypeError(type, typeid(output_type), "incompatible container");
+			}
+		})))
+	{
+		AnyTypeRef item_type = type.get_if<Container>()->itemType();
+		ItemReader<T> item_reader(factory, item_type); // check item type compatibility
+		if (_item_info.size != sizeof(T))
+			throw TypeError(item_type, typeid(T), std::format("item size mismatch ({}, must be {})", sizeof(T), _item_info.size));
+		if (auto container = type.get_if<DFContainer>())
+			_compound_layout = &factory.layout.compound_layout.at(container->compound.get());
+	}
+
+	std::size_t size() const {
+		return _size;
+	}
+
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, VectorView<T> &out) const
+	{
+		auto [err, addr, len] = session.visit_abi([&, this](auto abi) {
+			return _compound_layout
+				? abi.decode_df_array(data,
+					_compound_layout->member_offsets.at(DFContainer::DFArrayData),
+					_compound_layout->member_offsets.at(DFContainer::DFArraySize))
+				: abi.decode_vector(data, _item_info);
+		});
+		if (err)
+			co_return err;
+		if (len == 0) {
+			out = {};
+			co_return std::error_code{};
+		}
+		PinnedMemory memory;
+		if (auto err = co_await session.process().pin(addr, len * sizeof(T), memory))
+			co_return err;
+		out = VectorView<T>(std::move(memory));
+		co_return std::error_code{};
+	}
+};
+
+/**
+ * Reader for StringView.
+ *
+ * It accepts PrimitiveType::StdString types.
+ *
+ * \ingroup readers
+ */
+template <>
+class ItemReader<StringView>
+{
+	std::size_t _size;
+
+public:
+	using output_type = StringView;
+
+	ItemReader(ReaderFactory &factory, AnyTypeRef type):
+		_size([&]() {
+			auto primitive_type = type.get_if<PrimitiveType>();
+			if (!primitive_type)
+				throw TypeError(type, typeid(StringView), "not a primitive type");
+			if (primitive_type->type != PrimitiveType::StdString)
+				throw TypeError(*primitive_type, typeid(StringView), "not a std::string");
+			return factory.abi.primitive_type(PrimitiveType::StdString).size;
+		}())
+	{
+	}
+
+	std::size_t size() const {
+		return _size;
+	}
+
+	cppcoro::task<std::error_code> operator()(ReadSession &session, MemoryView data, StringView &out) const
+	{
+		auto info = co_await session.visit_abi([&](auto abi) {
+			return details::read_string_info(abi, session, data);
+		});
+		if (info.err)
+			co_return info.err;
+		PinnedMemory memory;
+		if (info.size != 0) {
+			if (auto err = co_await session.process().pin(info.data, info.size, memory))
+				co_return err;
+		}
+		out = StringView(std::move(memory));
+		co_return std::error_code{};
+	}
+};
+
+} // namespace dfs
+
+#endif
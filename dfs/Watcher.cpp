@@ -0,0 +1,78 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "Watcher.h"
+
+#include <condition_variable>
+#include <mutex>
+
+using namespace dfs;
+
+Watcher::Watcher(ReaderFactory &factory, Process &process, bool stop_process):
+	log([this](std::string_view str){_factory.log(str);}),
+	_factory(factory),
+	_process(process),
+	_stop_process(stop_process)
+{
+}
+
+void Watcher::add(std::unique_ptr<watch_base> &&watch)
+{
+	_buffers.push_back(watch->data);
+	_watches.push_back(std::move(watch));
+}
+
+bool Watcher::poll()
+{
+	ReadSession session(_factory, _process, _stop_process);
+	session.log = log;
+	return session.sync(update(session));
+}
+
+cppcoro::task<> Watcher::update(ReadSession &session)
+{
+	if (_watches.empty())
+		co_return;
+	if (auto err = co_await session.process().readv(_buffers))
+		throw std::system_error(err);
+	std::vector<cppcoro::task<std::error_code>> tasks;
+	tasks.reserve(_watches.size());
+	for (auto &watch: _watches)
+		tasks.push_back(watch->update(session));
+	// each watch keeps its own state, so that a failing watch does not
+	// trigger the callbacks of the others again
+	if (auto err = co_await details::when_all_errors(std::move(tasks)))
+		throw std::system_error(err);
+}
+
+void Watcher::run(std::chrono::steady_clock::duration period, std::stop_token stop)
+{
+	// only used for waking up the loop when stop is requested
+	std::mutex mutex;
+	std::condition_variable_any cv;
+	std::unique_lock lock(mutex);
+	auto next = std::chrono::steady_clock::now();
+	while (!stop.stop_requested()) {
+		static_cast<void>(poll()); // errors are already logged
+		next += period;
+		// do not try to catch up after an overrun
+		if (auto now = std::chrono::steady_clock::now(); next < now)
+			next = now + period;
+		cv.wait_until(lock, stop, next, []{ return false; });
+	}
+}
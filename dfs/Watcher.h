@@ -0,0 +1,201 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_WATCHER_H
+#define DFS_WATCHER_H
+
+#include <dfs/ItemReader.h>
+
+#include <chrono>
+#include <cstring>
+#include <stop_token>
+
+namespace dfs {
+
+/**
+ * Polls a set of values and calls a callback when they change.
+ *
+ * Pointers and readers are resolved once when a value is added with \ref
+ * watch. Each call to \ref poll creates a session, reads the memory of every
+ * watched value in a single Process::readv call and decodes it.
+ *
+ * Values whose ItemReader satisfies DecodableType (or that are not equality
+ * comparable) are only decoded when their raw memory changes. Other values
+ * (e.g. strings or containers) may depend on other memory, they are decoded on
+ * every poll and compared with their previous value.
+ *
+ * Callbacks are called on the first poll and then only when the value
+ * changes.
+ *
+ * \ingroup readers
+ */
+class Watcher
+{
+public:
+	/**
+	 * Constructs a watcher using \p factory and reading memory from \p
+	 * process.
+	 *
+	 * \p stop_process is passed to ReadSession. Not stopping the process
+	 * makes polling cheaper but the values may change while being read.
+	 */
+	Watcher(ReaderFactory &factory, Process &process, bool stop_process = true);
+
+	Watcher(const Watcher &) = delete;
+	Watcher &operator=(const Watcher &) = delete;
+
+	/**
+	 * Watches the value of type \p T at \p ptr.
+	 *
+	 * \p callback is called with the new value (`const T &`).
+	 *
+	 * \throws TypeError std::runtime_error if no reader can be made for \p T
+	 */
+	template <ReadableType T, typename F> requires std::invocable<F, const T &>
+	void watch(Pointer ptr, F &&callback)
+	{
+		add(std::make_unique<watch_t<T, std::decay_t<F>>>(
+				_factory, ptr, std::forward<F>(callback)));
+	}
+
+	/**
+	 * Watches the value of type \p T at the global path \p path.
+	 *
+	 * \throws std::invalid_argument if the path is invalid
+	 */
+	template <ReadableType T, Path Rng, typename F> requires std::invocable<F, const T &>
+	void watch(Rng &&path, F &&callback)
+	{
+		watch<T>(Pointer::fromGlobal(
+					_factory.structures,
+					_factory.version,
+					_factory.layout,
+					std::forward<Rng>(path),
+					&_process),
+				std::forward<F>(callback));
+	}
+
+	/**
+	 * Reads all watched values once and calls the callbacks of the values
+	 * that changed.
+	 *
+	 * Errors are logged using \ref log.
+	 *
+	 * \returns false if reading failed
+	 */
+	[[nodiscard]] bool poll();
+
+	/**
+	 * Calls \ref poll every \p period until \p stop is requested.
+	 *
+	 * A stop request interrupts the wait between two polls.
+	 */
+	void run(std::chrono::steady_clock::duration period, std::stop_token stop);
+
+	/**
+	 * Log function for sessions created by the watcher (defaults to
+	 * ReaderFactory::log).
+	 */
+	std::function<void (std::string_view)> log;
+
+private:
+	struct watch_base
+	{
+		MemoryBuffer data, previous;
+		bool first = true;
+
+		watch_base(uintptr_t address, std::size_t size):
+			data(address, size),
+			previous(address, size)
+		{
+		}
+		virtual ~watch_base() = default;
+
+		bool raw_changed() const {
+			return first || std::memcmp(data.data(), previous.data(), data.size()) != 0;
+		}
+
+		/**
+		 * Remembers the current data once it was successfully
+		 * decoded, failed watches are retried on the next poll.
+		 */
+		void commit() {
+			std::memcpy(previous.data(), data.data(), data.size());
+			first = false;
+		}
+
+		virtual cppcoro::task<std::error_code> update(ReadSession &session) = 0;
+	};
+
+	template <typename T, typename F>
+	struct watch_t: watch_base
+	{
+		ItemReader<T> reader;
+		F callback;
+		T value;
+
+		template <typename G>
+		watch_t(ReaderFactory &factory, Pointer ptr, G &&callback):
+			watch_t(factory.make_item_reader<T>(ptr.type), ptr.address, F(std::forward<G>(callback)))
+		{
+		}
+
+		watch_t(ItemReader<T> &&reader, uintptr_t address, F &&callback):
+			watch_base(address, reader.size()),
+			reader(std::move(reader)),
+			callback(std::move(callback))
+		{
+		}
+
+		~watch_t() override = default;
+
+		cppcoro::task<std::error_code> update(ReadSession &session) override
+		{
+			if constexpr (DecodableType<T> || !std::equality_comparable<T>) {
+				if (!raw_changed())
+					co_return std::error_code{};
+				if (auto err = co_await reader(session, data, value))
+					co_return err;
+			}
+			else {
+				T new_value;
+				if (auto err = co_await reader(session, data, new_value))
+					co_return err;
+				if (!first && new_value == value)
+					co_return std::error_code{};
+				value = std::move(new_value);
+			}
+			commit();
+			std::invoke(callback, std::as_const(value));
+			co_return std::error_code{};
+		}
+	};
+
+	ReaderFactory &_factory;
+	Process &_process;
+	bool _stop_process;
+	std::vector<std::unique_ptr<watch_base>> _watches;
+	std::vector<MemoryBufferRef> _buffers;
+
+	void add(std::unique_ptr<watch_base> &&watch);
+	cppcoro::task<> update(ReadSession &session);
+};
+
+} // namespace dfs
+
+#endif
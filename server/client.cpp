@@ -0,0 +1,127 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "protocol.h"
+
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <system_error>
+
+extern "C" {
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+using namespace dfs::server;
+
+static constexpr const char *usage = R"(Usage: {} socket_path path [field...]
+
+Queries a dfs-server for the object at path (or every item if it is a
+vector), and prints the given fields (or the raw object).
+)";
+
+static std::string format_field(std::span<const uint8_t> data)
+{
+	auto get = [&]<typename T>(std::in_place_type_t<T>) {
+		T value;
+		std::memcpy(&value, data.data(), sizeof(T));
+		return std::format("{}", value);
+	};
+	switch (data.size()) {
+	case 1: return get(std::in_place_type<int8_t>);
+	case 2: return get(std::in_place_type<int16_t>);
+	case 4: return get(std::in_place_type<int32_t>);
+	case 8: return get(std::in_place_type<int64_t>);
+	default: {
+		std::string str;
+		for (auto byte: data)
+			str += std::format("{:02x}", byte);
+		return str;
+	}
+	}
+}
+
+int main(int argc, char *argv[]) try
+{
+	if (argc < 3) {
+		std::cerr << std::format(usage, argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (std::strlen(argv[1]) >= sizeof(addr.sun_path)) {
+		std::cerr << "Socket path is too long\n";
+		return EXIT_FAILURE;
+	}
+	std::strcpy(addr.sun_path, argv[1]);
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		throw std::system_error(errno, std::system_category(), "socket");
+	if (connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1)
+		throw std::system_error(errno, std::system_category(), "connect");
+
+	Request request = {1, argv[2], {argv+3, argv+argc}};
+	std::vector<uint8_t> buffer;
+	encode(request, buffer);
+	for (std::size_t sent = 0; sent < buffer.size(); ) {
+		auto len = send(fd, buffer.data()+sent, buffer.size()-sent, MSG_NOSIGNAL);
+		if (len == -1)
+			throw std::system_error(errno, std::system_category(), "send");
+		sent += len;
+	}
+
+	buffer.clear();
+	Response response;
+	while (true) {
+		uint8_t tmp[4096];
+		auto len = recv(fd, tmp, sizeof(tmp), 0);
+		if (len == -1)
+			throw std::system_error(errno, std::system_category(), "recv");
+		if (len == 0) {
+			std::cerr << "Connection closed\n";
+			return EXIT_FAILURE;
+		}
+		buffer.insert(buffer.end(), tmp, tmp+len);
+		if (decode(buffer, response) != 0)
+			break;
+	}
+	close(fd);
+
+	if (response.status != Status::Ok) {
+		std::cerr << std::format("Error {}: {}\n", static_cast<uint32_t>(response.status), response.message);
+		return EXIT_FAILURE;
+	}
+	auto row_size = response.row_size();
+	for (std::size_t i = 0; i < response.addresses.size(); ++i) {
+		std::cout << std::format("{:#x}", response.addresses[i]);
+		auto row = std::span(response.data).subspan(i * row_size, row_size);
+		for (auto field_size: response.field_sizes) {
+			std::cout << "\t" << format_field(row.first(field_size));
+			row = row.subspan(field_size);
+		}
+		std::cout << "\n";
+	}
+	return EXIT_SUCCESS;
+}
+catch (std::exception &e) {
+	std::cerr << std::format("Error: {}\n", e.what());
+	return EXIT_FAILURE;
+}
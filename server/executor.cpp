@@ -0,0 +1,187 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "executor.h"
+
+#include <cppcoro/when_all.hpp>
+
+#include <cassert>
+#include <limits>
+
+using namespace dfs;
+using namespace dfs::server;
+
+Executor::Executor(ReaderFactory &factory, Process &process):
+	factory(factory),
+	process(process)
+{
+}
+
+void Executor::execute(std::span<const Request> requests, std::span<Response> responses)
+{
+	assert(requests.size() == responses.size());
+	ReadSession session(factory, process);
+	std::vector<cppcoro::task<>> tasks;
+	tasks.reserve(requests.size());
+	for (std::size_t i = 0; i < requests.size(); ++i)
+		tasks.push_back(execute(session, requests[i], responses[i]));
+	if (!session.sync(cppcoro::when_all(std::move(tasks)))) {
+		// execute catches its own errors, this should not happen
+		for (auto &response: responses)
+			set_error(response, Status::ReadError, "session failed");
+	}
+}
+
+void Executor::set_error(Response &response, Status status, std::string_view message)
+{
+	response.status = status;
+	response.message = message;
+	response.field_sizes.clear();
+	response.addresses.clear();
+	response.data.clear();
+}
+
+cppcoro::task<> Executor::execute(ReadSession &session, const Request &request, Response &response)
+{
+	response.id = request.id;
+	try {
+		co_await query(session, request, response);
+	}
+	catch (std::system_error &e) {
+		set_error(response, Status::ReadError, e.what());
+	}
+	catch (std::invalid_argument &e) {
+		set_error(response, Status::InvalidPath, e.what());
+	}
+	catch (std::exception &e) {
+		set_error(response, Status::InvalidRequest, e.what());
+	}
+}
+
+// Finds the items pointed by the path: the object itself or the
+// items of a vector/array.
+cppcoro::task<std::tuple<AnyTypeRef, std::vector<uintptr_t>>> Executor::find_items(ReadSession &session, Pointer ptr)
+{
+	const auto &abi = session.abi();
+	const auto &layout = factory.layout;
+	const Container *container = nullptr;
+	uintptr_t data_addr = 0;
+	std::size_t len = 0;
+	if (auto vector = ptr.type.get_if<StdContainer>();
+			vector && vector->container_type == StdContainer::StdVector) {
+		MemoryBuffer data(ptr.address, layout.getTypeInfo(ptr.type).size);
+		if (auto err = co_await session.process().read(data))
+			throw std::system_error(err);
+		auto vec_info = abi.decode_vector(data, layout.getTypeInfo(vector->itemType()));
+		if (vec_info.err)
+			throw std::system_error(vec_info.err);
+		container = vector;
+		data_addr = vec_info.data;
+		len = vec_info.size;
+	}
+	else if (auto array = ptr.type.get_if<DFContainer>();
+			array && array->container_type == DFContainer::DFArray) {
+		MemoryBuffer data(ptr.address, layout.getTypeInfo(ptr.type).size);
+		if (auto err = co_await session.process().read(data))
+			throw std::system_error(err);
+		const auto &array_layout = layout.compound_layout.at(array->compound.get());
+		container = array;
+		auto array_info = abi.decode_df_array(data,
+				array_layout.member_offsets.at(DFContainer::DFArrayData),
+				array_layout.member_offsets.at(DFContainer::DFArraySize));
+		data_addr = array_info.data;
+		len = array_info.size;
+	}
+	if (!container)
+		co_return std::tuple{ptr.type, std::vector<uintptr_t>{ptr.address}};
+
+	AnyTypeRef item_type = container->itemType();
+	auto item_size = layout.getTypeInfo(item_type).size;
+	std::vector<uintptr_t> addresses;
+	if (auto pointer = item_type.get_if<PointerType>()) {
+		if (pointer->type_params.empty())
+			throw std::invalid_argument("unknown pointer item type");
+		MemoryBuffer pointers(data_addr, len * item_size);
+		if (len > 0)
+			if (auto err = co_await session.process().read(pointers))
+				throw std::system_error(err);
+		addresses.reserve(len);
+		factory.visit_abi([&](auto abi) {
+			for (std::size_t i = 0; i < len; ++i)
+				if (auto object = abi.get_pointer(pointers.view(i * abi.pointer_size)))
+					addresses.push_back(object);
+		});
+		co_return std::tuple{AnyTypeRef(pointer->itemType()), std::move(addresses)};
+	}
+	else {
+		addresses.resize(len);
+		for (std::size_t i = 0; i < len; ++i)
+			addresses[i] = data_addr + i * item_size;
+		co_return std::tuple{item_type, std::move(addresses)};
+	}
+}
+
+cppcoro::task<> Executor::query(ReadSession &session, const Request &request, Response &response)
+{
+	const auto &layout = factory.layout;
+	auto [item_type, addresses] = co_await find_items(session, session.getGlobal(parse_path(request.path)));
+
+	// Resolve field offsets, no fields means the whole item
+	std::vector<std::size_t> offsets;
+	if (request.fields.empty()) {
+		offsets.push_back(0);
+		response.field_sizes.push_back(layout.getTypeInfo(item_type).size);
+	}
+	else {
+		auto compound = item_type.get_if<Compound>();
+		if (!compound)
+			throw std::invalid_argument("fields require a compound item type");
+		for (const auto &field: request.fields) {
+			auto [type, offset] = layout.getOffset(*compound, parse_path(field));
+			offsets.push_back(offset);
+			response.field_sizes.push_back(layout.getTypeInfo(type).size);
+		}
+	}
+
+	// Read the span covering all fields for every item
+	std::size_t span_begin = std::numeric_limits<std::size_t>::max(), span_end = 0;
+	for (std::size_t i = 0; i < offsets.size(); ++i) {
+		span_begin = std::min(span_begin, offsets[i]);
+		span_end = std::max(span_end, offsets[i] + response.field_sizes[i]);
+	}
+	auto span_size = span_end - span_begin;
+	auto rows = addresses.size();
+	MemoryBuffer spans(0, rows * span_size);
+	std::vector<MemoryBufferRef> refs(rows);
+	for (std::size_t i = 0; i < rows; ++i)
+		refs[i] = {addresses[i] + span_begin, {spans.data() + i * span_size, span_size}};
+	if (rows > 0 && span_size > 0)
+		if (auto err = co_await session.process().readv(refs))
+			throw std::system_error(err);
+
+	// Copy fields row by row
+	auto row_size = response.row_size();
+	response.data.resize(rows * row_size);
+	auto out = response.data.begin();
+	for (std::size_t i = 0; i < rows; ++i)
+		for (std::size_t j = 0; j < offsets.size(); ++j) {
+			auto field = refs[i].data.subspan(offsets[j] - span_begin, response.field_sizes[j]);
+			out = std::ranges::copy(field, out).out;
+		}
+	response.addresses.assign(addresses.begin(), addresses.end());
+}
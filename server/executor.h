@@ -0,0 +1,57 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_SERVER_EXECUTOR_H
+#define DFS_SERVER_EXECUTOR_H
+
+#include "protocol.h"
+
+#include <dfs/Reader.h>
+
+namespace dfs::server {
+
+/**
+ * Answers batches of requests from a process.
+ */
+class Executor
+{
+public:
+	Executor(ReaderFactory &factory, Process &process);
+
+	/**
+	 * Answers all \p requests using the same session.
+	 *
+	 * \p responses must have the same size as \p requests, \p responses[i]
+	 * is set to the answer to \p requests[i]. Session messages are logged
+	 * with ReaderFactory::log.
+	 */
+	void execute(std::span<const Request> requests, std::span<Response> responses);
+
+private:
+	ReaderFactory &factory;
+	Process &process;
+
+	static void set_error(Response &response, Status status, std::string_view message);
+	cppcoro::task<> execute(ReadSession &session, const Request &request, Response &response);
+	cppcoro::task<std::tuple<AnyTypeRef, std::vector<uintptr_t>>> find_items(ReadSession &session, Pointer ptr);
+	cppcoro::task<> query(ReadSession &session, const Request &request, Response &response);
+};
+
+} // namespace dfs::server
+
+#endif
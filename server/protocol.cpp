@@ -0,0 +1,218 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "protocol.h"
+
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
+
+using namespace dfs::server;
+
+namespace {
+
+// All integers are little-endian (the native order on supported platforms).
+class Writer
+{
+	std::vector<uint8_t> &_out;
+	std::size_t _frame_start;
+	bool _finished = false;
+
+public:
+	Writer(std::vector<uint8_t> &out):
+		_out(out),
+		_frame_start(out.size())
+	{
+		put<uint32_t>(0); // frame size, updated by finish()
+	}
+
+	~Writer() {
+		// Remove incomplete frames
+		if (!_finished)
+			_out.resize(_frame_start);
+	}
+
+	template <typename T> requires std::is_arithmetic_v<T>
+	void put(T value) {
+		auto pos = _out.size();
+		_out.resize(pos + sizeof(T));
+		std::memcpy(_out.data() + pos, &value, sizeof(T));
+	}
+
+	void put_bytes(std::span<const uint8_t> bytes) {
+		_out.insert(_out.end(), bytes.begin(), bytes.end());
+	}
+
+	// Writes a size or count, throws if it does not fit in Size
+	template <typename Size>
+	void put_size(std::size_t size) {
+		if (size > std::numeric_limits<Size>::max())
+			throw std::length_error("value is too big for the protocol");
+		put<Size>(size);
+	}
+
+	void put_string(const std::string &str) {
+		put_size<uint32_t>(str.size());
+		put_bytes({reinterpret_cast<const uint8_t *>(str.data()), str.size()});
+	}
+
+	// Writes the frame size, throws if the payload is bigger than max_size
+	void finish(std::size_t max_size = std::numeric_limits<uint32_t>::max()) {
+		auto size = _out.size() - _frame_start - sizeof(uint32_t);
+		if (size > max_size)
+			throw std::length_error("frame is too big");
+		uint32_t size32 = size;
+		std::memcpy(_out.data() + _frame_start, &size32, sizeof(size32));
+		_finished = true;
+	}
+};
+
+class Reader
+{
+	std::span<const uint8_t> _data;
+
+public:
+	Reader(std::span<const uint8_t> data): _data(data) {}
+
+	bool empty() const { return _data.empty(); }
+	std::size_t remaining() const { return _data.size(); }
+
+	template <typename T>
+	T get() {
+		if (_data.size() < sizeof(T))
+			throw std::invalid_argument("truncated frame");
+		T value;
+		std::memcpy(&value, _data.data(), sizeof(T));
+		_data = _data.subspan(sizeof(T));
+		return value;
+	}
+
+	std::span<const uint8_t> get(std::size_t size) {
+		if (_data.size() < size)
+			throw std::invalid_argument("truncated frame");
+		auto res = _data.first(size);
+		_data = _data.subspan(size);
+		return res;
+	}
+
+	// Reads an element count, throws if the remaining data is too short
+	// for count elements of element_size bytes
+	template <typename Count>
+	std::size_t get_count(std::size_t element_size) {
+		std::size_t count = get<Count>();
+		if (count > _data.size() / element_size)
+			throw std::invalid_argument("truncated frame");
+		return count;
+	}
+
+	std::string get_string() {
+		auto bytes = get(get<uint32_t>());
+		return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+	}
+};
+
+// Returns the payload of the frame or an empty span if it is incomplete.
+std::span<const uint8_t> frame_payload(std::span<const uint8_t> buffer, std::size_t max_size)
+{
+	if (buffer.size() < sizeof(uint32_t))
+		return {};
+	uint32_t size;
+	std::memcpy(&size, buffer.data(), sizeof(size));
+	if (size > max_size)
+		throw std::invalid_argument("frame is too big");
+	if (buffer.size() < sizeof(uint32_t) + size)
+		return {};
+	return buffer.subspan(sizeof(uint32_t), size);
+}
+
+} // namespace
+
+std::size_t Response::row_size() const
+{
+	return std::accumulate(field_sizes.begin(), field_sizes.end(), std::size_t(0));
+}
+
+void dfs::server::encode(const Request &request, std::vector<uint8_t> &out)
+{
+	Writer w(out);
+	w.put<uint32_t>(request.id);
+	w.put_string(request.path);
+	w.put_size<uint16_t>(request.fields.size());
+	for (const auto &field: request.fields)
+		w.put_string(field);
+	w.finish(MaxRequestSize);
+}
+
+void dfs::server::encode(const Response &response, std::vector<uint8_t> &out)
+{
+	Writer w(out);
+	w.put<uint32_t>(response.id);
+	w.put<uint32_t>(static_cast<uint32_t>(response.status));
+	w.put_string(response.message);
+	w.put_size<uint32_t>(response.field_sizes.size());
+	for (auto size: response.field_sizes)
+		w.put<uint32_t>(size);
+	w.put_size<uint32_t>(response.addresses.size());
+	for (auto address: response.addresses)
+		w.put<uint64_t>(address);
+	w.put_bytes(response.data);
+	w.finish();
+}
+
+std::size_t dfs::server::decode(std::span<const uint8_t> buffer, Request &out)
+{
+	auto payload = frame_payload(buffer, MaxRequestSize);
+	if (payload.data() == nullptr)
+		return 0;
+	Reader r(payload);
+	out.id = r.get<uint32_t>();
+	out.path = r.get_string();
+	out.fields.resize(r.get<uint16_t>());
+	for (auto &field: out.fields)
+		field = r.get_string();
+	if (!r.empty())
+		throw std::invalid_argument("trailing data in request");
+	return sizeof(uint32_t) + payload.size();
+}
+
+std::size_t dfs::server::decode(std::span<const uint8_t> buffer, Response &out)
+{
+	auto payload = frame_payload(buffer, std::numeric_limits<uint32_t>::max());
+	if (payload.data() == nullptr)
+		return 0;
+	Reader r(payload);
+	out.id = r.get<uint32_t>();
+	out.status = static_cast<Status>(r.get<uint32_t>());
+	out.message = r.get_string();
+	out.field_sizes.resize(r.get_count<uint32_t>(sizeof(uint32_t)));
+	for (auto &size: out.field_sizes)
+		size = r.get<uint32_t>();
+	out.addresses.resize(r.get_count<uint32_t>(sizeof(uint64_t)));
+	for (auto &address: out.addresses)
+		address = r.get<uint64_t>();
+	auto row_size = out.row_size();
+	if (!out.addresses.empty() && row_size > r.remaining() / out.addresses.size())
+		throw std::invalid_argument("truncated frame");
+	auto data = r.get(out.addresses.size() * row_size);
+	out.data.assign(data.begin(), data.end());
+	if (!r.empty())
+		throw std::invalid_argument("trailing data in response");
+	return sizeof(uint32_t) + payload.size();
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_SERVER_PROTOCOL_H
+#define DFS_SERVER_PROTOCOL_H
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+/**
+ * Binary protocol between dfs-server and its clients.
+ *
+ * See doc/server.md for the encoding.
+ */
+namespace dfs::server {
+
+/**
+ * Maximum size of a request frame payload.
+ */
+inline constexpr std::size_t MaxRequestSize = 64*1024;
+
+enum class Status: uint32_t
+{
+	Ok = 0,
+	InvalidRequest,	///< The request could not be parsed
+	InvalidPath,	///< The path or a field path is invalid
+	ReadError,	///< Memory could not be read
+};
+
+/**
+ * Query for the object(s) at \ref path.
+ */
+struct Request
+{
+	uint32_t id;
+	std::string path;
+	std::vector<std::string> fields;
+};
+
+/**
+ * Result of a query.
+ *
+ * Rows are stored contiguously in \ref data, each row contains the fields in
+ * the request order, with sizes from \ref field_sizes.
+ */
+struct Response
+{
+	uint32_t id;
+	Status status = Status::Ok;
+	std::string message;
+	std::vector<uint32_t> field_sizes;
+	std::vector<uint64_t> addresses;
+	std::vector<uint8_t> data;
+
+	std::size_t row_size() const;
+};
+
+/**
+ * Appends the frame for \p request to \p out.
+ *
+ * \throws std::length_error if the request is bigger than MaxRequestSize,
+ * \p out is left unchanged
+ */
+void encode(const Request &request, std::vector<uint8_t> &out);
+/**
+ * Appends the frame for \p response to \p out.
+ *
+ * \throws std::length_error if a size does not fit in the protocol
+ * integers, \p out is left unchanged
+ */
+void encode(const Response &response, std::vector<uint8_t> &out);
+
+/**
+ * Decodes the frame at the beginning of \p buffer.
+ *
+ * \returns the size of the frame, or 0 if \p buffer does not contain a
+ * complete frame
+ * \throws std::invalid_argument if the frame is malformed
+ */
+std::size_t decode(std::span<const uint8_t> buffer, Request &out);
+/**
+ * \overload
+ */
+std::size_t decode(std::span<const uint8_t> buffer, Response &out);
+
+} // namespace dfs::server
+
+#endif
@@ -0,0 +1,356 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "executor.h"
+
+#include <dfs/Structures.h>
+#include <dfs/LinuxProcess.h>
+#include <dfs/WineProcess.h>
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <list>
+#include <optional>
+
+extern "C" {
+#include <getopt.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+}
+
+namespace fs = std::filesystem;
+
+using namespace dfs;
+using namespace dfs::server;
+
+static constexpr const char *usage = R"(Usage: {} [options...] df_structures pid socket_path
+
+Serves read requests from clients connected to socket_path. Requests
+received within the batch delay are answered from a single read session.
+
+Options:
+ -t, --type native|wine	Process type (default is native)
+ -d, --delay ms		Batch delay in milliseconds (default is 5)
+ -h, --help		Print this help message
+)";
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void on_signal(int)
+{
+	stop_requested = 1;
+}
+
+struct Client
+{
+	int fd;
+	std::vector<uint8_t> input, output;
+	std::size_t output_sent = 0;
+	/// No more requests are read, the connection is closed once the
+	/// pending requests are answered and the output is sent.
+	bool closing = false;
+	/// Sent after the answers to the pending requests
+	std::optional<Response> error;
+
+	Client(int fd): fd(fd) {}
+	Client(const Client &) = delete;
+	Client &operator=(const Client &) = delete;
+	~Client() {
+		close(fd);
+	}
+
+	bool want_write() const {
+		return output_sent < output.size();
+	}
+};
+
+struct PendingRequest
+{
+	Client *client;
+	Request request;
+};
+
+static int listen_unix(const fs::path &path)
+{
+	sockaddr_un addr = {};
+	addr.sun_family = AF_UNIX;
+	if (path.native().size() >= sizeof(addr.sun_path))
+		throw std::invalid_argument("socket path is too long");
+	std::strcpy(addr.sun_path, path.c_str());
+	int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+	if (fd == -1)
+		throw std::system_error(errno, std::system_category(), "socket");
+	if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == -1) {
+		int err = errno;
+		close(fd);
+		throw std::system_error(err, std::system_category(), "bind");
+	}
+	if (listen(fd, SOMAXCONN) == -1) {
+		int err = errno;
+		close(fd);
+		throw std::system_error(err, std::system_category(), "listen");
+	}
+	return fd;
+}
+
+// Reads available data and parses complete requests, returns false if the
+// connection failed.
+static bool receive(Client &client, std::vector<PendingRequest> &pending)
+{
+	uint8_t buffer[4096];
+	auto len = recv(client.fd, buffer, sizeof(buffer), MSG_DONTWAIT);
+	if (len == -1)
+		return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+	if (len == 0) {
+		// Half-closed, the pending requests are still answered
+		client.closing = true;
+		return true;
+	}
+	if (client.closing) // ignore data after a malformed frame
+		return true;
+	client.input.insert(client.input.end(), buffer, buffer+len);
+	std::size_t consumed = 0;
+	try {
+		while (true) {
+			PendingRequest req = {&client};
+			auto frame_size = decode(std::span(client.input).subspan(consumed), req.request);
+			if (frame_size == 0)
+				break;
+			consumed += frame_size;
+			pending.push_back(std::move(req));
+		}
+		client.input.erase(client.input.begin(), client.input.begin()+consumed);
+	}
+	catch (std::exception &e) {
+		// The stream cannot be resynchronized, drop the input, reply
+		// and close
+		client.input.clear();
+		client.closing = true;
+		client.error = Response{0, Status::InvalidRequest, e.what()};
+	}
+	return true;
+}
+
+// Sends buffered output, returns false if the connection failed.
+static bool send_pending(Client &client)
+{
+	while (client.want_write()) {
+		auto len = send(client.fd,
+				client.output.data() + client.output_sent,
+				client.output.size() - client.output_sent,
+				MSG_DONTWAIT | MSG_NOSIGNAL);
+		if (len == -1)
+			return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+		client.output_sent += len;
+	}
+	client.output.clear();
+	client.output_sent = 0;
+	return true;
+}
+
+// Sends the final error of a closing client once its pending requests are
+// answered, returns false when the client can be removed.
+static bool finish_closing(Client &client, const std::vector<PendingRequest> &pending)
+{
+	if (!client.closing || std::ranges::any_of(pending, [&](const auto &req) { return req.client == &client; }))
+		return true;
+	if (client.error) {
+		encode(*client.error, client.output);
+		client.error.reset();
+		if (!send_pending(client))
+			return false;
+	}
+	return client.want_write();
+}
+
+int main(int argc, char *argv[]) try
+{
+	std::string process_type = "native";
+	std::chrono::milliseconds batch_delay(5);
+	static option options[] = {
+		{"type", required_argument, nullptr, 't'},
+		{"delay", required_argument, nullptr, 'd'},
+		{"help", no_argument, nullptr, 'h'},
+		{nullptr, 0, nullptr, 0}
+	};
+	{
+		int opt;
+		while ((opt = getopt_long(argc, argv, ":t:d:h", options, nullptr)) != -1) {
+			switch (opt) {
+			case 't': // type
+				process_type = optarg;
+				break;
+			case 'd': { // delay
+				std::string_view arg = optarg;
+				int delay = 0;
+				auto res = std::from_chars(arg.data(), arg.data()+arg.size(), delay);
+				if (res.ptr != arg.data()+arg.size() || delay < 0) {
+					std::cerr << "Invalid delay\n";
+					return EXIT_FAILURE;
+				}
+				batch_delay = std::chrono::milliseconds(delay);
+				break;
+			}
+			case '?': // invalid option
+				std::cerr << "Invalid option\n";
+				std::cerr << std::format(usage, argv[0]);
+				return EXIT_FAILURE;
+			case ':': // missing argument
+				std::cerr << "Missing option argument\n";
+				std::cerr << std::format(usage, argv[0]);
+				return EXIT_FAILURE;
+			case 'h': // help
+				std::cerr << std::format(usage, argv[0]);
+				return EXIT_SUCCESS;
+			}
+		}
+	}
+	if (argc - optind != 3) {
+		std::cerr << "This command must have three parameters\n";
+		std::cerr << std::format(usage, argv[0]);
+		return EXIT_FAILURE;
+	}
+	Structures structures(fs::path(argv[optind]));
+
+	int pid = 0;
+	{
+		std::string_view arg = argv[optind+1];
+		auto res = std::from_chars(arg.data(), arg.data()+arg.size(), pid);
+		if (res.ptr != arg.data()+arg.size()) {
+			std::cerr << "Invalid pid\n";
+			return EXIT_FAILURE;
+		}
+	}
+
+	std::unique_ptr<Process> process;
+	if (process_type == "native")
+		process = std::make_unique<LinuxProcess>(pid);
+	else if (process_type == "wine")
+		process = std::make_unique<WineProcess>(pid);
+	else {
+		std::cerr << std::format("Invalid process type: {}\n", process_type);
+		return EXIT_FAILURE;
+	}
+	// Every batch uses a single stopped session, so caching is safe
+	process = std::make_unique<ProcessCache>(std::move(process));
+
+	auto version = structures.versionById(process->id());
+	if (!version) {
+		std::cerr << "Version not found\n";
+		return EXIT_FAILURE;
+	}
+	std::cerr << std::format("Found version {}\n", version->version_name);
+
+	ReaderFactory factory(structures, *version);
+	Executor executor(factory, *process);
+
+	fs::path socket_path = argv[optind+2];
+	int listen_fd = listen_unix(socket_path);
+	std::signal(SIGINT, on_signal);
+	std::signal(SIGTERM, on_signal);
+
+	std::list<Client> clients;
+	std::vector<PendingRequest> pending;
+	std::optional<std::chrono::steady_clock::time_point> batch_deadline;
+	std::vector<pollfd> fds;
+	while (!stop_requested) {
+		int timeout = -1;
+		if (batch_deadline) {
+			auto remaining = std::chrono::ceil<std::chrono::milliseconds>(
+					*batch_deadline - std::chrono::steady_clock::now());
+			timeout = std::max<int>(0, remaining.count());
+		}
+		fds.clear();
+		fds.push_back({listen_fd, POLLIN, 0});
+		for (const auto &client: clients)
+			fds.push_back({client.fd, short((client.closing ? 0 : POLLIN) | (client.want_write() ? POLLOUT : 0)), 0});
+		if (poll(fds.data(), fds.size(), timeout) == -1) {
+			if (errno == EINTR)
+				continue;
+			throw std::system_error(errno, std::system_category(), "poll");
+		}
+
+		if (fds[0].revents & POLLIN) {
+			int fd = accept4(listen_fd, nullptr, nullptr, SOCK_CLOEXEC);
+			if (fd != -1)
+				clients.emplace_back(fd);
+		}
+		auto pfd = fds.begin()+1;
+		for (auto it = clients.begin(); it != clients.end() && pfd != fds.end(); ++pfd) {
+			bool ok = true;
+			if (it->closing && (pfd->revents & (POLLHUP | POLLERR)))
+				ok = false; // the peer is gone, answers cannot be delivered
+			else if (pfd->revents & (POLLIN | POLLHUP | POLLERR))
+				ok = receive(*it, pending);
+			if (ok && (pfd->revents & POLLOUT))
+				ok = send_pending(*it);
+			if (ok)
+				ok = finish_closing(*it, pending);
+			if (!ok) {
+				std::erase_if(pending, [&](const auto &req) { return req.client == &*it; });
+				it = clients.erase(it);
+			}
+			else
+				++it;
+		}
+
+		if (!pending.empty() && !batch_deadline)
+			batch_deadline = std::chrono::steady_clock::now() + batch_delay;
+		if (batch_deadline && std::chrono::steady_clock::now() >= *batch_deadline) {
+			std::vector<Request> requests;
+			requests.reserve(pending.size());
+			for (auto &req: pending)
+				requests.push_back(std::move(req.request));
+			std::vector<Response> responses(requests.size());
+			executor.execute(requests, responses);
+			for (std::size_t i = 0; i < pending.size(); ++i) {
+				auto &output = pending[i].client->output;
+				try {
+					encode(responses[i], output);
+				}
+				catch (std::length_error &e) {
+					encode(Response{responses[i].id, Status::InvalidRequest, e.what()}, output);
+				}
+			}
+			pending.clear();
+			batch_deadline.reset();
+			for (auto it = clients.begin(); it != clients.end(); ) {
+				if (!send_pending(*it) || !finish_closing(*it, pending))
+					it = clients.erase(it);
+				else
+					++it;
+			}
+		}
+	}
+
+	close(listen_fd);
+	fs::remove(socket_path);
+	return EXIT_SUCCESS;
+}
+catch (std::exception &e) {
+	std::cerr << std::format("Error: {}\n", e.what());
+	return EXIT_FAILURE;
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#ifndef DFS_TESTS_FAKE_PROCESS_H
+#define DFS_TESTS_FAKE_PROCESS_H
+
+#include <dfs/Process.h>
+
+#include <algorithm>
+#include <cstring>
+#include <map>
+
+/**
+ * Process with memory stored in local buffers, for testing without Dwarf
+ * Fortress.
+ */
+class FakeProcess: public dfs::Process
+{
+public:
+	FakeProcess(std::vector<uint8_t> id):
+		_id(std::move(id))
+	{
+	}
+
+	/**
+	 * Adds a zero-initialized region of \p size bytes at \p address.
+	 *
+	 * \returns the region data
+	 */
+	std::span<uint8_t> map(uintptr_t address, std::size_t size) {
+		auto &region = _regions[address];
+		region.assign(size, 0);
+		return region;
+	}
+
+	/**
+	 * Copies \p value at \p address, inside a region added by map.
+	 */
+	template <typename T>
+	void write(uintptr_t address, const T &value) {
+		auto region = find(address, sizeof(T));
+		if (region.empty())
+			throw std::out_of_range("write outside of mapped regions");
+		std::memcpy(region.data(), &value, sizeof(T));
+	}
+
+	std::span<const uint8_t> id() const override { return _id; }
+	intptr_t base_offset() const override { return 0; }
+	std::error_code stop() override { ++stop_count; return {}; }
+	std::error_code cont() override { return {}; }
+
+	cppcoro::task<std::error_code> read(dfs::MemoryBufferRef buffer) override {
+		++read_count;
+		auto region = find(buffer.address, buffer.data.size());
+		if (region.empty() && !buffer.data.empty())
+			co_return std::make_error_code(std::errc::bad_address);
+		std::ranges::copy(region, buffer.data.begin());
+		co_return std::error_code{};
+	}
+
+	std::size_t stop_count = 0;
+	std::size_t read_count = 0;
+
+private:
+	// Returns the mapped bytes at [address, address+size) or an empty span
+	std::span<uint8_t> find(uintptr_t address, std::size_t size) {
+		auto it = _regions.upper_bound(address);
+		if (it == _regions.begin())
+			return {};
+		--it;
+		auto offset = address - it->first;
+		if (offset > it->second.size() || size > it->second.size() - offset)
+			return {};
+		return std::span(it->second).subspan(offset, size);
+	}
+
+	std::vector<uint8_t> _id;
+	std::map<uintptr_t, std::vector<uint8_t>> _regions;
+};
+
+#endif
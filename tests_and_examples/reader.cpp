@@ -27,7 +27,9 @@
 #include <dfs/PolymorphicReader.h>
 
 #ifdef __linux__
+#include <dfs/ElfCoreProcess.h>
 #include <dfs/LinuxProcess.h>
+#include <dfs/ProcessDiscovery.h>
 #include <dfs/WineProcess.h>
 #endif
 
@@ -713,12 +715,15 @@ extern "C" {
 #include <getopt.h>
 }
 
-static constexpr const char *usage = "{} [options...] df_structures pid\n"
+static constexpr const char *usage = "{} [options...] df_structures [pid]\n"
 	"df_structures must be a path to a directory containing df-structures xml.\n"
+	"If pid is omitted, running Dwarf Fortress processes are searched (linux-only).\n"
+	"With the core process type, pid is the path to a core file (linux-only).\n"
 	"Options are:\n"
-	" -t, --type type   Process type (native or wine)\n"
+	" -t, --type type   Process type (native, wine or core)\n"
 	" -c, --cache       Use cache\n"
 	" -v, --vectorize   Use vectorizer\n"
+	" -p, --prefetch n  Prefetch n levels of objects (requires cache)\n"
 	" -h, --help        Print this help message\n";
 
 int main(int argc, char *argv[]) try
@@ -730,15 +735,17 @@ int main(int argc, char *argv[]) try
 		{"type", required_argument, nullptr, 't'},
 		{"cache", no_argument, nullptr, 'c'},
 		{"vectorize", no_argument, nullptr, 'v'},
+		{"prefetch", required_argument, nullptr, 'p'},
 		{"help", no_argument, nullptr, 'h'},
 		{nullptr, 0, nullptr, 0}
 	};
 	std::string process_type = "native";
 	bool use_cache = false;
 	bool use_vectorizer = false;
+	std::size_t prefetch_depth = 0;
 	{
 		int opt;
-		while ((opt = getopt_long(argc, argv, ":t:cv", options, nullptr)) != -1) {
+		while ((opt = getopt_long(argc, argv, ":t:cvp:", options, nullptr)) != -1) {
 			switch (opt) {
 			case 't': // type
 				process_type = optarg;
@@ -749,6 +756,15 @@ int main(int argc, char *argv[]) try
 			case 'v': // vectorize
 				use_vectorizer = true;
 				break;
+			case 'p': { // prefetch
+				std::string_view arg = optarg;
+				auto res = std::from_chars(arg.data(), arg.data()+arg.size(), prefetch_depth);
+				if (res.ptr != arg.data()+arg.size()) {
+					std::cerr << "Invalid prefetch depth\n";
+					return EXIT_FAILURE;
+				}
+				break;
+			}
 			case '?': // invalid option
 				std::cerr << "Invalid option\n";
 				std::cerr << std::format(usage, argv[0]);
@@ -763,43 +779,64 @@ int main(int argc, char *argv[]) try
 			}
 		}
 	}
-	if (argc - optind != 2) {
-		std::cerr << "This command must have exactly two parameters\n";
+	if (argc - optind != 1 && argc - optind != 2) {
+		std::cerr << "This command must have one or two parameters\n";
 		std::cerr << std::format(usage, argv[0]);
 		return EXIT_FAILURE;
 	}
 	fs::path df_structures_path = argv[optind];
 	Structures structures(df_structures_path);
 
-	int pid = 0;
-	{
+	std::unique_ptr<Process> process;
+#ifdef __linux__
+	if (argc - optind == 2 && process_type == "core") {
+		process = std::make_unique<ElfCoreProcess>(argv[optind+1]);
+	}
+	else
+#endif
+	if (argc - optind == 2) {
+		int pid = 0;
 		std::string_view arg = argv[optind+1];
 		auto res = std::from_chars(arg.data(), arg.data()+arg.size(), pid);
 		if (res.ptr != arg.data()+arg.size()) {
 			std::cerr << "Invalid pid\n";
 			return EXIT_FAILURE;
 		}
-	}
-
-	std::unique_ptr<Process> process;
-	if (process_type == "native") {
+		if (process_type == "native") {
 #if defined(__linux__)
-		process = std::make_unique<LinuxProcess>(pid);
+			process = std::make_unique<LinuxProcess>(pid);
 #elif defined(_WIN32)
-		process = std::make_unique<Win32Process>(pid);
+			process = std::make_unique<Win32Process>(pid);
 #else
-		std::cerr << "\"native\" process not supported on this platform\n";
-		return EXIT_FAILURE;
+			std::cerr << "\"native\" process not supported on this platform\n";
+			return EXIT_FAILURE;
 #endif
-	}
+		}
 #ifdef __linux__
-	else if (process_type == "wine") {
-		process = std::make_unique<WineProcess>(pid);
-	}
+		else if (process_type == "wine") {
+			process = std::make_unique<WineProcess>(pid);
+		}
 #endif
+		else {
+			std::cerr << std::format("Invalid process type: {}\n", process_type);
+			return EXIT_FAILURE;
+		}
+	}
 	else {
-		std::cerr << std::format("Invalid process type: {}\n", process_type);
+#ifdef __linux__
+		auto found = ProcessDiscovery(structures).scan();
+		if (found.size() != 1) {
+			std::cerr << std::format("Found {} Dwarf Fortress processes, pid is required\n", found.size());
+			for (const auto &p: found)
+				std::cerr << std::format("{}: {}\n", p.pid, p.version->version_name);
+			return EXIT_FAILURE;
+		}
+		std::cerr << std::format("Using process {}\n", found.front().pid);
+		process = std::move(found.front().process);
+#else
+		std::cerr << "pid is required on this platform\n";
 		return EXIT_FAILURE;
+#endif
 	}
 	{
 		auto tmp = std::move(process);
@@ -833,12 +870,23 @@ int main(int argc, char *argv[]) try
 	std::cerr << std::format("Found version {}\n", version->version_name);
 
 	ReaderFactory reader(structures, *version);
+	try {
+		auto start = std::chrono::steady_clock::now();
+		reader.prepare<world>();
+		auto end = std::chrono::steady_clock::now();
+		std::cout << "Readers prepared in " << std::chrono::duration_cast<std::chrono::milliseconds>(end-start).count() << "ms" << std::endl;
+	}
+	catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return -1;
+	}
 	world w;
 	int fortress_civ_id;
 	{
 		using namespace literals;
 		auto start = std::chrono::steady_clock::now();
 		ReadSession session(reader, *process);
+		session.prefetch_depth = prefetch_depth;
 		if (!session.sync(
 				session.read("world"_path, w),
 				session.read("plotinfo.civ_id"_path, fortress_civ_id))) {
@@ -17,11 +17,25 @@
  */
 
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <random>
+#include <mutex>
 #include <set>
+#include <sstream>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
 
 #include <format>
 
@@ -41,9 +55,6 @@
 #include <dfs/Win32Process.h>
 #endif
 
-
-#include <cppcoro/when_all.hpp>
-
 #include <variant>
 #include <charconv>
 
@@ -55,21 +66,464 @@ namespace fs = std::filesystem;
 
 using namespace dfs;
 
+/**
+ * Location of a checked value.
+ *
+ * Paths are chains of segments allocated on the stack of the checking
+ * functions, the name is only formatted when an error is reported. Pointed
+ * objects are checked by another job after the pointer's frame is gone, so
+ * their path is first copied to a shared ValuePathRoot.
+ */
+struct ValuePathRoot;
+
+struct ValuePathSegment
+{
+	enum Kind { Member, Index, Deref } kind;
+	std::string_view member;
+	std::size_t index;
+};
+
+struct ValuePath
+{
+	const ValuePath *parent;
+	ValuePathSegment segment;
+	std::shared_ptr<const ValuePathRoot> root;	///< only set at the top of the chain
+
+	ValuePath member(std::string_view name) const { return {this, {ValuePathSegment::Member, name, 0}, nullptr}; }
+	ValuePath index(std::size_t i) const { return {this, {ValuePathSegment::Index, {}, i}, nullptr}; }
+};
+
+struct ValuePathRoot
+{
+	std::shared_ptr<const ValuePathRoot> parent;	///< path of the pointer, null for globals
+	std::string text;	///< global object name or path loaded from a state file
+	std::vector<ValuePathSegment> segments;
+};
+
+static void append_segment(std::string &out, const ValuePathSegment &segment)
+{
+	switch (segment.kind) {
+	case ValuePathSegment::Member:
+		out += '.';
+		out += segment.member;
+		break;
+	case ValuePathSegment::Index:
+		out += std::format("[{}]", segment.index);
+		break;
+	case ValuePathSegment::Deref:
+		out = std::format("(*{})", out);
+		break;
+	}
+}
+
+static std::string to_string(const ValuePathRoot &root)
+{
+	std::string out = root.parent ? to_string(*root.parent) : root.text;
+	for (const auto &segment: root.segments)
+		append_segment(out, segment);
+	return out;
+}
+
+static std::string to_string(const ValuePath &path)
+{
+	if (path.root)
+		return to_string(*path.root);
+	std::string out = to_string(*path.parent);
+	append_segment(out, path.segment);
+	return out;
+}
+
+/**
+ * Copies \p path so it can outlive the stack frames, segments are not
+ * formatted.
+ */
+static std::shared_ptr<const ValuePathRoot> make_shared_path(const ValuePath &path)
+{
+	std::vector<ValuePathSegment> segments;
+	const ValuePath *node = &path;
+	for (; !node->root; node = node->parent)
+		segments.push_back(node->segment);
+	if (segments.empty())
+		return node->root;
+	std::ranges::reverse(segments);
+	return std::make_shared<ValuePathRoot>(node->root, std::string{}, std::move(segments));
+}
+
+/**
+ * Thread pool where each worker has its own job queue and steals jobs from
+ * the other queues when its own is empty.
+ *
+ * Jobs pushed from a worker go to the back of its queue and are popped from
+ * the back (depth-first), stolen jobs are taken from the front.
+ */
+class WorkStealingPool
+{
+public:
+	using job_t = std::function<void ()>;
+
+	WorkStealingPool(std::size_t thread_count):
+		_queues(std::max<std::size_t>(thread_count, 1))
+	{
+	}
+
+	/**
+	 * Adds a job, from a worker or before calling run().
+	 */
+	void push(job_t job)
+	{
+		std::size_t index = _current != 0
+			? _current - 1
+			: _next++ % _queues.size();
+		++_pending; // before the job is visible, so run() cannot stop early
+		{
+			std::lock_guard lock(_queues[index].mutex);
+			_queues[index].jobs.push_back(std::move(job));
+		}
+		notify(false);
+	}
+
+	/**
+	 * Runs jobs until every queue is empty and no job is running.
+	 */
+	void run()
+	{
+		std::vector<std::thread> threads;
+		for (std::size_t i = 0; i < _queues.size(); ++i)
+			threads.emplace_back([this, i]() { work(i); });
+		for (auto &thread: threads)
+			thread.join();
+	}
+
+private:
+	struct queue_t
+	{
+		std::mutex mutex;
+		std::deque<job_t> jobs;
+	};
+	std::vector<queue_t> _queues;
+	std::atomic<std::size_t> _pending = 0;
+	std::size_t _next = 0;
+	// idle workers wait for a new job or the end of the last one
+	std::mutex _idle_mutex;
+	std::condition_variable _idle_cv;
+	std::size_t _generation = 0; // incremented on each notification
+	static inline thread_local std::size_t _current = 0; // worker index + 1
+
+	bool pop(std::size_t index, job_t &job)
+	{
+		{
+			auto &own = _queues[index];
+			std::lock_guard lock(own.mutex);
+			if (!own.jobs.empty()) {
+				job = std::move(own.jobs.back());
+				own.jobs.pop_back();
+				return true;
+			}
+		}
+		for (std::size_t i = 1; i < _queues.size(); ++i) {
+			auto &other = _queues[(index + i) % _queues.size()];
+			std::lock_guard lock(other.mutex);
+			if (!other.jobs.empty()) {
+				job = std::move(other.jobs.front());
+				other.jobs.pop_front();
+				return true;
+			}
+		}
+		return false;
+	}
+
+	void notify(bool all)
+	{
+		{
+			std::lock_guard lock(_idle_mutex);
+			++_generation;
+		}
+		if (all)
+			_idle_cv.notify_all();
+		else
+			_idle_cv.notify_one();
+	}
+
+	void work(std::size_t index)
+	{
+		_current = index + 1;
+		job_t job;
+		while (true) {
+			std::size_t generation;
+			{
+				std::lock_guard lock(_idle_mutex);
+				generation = _generation;
+			}
+			if (!pop(index, job)) {
+				// jobs pushed after pop failed changed the generation
+				std::unique_lock lock(_idle_mutex);
+				_idle_cv.wait(lock, [&]() { return _pending == 0 || _generation != generation; });
+				if (_pending == 0)
+					break;
+				continue;
+			}
+			try {
+				job();
+			}
+			catch (std::exception &e) {
+				std::cerr << std::format("Check failed: {}\n", e.what());
+			}
+			job = nullptr;
+			if (--_pending == 0)
+				notify(true);
+		}
+		_current = 0;
+	}
+};
+
+static constexpr std::size_t PageSize = 4096;
+
+/**
+ * Process wrapper recording the pages read by the current thread.
+ */
+class RecordingProcess: public ProcessWrapper
+{
+public:
+	/// pages read are appended here if not null
+	static inline thread_local std::vector<uint64_t> *pages = nullptr;
+
+	using ProcessWrapper::ProcessWrapper;
+
+	[[nodiscard]] cppcoro::task<std::error_code> read(MemoryBufferRef buffer) override
+	{
+		record(buffer.address, buffer.data.size());
+		return process().read(buffer);
+	}
+
+	[[nodiscard]] cppcoro::task<std::error_code> readv(std::span<const MemoryBufferRef> tasks) override
+	{
+		for (const auto &buffer: tasks)
+			record(buffer.address, buffer.data.size());
+		return process().readv(tasks);
+	}
+
+	[[nodiscard]] cppcoro::task<std::error_code> pin(uintptr_t address, std::size_t size, PinnedMemory &out) override
+	{
+		record(address, size);
+		return process().pin(address, size, out);
+	}
+
+private:
+	static void record(uintptr_t address, std::size_t size)
+	{
+		if (!pages || size == 0)
+			return;
+		for (auto page = address / PageSize; page <= (address + size - 1) / PageSize; ++page)
+			if (pages->empty() || pages->back() != page)
+				pages->push_back(page);
+	}
+};
+
+static uint64_t page_checksum(std::span<const uint8_t> page)
+{
+	uint64_t hash = 0xcbf29ce484222325ull;
+	for (std::size_t i = 0; i + sizeof(uint64_t) <= page.size(); i += sizeof(uint64_t)) {
+		uint64_t word;
+		std::memcpy(&word, page.data() + i, sizeof(word));
+		hash = (hash ^ word) * 0x100000001b3ull;
+	}
+	return hash;
+}
+
+/**
+ * \returns the checksums of \p pages, unreadable pages are missing.
+ */
+static std::unordered_map<uint64_t, uint64_t> page_checksums(Process &process, std::span<const uint64_t> pages)
+{
+	static constexpr std::size_t BatchSize = 256;
+	std::unordered_map<uint64_t, uint64_t> checksums;
+	std::vector<uint8_t> data(BatchSize * PageSize);
+	std::vector<MemoryBufferRef> buffers;
+	for (std::size_t begin = 0; begin < pages.size(); begin += BatchSize) {
+		auto batch = pages.subspan(begin, std::min(BatchSize, pages.size() - begin));
+		buffers.clear();
+		for (std::size_t i = 0; i < batch.size(); ++i)
+			buffers.push_back({batch[i] * PageSize, {data.data() + i * PageSize, PageSize}});
+		if (!process.readv_sync(buffers)) {
+			for (std::size_t i = 0; i < batch.size(); ++i)
+				checksums.emplace(batch[i], page_checksum(buffers[i].data));
+			continue;
+		}
+		// find which pages failed
+		for (std::size_t i = 0; i < batch.size(); ++i)
+			if (!process.read_sync(buffers[i]))
+				checksums.emplace(batch[i], page_checksum(buffers[i].data));
+	}
+	return checksums;
+}
+
+/**
+ * What the check of an object depended on, for incremental checks.
+ *
+ * Objects are identified by their address and a type key: the name of a
+ * top-level compound or `global:` followed by the name of a global object.
+ */
+struct ObjectRecord
+{
+	uint64_t signature = 0;	///< type layout signature
+	bool clean = true;	///< no error was reported and all children can be replayed
+	std::vector<uint64_t> pages;	///< pages read while checking
+	struct child_t {
+		uintptr_t address;
+		uintptr_t pointer_address;
+		std::string type;
+		std::shared_ptr<const ValuePathRoot> location;
+	};
+	std::vector<child_t> children;	///< pointed objects
+};
+using ObjectKey = std::pair<uintptr_t, std::string>;
+
+/**
+ * Checked objects and page checksums saved between runs.
+ *
+ * The file is text: a header line, then one line per page checksum and
+ * one `object` line per clean object followed by its `pages` and `child`
+ * lines.
+ */
+struct CheckState
+{
+	static constexpr std::string_view Header = "structcheck-state 1";
+
+	std::vector<uint8_t> id;
+	intptr_t base_offset = 0;
+	std::unordered_map<uint64_t, uint64_t> page_checksums;
+	std::map<ObjectKey, ObjectRecord> objects;
+
+	/**
+	 * \throws std::runtime_error if the file is invalid
+	 */
+	void load(const fs::path &path)
+	{
+		std::ifstream file(path);
+		if (!file)
+			throw std::runtime_error("cannot open file");
+		std::string line;
+		if (!std::getline(file, line) || line != Header)
+			throw std::runtime_error("invalid header");
+		ObjectRecord *current = nullptr;
+		while (std::getline(file, line)) {
+			std::istringstream in(line);
+			std::string kind;
+			in >> kind;
+			if (kind == "id") {
+				std::string hex;
+				in >> hex;
+				id.clear();
+				for (std::size_t i = 0; i + 1 < hex.size(); i += 2)
+					id.push_back(std::stoul(hex.substr(i, 2), nullptr, 16));
+			}
+			else if (kind == "base_offset")
+				in >> base_offset;
+			else if (kind == "page") {
+				uint64_t page, checksum;
+				in >> std::hex >> page >> checksum;
+				page_checksums.emplace(page, checksum);
+			}
+			else if (kind == "object") {
+				uintptr_t address;
+				std::string type;
+				ObjectRecord record;
+				in >> std::hex >> address >> type >> record.signature;
+				current = &(objects[{address, type}] = std::move(record));
+			}
+			else if (kind == "pages" && current) {
+				uint64_t page;
+				while (in >> std::hex >> page)
+					current->pages.push_back(page);
+			}
+			else if (kind == "child" && current) {
+				ObjectRecord::child_t child;
+				in >> std::hex >> child.address >> child.pointer_address >> child.type >> std::ws;
+				std::string text;
+				std::getline(in, text);
+				child.location = std::make_shared<ValuePathRoot>(nullptr, std::move(text));
+				current->children.push_back(std::move(child));
+			}
+			else
+				throw std::runtime_error(std::format("invalid line: {}", line));
+			if (in.fail() && !in.eof())
+				throw std::runtime_error(std::format("invalid line: {}", line));
+		}
+	}
+
+	void save(const fs::path &path) const
+	{
+		auto tmp = path;
+		tmp += ".tmp";
+		{
+			std::ofstream file(tmp);
+			file << Header << "\n";
+			file << "id ";
+			for (auto byte: id)
+				file << std::format("{:02x}", byte);
+			file << std::format("\nbase_offset {}\n", base_offset);
+			for (const auto &[page, checksum]: page_checksums)
+				file << std::format("page {:x} {:x}\n", page, checksum);
+			for (const auto &[key, record]: objects) {
+				file << std::format("object {:x} {} {:x}\npages", key.first, key.second, record.signature);
+				for (auto page: record.pages)
+					file << std::format(" {:x}", page);
+				file << "\n";
+				for (const auto &child: record.children)
+					file << std::format("child {:x} {:x} {} {}\n", child.address, child.pointer_address, child.type, to_string(*child.location));
+			}
+			if (!file)
+				throw std::runtime_error("failed to write state file");
+		}
+		fs::rename(tmp, path);
+	}
+};
+
 struct ObjectChecker
 {
 	static inline constexpr std::size_t MaxVectorSize = 10000000;
+	const Structures &structures;
 	const ABI &abi;
 	MemoryLayout layout;
 	Process &process;
-        std::map<uintptr_t, const Compound *> class_from_vtable;
+	WorkStealingPool &pool;
+	std::map<uintptr_t, const Compound *> class_from_vtable;
+	std::map<const Compound *, std::string_view> compound_names;
 	struct pointer_details {
 		bool valid;
 		const AbstractType *type;
-		std::string location;
+		std::shared_ptr<const ValuePathRoot> location;
+	};
+	// visited pointers are sharded by address to limit lock contention
+	static inline constexpr std::size_t VisitedShardCount = 64;
+	struct visited_shard {
+		std::mutex mutex;
+		std::unordered_map<uintptr_t, pointer_details> pointers;
 	};
-	std::map<uintptr_t, pointer_details> visited_pointers;
+	std::array<visited_shard, VisitedShardCount> visited_pointers;
+	std::mutex output_mutex;
 
 	bool show_vtable_errors = true;
+	std::size_t sample_size = 0;	///< check only this many random items per container (0 for all)
+
+	// Incremental checks: objects from the previous run are skipped if
+	// their type signature is the same and none of the pages they read
+	// changed, their children are queued from the saved records.
+	bool incremental = false;	///< record objects (process must be a RecordingProcess)
+	std::map<ObjectKey, ObjectRecord> previous_objects;
+	std::unordered_set<uint64_t> unchanged_pages;
+	std::map<ObjectKey, ObjectRecord> objects;
+	std::mutex objects_mutex;
+	std::atomic<std::size_t> skipped_objects = 0;
+	static inline thread_local ObjectRecord *current_record = nullptr;
+
+	std::unordered_map<const Compound *, uint64_t> compound_signatures;
+	std::mutex signatures_mutex;
+
+	visited_shard &visited_shard_for(uintptr_t ptr) {
+		// low bits are mostly alignment
+		return visited_pointers[((ptr >> 4) * 0x9e3779b97f4a7c15ull >> 32) % VisitedShardCount];
+	}
 
 	template<typename T>
 	void print_raw_words(uintptr_t addr, const TypeInfo &info) {
@@ -116,11 +570,28 @@ struct ObjectChecker
 		}
 	}
 
-        ObjectChecker(const Structures &structures,
-                      const Structures::VersionInfo &version, Process &process):
-		abi(ABI::fromVersionName(version.version_name)), layout(structures, abi), process(process)
+	/**
+	 * Prints an error for the value at \p path, followed by the raw data
+	 * around it if \p raw_info is not null. Only this function formats
+	 * paths.
+	 */
+	void report(const ValuePath &path, uintptr_t address, std::string_view message, const TypeInfo *raw_info = nullptr) {
+		if (current_record)
+			current_record->clean = false;
+		auto name = to_string(path);
+		std::lock_guard lock(output_mutex);
+		std::cout << std::format("{} ({:#x}): {}\n", name, address, message);
+		if (raw_info)
+			print_raw_data(address, *raw_info);
+	}
+
+	ObjectChecker(const Structures &structures,
+	              const Structures::VersionInfo &version, Process &process,
+	              WorkStealingPool &pool):
+		structures(structures), abi(ABI::fromVersionName(version.version_name)), layout(structures, abi), process(process), pool(pool)
 	{
-		for (const auto &[name, type]: structures.allCompoundTypes())
+		for (const auto &[name, type]: structures.allCompoundTypes()) {
+			compound_names.emplace(&type, name);
 			if (type.vtable) {
 				auto it = version.vtables_addresses.find(type.symbol ? *type.symbol : name);
 				if (it == version.vtables_addresses.end()) {
@@ -130,74 +601,254 @@ struct ObjectChecker
 				}
 				class_from_vtable.emplace(it->second + process.base_offset(), &type);
 			}
-        }
+		}
+	}
+
+	/**
+	 * Type layout signature, only covers what the checks depend on.
+	 * Pointers to named compounds only use the name, the pointed object
+	 * has its own signature.
+	 */
+	struct signature_t
+	{
+		uint64_t hash = 0xcbf29ce484222325ull;
+		void add(std::string_view str) {
+			for (unsigned char c: str)
+				hash = (hash ^ c) * 0x100000001b3ull;
+			add(uint64_t(str.size()));
+		}
+		void add(uint64_t value) {
+			for (int i = 0; i < 8; ++i, value >>= 8)
+				hash = (hash ^ (value & 0xff)) * 0x100000001b3ull;
+		}
+	};
+
+	uint64_t signature(const AnyType &type) {
+		return type.visit([this](const auto &type) { return signature(type); });
+	}
+
+	uint64_t signature(const AbstractType &) {
+		return 0;
+	}
+
+	uint64_t signature(const Compound &compound) {
+		{
+			std::lock_guard lock(signatures_mutex);
+			if (auto it = compound_signatures.find(&compound); it != compound_signatures.end())
+				return it->second;
+		}
+		signature_t sig;
+		sig.add("compound");
+		sig.add(uint64_t(compound.is_union));
+		sig.add(layout.type_info.at(&compound).size);
+		if (compound.parent)
+			sig.add(signature(*compound.parent->get()));
+		const auto &member_offsets = layout.compound_layout.at(&compound).member_offsets;
+		for (std::size_t i = 0; i < compound.members.size(); ++i) {
+			sig.add(compound.members[i].name);
+			sig.add(member_offsets[i]);
+			sig.add(signature(compound.members[i].type));
+		}
+		std::lock_guard lock(signatures_mutex);
+		compound_signatures.emplace(&compound, sig.hash);
+		return sig.hash;
+	}
+
+	uint64_t signature(const PointerType &pointer) {
+		signature_t sig;
+		sig.add("pointer");
+		sig.add(uint64_t(pointer.has_bad_pointers));
+		if (pointer.type_params.size() == 1) {
+			const auto &item_type = pointer.itemType();
+			auto info = layout.getTypeInfo(item_type);
+			sig.add(info.size);
+			sig.add(info.align);
+			auto compound = item_type.get_if<Compound>();
+			if (auto it = compound_names.find(compound); it != compound_names.end())
+				sig.add(it->second);
+			else
+				sig.add(signature(item_type));
+		}
+		return sig.hash;
+	}
+
+	uint64_t signature(const StaticArray &array) {
+		signature_t sig;
+		sig.add("array");
+		sig.add(array.extent);
+		sig.add(layout.getTypeInfo(array.itemType()).size);
+		sig.add(signature(array.itemType()));
+		return sig.hash;
+	}
+
+	uint64_t signature(const StdContainer &container) {
+		signature_t sig;
+		sig.add("container");
+		sig.add(uint64_t(container.container_type));
+		for (const auto &param: container.type_params) {
+			sig.add(layout.getTypeInfo(param).size);
+			sig.add(signature(param));
+		}
+		return sig.hash;
+	}
+
+	uint64_t signature(const PrimitiveType &type) {
+		signature_t sig;
+		sig.add("primitive");
+		sig.add(uint64_t(type.type));
+		return sig.hash;
+	}
+
+	/**
+	 * \returns the key used for saving objects of this type or an empty
+	 * string if objects of this type cannot be saved.
+	 */
+	std::string_view type_key(const Compound *compound) const {
+		if (auto it = compound_names.find(compound); it != compound_names.end())
+			return it->second;
+		return {};
+	}
+
+	/**
+	 * Calls \p check for the object \p key, unless it can be skipped
+	 * because nothing it depends on changed since the previous run.
+	 */
+	template <typename Check>
+	void check_recorded(ObjectKey key, uint64_t signature, Check &&check)
+	{
+		if (auto it = previous_objects.find(key); it != previous_objects.end()
+				&& it->second.signature == signature
+				&& std::ranges::all_of(it->second.pages, [this](auto page) { return unchanged_pages.contains(page); })) {
+			++skipped_objects;
+			for (const auto &child: it->second.children)
+				replay(child);
+			std::lock_guard lock(objects_mutex);
+			objects.emplace(std::move(key), it->second);
+			return;
+		}
+		ObjectRecord record;
+		record.signature = signature;
+		struct recording_scope {
+			recording_scope(ObjectRecord &record) {
+				current_record = &record;
+				RecordingProcess::pages = &record.pages;
+			}
+			~recording_scope() {
+				current_record = nullptr;
+				RecordingProcess::pages = nullptr;
+			}
+		};
+		{
+			recording_scope scope(record);
+			check();
+		}
+		if (!record.clean)
+			return;
+		std::ranges::sort(record.pages);
+		auto [first, last] = std::ranges::unique(record.pages);
+		record.pages.erase(first, last);
+		std::lock_guard lock(objects_mutex);
+		objects.emplace(std::move(key), std::move(record));
+	}
 
-        template<typename T>
-	cppcoro::task<> check_object(const std::string &name, uintptr_t address, const T &type)
+	/**
+	 * Queues a child of a skipped object.
+	 */
+	void replay(const ObjectRecord::child_t &child)
+	{
+		auto compound = structures.findCompound(std::string_view(child.type));
+		if (!compound) // removed type
+			return;
+		ValuePath path = {nullptr, {}, child.location};
+		if (mark_visited(path, child.pointer_address, child.address, compound, child.location))
+			push_pointee(child.location, child.pointer_address, child.address, layout.type_info.at(compound).size, nullptr, compound);
+	}
+
+	/**
+	 * Queues the check of global object \p name.
+	 */
+	template<typename T>
+	void push_object(const std::string &name, uintptr_t address, const T &type)
+	{
+		pool.push([this, root = std::make_shared<ValuePathRoot>(nullptr, name), address, &type]() {
+			if (!incremental)
+				return check_object(ValuePath{nullptr, {}, root}, address, type);
+			check_recorded({address, "global:" + root->text}, signature(type), [&, this]() {
+				check_object(ValuePath{nullptr, {}, root}, address, type);
+			});
+		});
+	}
+
+	template<typename T>
+	void check_object(const ValuePath &path, uintptr_t address, const T &type)
 	{
 		auto type_info = layout.type_info.at(&type);
 		MemoryBuffer data(address, type_info.size);
-		if (auto err = co_await process.read(data)) {
-			std::cout << std::format("{} ({:#x}): invalid global object ({})\n", name, address, err.message());
-			co_return;
+		if (auto err = process.read_sync(data)) {
+			report(path, address, std::format("invalid global object ({})", err.message()));
+			return;
 		}
-		co_await check_value(name, data, type);
+		check_value(path, data, type);
 	}
 
-	cppcoro::task<> check_value(std::string name, MemoryView data, const AbstractType &)
+	void check_value(const ValuePath &path, MemoryView data, const AbstractType &)
 	{
-		co_return;
 	}
 
-	cppcoro::task<> check_value(std::string name, MemoryView data, const Compound &compound)
+	void check_value(const ValuePath &path, MemoryView data, const Compound &compound)
 	{
 		if (compound.is_union)
-			co_return;
+			return;
 		if (compound.vtable) {
 			// TODO: check vtable
 		}
 		if (compound.parent) {
-			co_await check_value(name, data, *compound.parent->get());
+			check_value(path, data, *compound.parent->get());
 		}
-		std::vector<cppcoro::task<>> tasks;
+		const auto &member_offsets = layout.compound_layout.at(&compound).member_offsets;
 		for (std::size_t i = 0; i < compound.members.size(); ++i) {
 			const auto &member = compound.members[i];
-			auto offset = layout.compound_layout.at(&compound).member_offsets[i];
 			member.type.visit([&, this](const auto &type) {
-				tasks.push_back(check_value(
-						std::format("{}.{}", name, member.name),
-						data.subview(offset),
-						type));
+				check_value(path.member(member.name), data.subview(member_offsets[i]), type);
 			});
 		}
-		co_await cppcoro::when_all(std::move(tasks));
 	}
 
-	cppcoro::task<> check_value(std::string name, MemoryView data, const PointerType &pointer)
+	void check_value(const ValuePath &path, MemoryView data, const PointerType &pointer)
 	{
 		if (pointer.type_params.empty()) // unknown type pointers
-			co_return;
+			return;
 		assert(pointer.type_params.size() == 1);
 		const auto &item_type = pointer.itemType();
 		auto type_info = layout.getTypeInfo(item_type);
 		if (type_info.size == 0) // skip missing types
-			co_return;
+			return;
 		if (pointer.has_bad_pointers)
-			co_return;
+			return;
 		auto ptr = abi.get_pointer(data);
 		if (ptr == 0)
-			co_return;
+			return;
+		check_pointer(path, data.address, ptr, item_type);
+	}
+
+	/**
+	 * Checks a non-null pointer to \p item_type stored at \p pointer_address
+	 * and queues the check of the pointed object.
+	 */
+	void check_pointer(const ValuePath &path, uintptr_t pointer_address, uintptr_t ptr, const AnyType &item_type)
+	{
+		auto type_info = layout.getTypeInfo(item_type);
 		auto actual_type = item_type.get_if<AbstractType>();
 		// down cast class types
 		const Compound *downcast_type = nullptr;
 		auto compound = item_type.get_if<Compound>();
 		if (compound && compound->vtable) {
 			uintptr_t vtable = 0;
-			co_await process.read({ptr, {reinterpret_cast<uint8_t *>(&vtable), abi.pointer.size}});
+			(void)process.read_sync({ptr, {reinterpret_cast<uint8_t *>(&vtable), abi.pointer.size}});
 			auto it = class_from_vtable.find(vtable);
 			if (it == class_from_vtable.end()) {
 				if (show_vtable_errors)
-					std::cout << std::format("{} ({:#x}): unknown vtable {:#x}\n", name, data.address, vtable);
+					report(path, pointer_address, std::format("unknown vtable {:#x}", vtable));
 			}
 			else {
 				actual_type = downcast_type = it->second;
@@ -206,125 +857,578 @@ struct ObjectChecker
 		}
 		// check pointer
 		if (ptr % type_info.align != 0) {
-			std::cout << std::format("{} ({:#x}): invalid pointer {:#x} unaligned (required {})\n", name, data.address, ptr, type_info.align);
-			print_raw_data(data.address, abi.pointer);
-			co_return;
-		}
-		auto it = visited_pointers.lower_bound(ptr);
-		if (it != visited_pointers.end() && it->first == ptr) {
-			if (!it->second.valid) {
-				std::cout << std::format("{} ({:#x}): invalid pointer {:#x} (first visited: {})\n", name, data.address, ptr, it->second.location);
-				print_raw_data(data.address, abi.pointer);
-			}
-			else if (it->second.type != actual_type) {
-				std::cout << std::format("{} ({:#x}): pointer {:#x} already visited with different type ({}).\n", name, data.address, ptr, it->second.location);
-				print_raw_data(data.address, abi.pointer);
-			}
-			co_return;
-		}
-		it = visited_pointers.emplace_hint(it, ptr, pointer_details{true, actual_type, name});
-		MemoryBuffer item_data(ptr, type_info.size);
-		if (auto err = co_await process.read(item_data)) {
-			it->second.valid = false;
-			std::cout << std::format("{} ({:#x}): invalid pointer {:#x} ({})\n", name, data.address, ptr, err.message());
-			print_raw_data(data.address, abi.pointer);
-			co_return;
-		}
-		if (downcast_type)
-			co_await check_value(std::format("(*{})", name), item_data, *downcast_type);
-		else
-			co_await item_type.visit([
-				this,
-				name = std::format("(*{})", name),
-				data = item_data.view()
-			](const auto &type){
-				return check_value(name, data, type);
-			});
+			report(path, pointer_address, std::format("invalid pointer {:#x} unaligned (required {})", ptr, type_info.align), &abi.pointer);
+			return;
+		}
+		auto location = make_shared_path(path);
+		if (current_record) {
+			auto key = type_key(downcast_type ? downcast_type : compound);
+			if (key.empty())
+				current_record->clean = false; // this child cannot be replayed
+			else
+				current_record->children.push_back({ptr, pointer_address, std::string(key), location});
+		}
+		if (mark_visited(path, pointer_address, ptr, actual_type, location))
+			push_pointee(std::move(location), pointer_address, ptr, type_info.size, &item_type, downcast_type);
+	}
+
+	/**
+	 * Adds \p ptr to the visited pointers, or reports a conflict if it
+	 * was already visited.
+	 *
+	 * \returns true if the pointed object needs to be checked
+	 */
+	bool mark_visited(const ValuePath &path, uintptr_t pointer_address, uintptr_t ptr,
+	                  const AbstractType *type, const std::shared_ptr<const ValuePathRoot> &location)
+	{
+		auto &shard = visited_shard_for(ptr);
+		std::unique_lock lock(shard.mutex);
+		auto [it, inserted] = shard.pointers.try_emplace(ptr, pointer_details{true, type, location});
+		if (inserted)
+			return true;
+		auto details = it->second;
+		lock.unlock();
+		if (!details.valid)
+			report(path, pointer_address, std::format("invalid pointer {:#x} (first visited: {})", ptr, to_string(*details.location)), &abi.pointer);
+		else if (details.type != type)
+			report(path, pointer_address, std::format("pointer {:#x} already visited with different type ({}).", ptr, to_string(*details.location)), &abi.pointer);
+		return false;
+	}
+
+	/**
+	 * Queues the check of the object at \p ptr. Its type is \p downcast_type
+	 * if not null, or \p item_type.
+	 */
+	void push_pointee(std::shared_ptr<const ValuePathRoot> location, uintptr_t pointer_address, uintptr_t ptr, std::size_t size,
+	                  const AnyType *item_type, const Compound *downcast_type)
+	{
+		pool.push([this, location = std::move(location), pointer_address, ptr, size, item_type, downcast_type]() {
+			auto check = [&, this]() {
+				ValuePath path = {nullptr, {}, location};
+				MemoryBuffer item_data(ptr, size);
+				if (auto err = process.read_sync(item_data)) {
+					{
+						auto &shard = visited_shard_for(ptr);
+						std::lock_guard lock(shard.mutex);
+						shard.pointers.at(ptr).valid = false;
+					}
+					report(path, pointer_address, std::format("invalid pointer {:#x} ({})", ptr, err.message()), &abi.pointer);
+					return;
+				}
+				ValuePath item_path = {&path, {ValuePathSegment::Deref, {}, 0}, nullptr};
+				if (downcast_type)
+					check_value(item_path, item_data, *downcast_type);
+				else
+					item_type->visit([&, this](const auto &type) {
+						check_value(item_path, item_data, type);
+					});
+			};
+			auto key = type_key(downcast_type ? downcast_type : item_type->get_if<Compound>());
+			if (!incremental || key.empty())
+				return check();
+			check_recorded({ptr, std::string(key)}, downcast_type ? signature(*downcast_type) : signature(*item_type), check);
+		});
 	}
 
-	cppcoro::task<> check_value(std::string name, MemoryView data, const StaticArray &array)
+	void check_value(const ValuePath &path, MemoryView data, const StaticArray &array)
 	{
 		assert(array.type_params.size() == 1);
 		const auto &item_type = array.itemType();
 		auto type_info = layout.getTypeInfo(item_type);
 		if (type_info.size == 0) // skip missing types
-			co_return;
+			return;
 		assert(array.extent != StaticArray::NoExtent);
-		std::vector<cppcoro::task<>> tasks;
-		for (std::size_t i = 0; i < array.extent; ++i) {
-			item_type.visit([&, this](const auto &type){
-				tasks.push_back(check_value(
-						std::format("{}[{}]", name, i),
-						data.subview(i * type_info.size, type_info.size),
-						type));
-			});
+		item_type.visit([&, this](const auto &type){
+			for (std::size_t i = 0; i < array.extent; ++i)
+				check_value(path.index(i), data.subview(i * type_info.size, type_info.size), type);
+		});
+	}
+
+	/**
+	 * Indices of the items to check in a container: all of them, or
+	 * \ref sample_size random ones.
+	 */
+	struct item_sample
+	{
+		std::size_t size;	///< container size
+		bool all;		///< check every item, \ref indices is empty
+		std::vector<std::size_t> indices;	///< sorted sampled indices
+
+		bool contains(std::size_t i) const {
+			return all ? i < size : std::ranges::binary_search(indices, i);
+		}
+
+		template <typename F>
+		void for_each(F &&f) const {
+			if (all)
+				for (std::size_t i = 0; i < size; ++i)
+					f(i);
+			else
+				for (auto i: indices)
+					f(i);
 		}
-		co_await cppcoro::when_all(std::move(tasks));
+	};
+
+	/**
+	 * \returns the items to check in a container of size \p size.
+	 */
+	item_sample sample_items(std::size_t size)
+	{
+		if (sample_size == 0 || size <= sample_size)
+			return {size, true, {}};
+		// Floyd's algorithm: sample_size distinct indices without
+		// listing all of them
+		static thread_local std::mt19937_64 rng(std::random_device{}());
+		std::set<std::size_t> sampled;
+		for (std::size_t j = size - sample_size; j < size; ++j) {
+			auto t = std::uniform_int_distribution<std::size_t>(0, j)(rng);
+			if (!sampled.insert(t).second)
+				sampled.insert(j);
+		}
+		return {size, false, {sampled.begin(), sampled.end()}};
+	}
+
+	/**
+	 * Contiguous items in a container.
+	 */
+	struct item_run
+	{
+		uintptr_t address;
+		std::size_t first_index;
+		std::size_t count;
+	};
+
+	/**
+	 * Groups the items from \p sample in runs of contiguous items.
+	 */
+	template <typename AddressOf>
+	static std::vector<item_run> make_runs(const item_sample &sample, std::size_t item_size, AddressOf &&address_of)
+	{
+		std::vector<item_run> runs;
+		sample.for_each([&](std::size_t i) {
+			auto address = address_of(i);
+			if (!runs.empty() && runs.back().first_index + runs.back().count == i
+					&& runs.back().address + runs.back().count * item_size == address)
+				++runs.back().count;
+			else
+				runs.push_back({address, i, 1});
+		});
+		return runs;
 	}
 
-	cppcoro::task<> check_value(std::string name, MemoryView data, const StdContainer &container)
+	/**
+	 * Reads all \p runs with a single readv and checks their items.
+	 */
+	std::error_code check_items(const ValuePath &path, const AnyType &item_type, std::size_t item_size, std::span<const item_run> runs)
+	{
+		std::size_t total = 0;
+		for (const auto &run: runs)
+			total += run.count;
+		std::vector<uint8_t> buffer(total * item_size);
+		std::vector<MemoryBufferRef> buffers;
+		std::size_t offset = 0;
+		for (const auto &run: runs) {
+			buffers.push_back({run.address, {buffer.data() + offset, run.count * item_size}});
+			offset += run.count * item_size;
+		}
+		if (auto err = process.readv_sync(buffers))
+			return err;
+		item_type.visit([&, this](const auto &type) {
+			for (std::size_t i = 0; i < runs.size(); ++i)
+				for (std::size_t j = 0; j < runs[i].count; ++j)
+					check_value(path.index(runs[i].first_index + j),
+							MemoryView{runs[i].address + j * item_size, buffers[i].data.subspan(j * item_size, item_size)},
+							type);
+		});
+		return {};
+	}
+
+	void check_value(const ValuePath &path, MemoryView data, const StdContainer &container)
 	{
 		const AnyType *item_type = nullptr;
 		TypeInfo type_info;
-		if (container.type_params.size() == 1) {
+		if (container.type_params.size() >= 1) {
 			item_type = &container.itemType();
 			type_info = layout.getTypeInfo(*item_type);
 		}
-		const auto &container_info = abi.container_type(container.container_type);
+		if (!item_type || type_info.size == 0) // skip missing types
+			return;
+		const auto &container_info = layout.type_info.at(&container);
 		switch (container.container_type) {
 		case StdContainer::StdVector: {
-			assert(item_type);
-			if (type_info.size == 0) // skip missing types
-				co_return;
-			auto vec = co_await abi.read_vector(process, data, type_info);
+			auto vec = abi.decode_vector(data, type_info);
 			if (vec.err) {
-				std::cout << std::format("{} ({:#x}): invalid vector ({})\n", name, data.address,
-						vec.err.message());
-				print_raw_data(data.address, container_info);
-				co_return;
+				report(path, data.address, std::format("invalid vector ({})", vec.err.message()), &container_info);
+				return;
 			}
 			else if (vec.size > MaxVectorSize) {
-				std::cout << std::format("{} ({:#x}): vector too big (size = {})\n", name, data.address, vec.size);
-				print_raw_data(data.address, container_info);
-				co_return;
+				report(path, data.address, std::format("vector too big (size = {})", vec.size), &container_info);
+				return;
 			}
-			else if (vec.size == 0)
-				co_return;
-			MemoryBuffer item_data(vec.data, vec.size * type_info.size);
-			auto err = co_await process.read(item_data);
-			if (err) {
-				std::cout << std::format("{} ({:#x}): invalid vector data {:#x}@{} ({})\n", name, data.address, vec.data, vec.size, err.message());
-				print_raw_data(data.address, container_info);
-				co_return;
+			auto runs = make_runs(sample_items(vec.size), type_info.size, [&](std::size_t i) {
+				return vec.data + i * type_info.size;
+			});
+			if (auto err = check_items(path, *item_type, type_info.size, runs))
+				report(path, data.address, std::format("invalid vector data {:#x}@{} ({})", vec.data, vec.size, err.message()), &container_info);
+			break;
+		}
+		case StdContainer::StdDeque:
+			if (abi.std_library == ABI::StdLib::MSVC2015)
+				check_deque_msvc(path, data, *item_type, type_info, container_info);
+			else if (container_info.size == 10 * abi.pointer.size)
+				check_deque_gcc(path, data, *item_type, type_info, container_info);
+			else
+				report(path, data.address, std::format("unexpected deque size {} (expected {})",
+						container_info.size, 10 * abi.pointer.size), &container_info);
+			break;
+		case StdContainer::StdSet:
+		case StdContainer::StdMap: {
+			const AnyType *mapped_type = nullptr;
+			if (container.container_type == StdContainer::StdMap) {
+				if (container.type_params.size() != 2)
+					return;
+				mapped_type = &container.type_params[1];
+				if (layout.getTypeInfo(*mapped_type).size == 0)
+					return;
 			}
-			std::vector<cppcoro::task<>> tasks;
-			for (std::size_t i = 0; i < vec.size; ++i) {
-				item_type->visit([&, this](const auto &type){
-					tasks.push_back(check_value(
-							std::format("{}[{}]", name, i),
-							item_data.view(i * type_info.size, type_info.size),
-							type));
-				});
+			if (abi.std_library == ABI::StdLib::MSVC2015)
+				check_tree_msvc(path, data, *item_type, mapped_type, container_info);
+			else
+				check_tree_gcc(path, data, *item_type, mapped_type, container_info);
+			break;
+		}
+		case StdContainer::StdSharedPtr:
+		case StdContainer::StdWeakPtr:
+			check_shared_ptr(path, data, *item_type, container_info,
+					container.container_type == StdContainer::StdWeakPtr);
+			break;
+		case StdContainer::StdOptional: {
+			// struct optional {
+			//     T value;
+			//     bool engaged;
+			// };
+			auto engaged = data.data[type_info.size];
+			if (engaged > 1) {
+				report(path, data.address, std::format("invalid optional (engaged = {})", engaged), &container_info);
+				return;
 			}
-			co_await cppcoro::when_all(std::move(tasks));
+			if (engaged)
+				item_type->visit([&, this](const auto &type) {
+					check_value(path, data.subview(0, type_info.size), type);
+				});
 			break;
 		}
 		default:
-			co_return;
+			return;
+		}
+	}
+
+	void check_deque_gcc(const ValuePath &path, MemoryView data, const AnyType &item_type,
+	                     const TypeInfo &type_info, const TypeInfo &container_info)
+	{
+		// struct iterator {
+		//     T *cur, *first, *last;
+		//     T **node;
+		// };
+		// struct deque {
+		//     T **map;
+		//     size_t map_size;
+		//     iterator start, finish;
+		// };
+		// Blocks hold 512 bytes (at least one item), only the map entries
+		// between start.node and finish.node are used.
+		auto p = abi.pointer.size;
+		auto word = [&](std::size_t i) { return abi.get_pointer(data.subview(i * p)); };
+		struct iterator { uintptr_t cur, first, last, node; };
+		auto map = word(0);
+		auto map_size = word(1);
+		iterator start = {word(2), word(3), word(4), word(5)};
+		iterator finish = {word(6), word(7), word(8), word(9)};
+		if (map == 0 && map_size == 0 && start.node == 0 && finish.node == 0)
+			return; // moved-from deque
+		auto item_size = type_info.size;
+		std::size_t block_items = item_size < 512 ? 512 / item_size : 1;
+		auto valid_iterator = [&](const iterator &it) {
+			return it.node >= map && it.node < map + map_size * p && (it.node - map) % p == 0
+				&& it.last == it.first + block_items * item_size
+				&& it.cur >= it.first && it.cur <= it.last
+				&& (it.cur - it.first) % item_size == 0;
+		};
+		if (map == 0 || map_size > MaxVectorSize
+				|| !valid_iterator(start) || !valid_iterator(finish)
+				|| finish.node < start.node
+				|| (finish.node == start.node && finish.cur < start.cur)) {
+			report(path, data.address, "invalid deque", &container_info);
+			return;
+		}
+		auto block_count = (finish.node - start.node) / p + 1;
+		std::vector<uint8_t> blocks(block_count * p);
+		if (auto err = process.read_sync({start.node, blocks})) {
+			report(path, data.address, std::format("invalid deque map {:#x} ({})", map, err.message()), &container_info);
+			return;
+		}
+		auto block = [&](std::size_t i) { return abi.get_pointer(blocks.data() + i * p); };
+		if (block(0) != start.first || block(block_count - 1) != finish.first) {
+			report(path, data.address, "deque iterators do not match the map", &container_info);
+			return;
+		}
+		auto start_offset = (start.cur - start.first) / item_size;
+		auto size = (block_count - 1) * block_items + (finish.cur - finish.first) / item_size - start_offset;
+		if (size > MaxVectorSize) {
+			report(path, data.address, std::format("deque too big (size = {})", size), &container_info);
+			return;
+		}
+		auto runs = make_runs(sample_items(size), item_size, [&](std::size_t i) {
+			auto pos = start_offset + i;
+			return block(pos / block_items) + (pos % block_items) * item_size;
+		});
+		if (auto err = check_items(path, item_type, item_size, runs))
+			report(path, data.address, std::format("invalid deque data ({})", err.message()), &container_info);
+	}
+
+	void check_deque_msvc(const ValuePath &path, MemoryView data, const AnyType &item_type,
+	                      const TypeInfo &type_info, const TypeInfo &container_info)
+	{
+		// struct deque {
+		//     void *proxy;
+		//     T **map;
+		//     size_t map_size;	// power of 2
+		//     size_t offset;
+		//     size_t size;
+		// };
+		// Item i is in block ((offset + i) / block_items) % map_size.
+		auto p = abi.pointer.size;
+		auto word = [&](std::size_t i) { return abi.get_pointer(data.subview(i * p)); };
+		auto map = word(1);
+		auto map_size = word(2);
+		auto offset = word(3);
+		auto size = word(4);
+		if (size == 0)
+			return;
+		auto item_size = type_info.size;
+		std::size_t block_items = item_size <= 1 ? 16
+			: item_size <= 2 ? 8
+			: item_size <= 4 ? 4
+			: item_size <= 8 ? 2
+			: 1;
+		if (map == 0 || map_size == 0 || (map_size & (map_size - 1)) != 0
+				|| map_size > MaxVectorSize || size > map_size * block_items) {
+			report(path, data.address, std::format("invalid deque (map size = {}, size = {})", map_size, size), &container_info);
+			return;
+		}
+		std::vector<uint8_t> blocks(map_size * p);
+		if (auto err = process.read_sync({map, blocks})) {
+			report(path, data.address, std::format("invalid deque map {:#x} ({})", map, err.message()), &container_info);
+			return;
+		}
+		auto runs = make_runs(sample_items(size), item_size, [&](std::size_t i) {
+			auto pos = offset + i;
+			return abi.get_pointer(blocks.data() + ((pos / block_items) & (map_size - 1)) * p)
+				+ (pos % block_items) * item_size;
+		});
+		if (auto err = check_items(path, item_type, item_size, runs))
+			report(path, data.address, std::format("invalid deque data ({})", err.message()), &container_info);
+	}
+
+	/**
+	 * Node layout of a red-black tree
+	 */
+	struct tree_layout
+	{
+		std::size_t parent, left, right;	///< link offsets
+		std::optional<std::size_t> is_nil;	///< offset of a flag that must be false
+		std::size_t value;	///< value offset
+		uintptr_t nil;		///< value of missing children
+	};
+
+	static constexpr std::size_t align_up(std::size_t offset, std::size_t align)
+	{
+		return (offset + align - 1) / align * align;
+	}
+
+	/**
+	 * Checks a tree level by level: each level is read with a single readv.
+	 * Nodes must link to their parent and the node count must match \p
+	 * count. Values of set (\p mapped_type is null) or map nodes are
+	 * indexed in level order.
+	 */
+	void check_tree(const ValuePath &path, MemoryView data, const TypeInfo &container_info,
+	                const tree_layout &node_layout, uintptr_t root, uintptr_t root_parent, std::size_t count,
+	                const AnyType &key_type, const AnyType *mapped_type)
+	{
+		if (count > MaxVectorSize) {
+			report(path, data.address, std::format("tree too big (size = {})", count), &container_info);
+			return;
+		}
+		auto key_info = layout.getTypeInfo(key_type);
+		TypeInfo mapped_info = {0, 1};
+		if (mapped_type)
+			mapped_info = layout.getTypeInfo(*mapped_type);
+		auto mapped_offset = align_up(key_info.size, mapped_info.align);
+		auto value_offset = align_up(node_layout.value, std::max(key_info.align, mapped_info.align));
+		auto node_size = value_offset + mapped_offset + mapped_info.size;
+		auto sampled = sample_items(count);
+		std::vector<std::pair<uintptr_t, uintptr_t>> level = {{root, root_parent}}, next; // node and parent
+		std::vector<uint8_t> buffer;
+		std::vector<MemoryBufferRef> buffers;
+		std::size_t visited = 0;
+		while (!level.empty()) {
+			if (visited + level.size() > count) {
+				report(path, data.address, std::format("more than {} nodes in tree", count), &container_info);
+				return;
+			}
+			buffer.resize(level.size() * node_size);
+			buffers.clear();
+			for (std::size_t i = 0; i < level.size(); ++i)
+				buffers.push_back({level[i].first, {buffer.data() + i * node_size, node_size}});
+			if (auto err = process.readv_sync(buffers)) {
+				report(path, data.address, std::format("invalid tree node ({})", err.message()), &container_info);
+				return;
+			}
+			next.clear();
+			for (std::size_t i = 0; i < level.size(); ++i) {
+				MemoryView node = {level[i].first, buffers[i].data};
+				if (auto parent = abi.get_pointer(node.subview(node_layout.parent)); parent != level[i].second) {
+					report(path, data.address, std::format("tree node {:#x} has parent {:#x} instead of {:#x}",
+							node.address, parent, level[i].second), &container_info);
+					return;
+				}
+				if (node_layout.is_nil && node.data[*node_layout.is_nil] != 0) {
+					report(path, data.address, std::format("unexpected nil tree node {:#x}", node.address), &container_info);
+					return;
+				}
+				for (auto offset: {node_layout.left, node_layout.right})
+					if (auto child = abi.get_pointer(node.subview(offset)); child != node_layout.nil)
+						next.emplace_back(child, node.address);
+				auto index = visited + i;
+				if (!sampled.contains(index))
+					continue;
+				auto value = node.subview(value_offset);
+				auto item_path = path.index(index);
+				if (!mapped_type)
+					key_type.visit([&, this](const auto &type) {
+						check_value(item_path, value.subview(0, key_info.size), type);
+					});
+				else {
+					key_type.visit([&, this](const auto &type) {
+						check_value(item_path.member("first"), value.subview(0, key_info.size), type);
+					});
+					mapped_type->visit([&, this](const auto &type) {
+						check_value(item_path.member("second"), value.subview(mapped_offset, mapped_info.size), type);
+					});
+				}
+			}
+			visited += level.size();
+			std::swap(level, next);
+		}
+		if (visited != count)
+			report(path, data.address, std::format("tree has {} nodes but its size is {}", visited, count), &container_info);
+	}
+
+	void check_tree_gcc(const ValuePath &path, MemoryView data, const AnyType &key_type, const AnyType *mapped_type,
+	                    const TypeInfo &container_info)
+	{
+		// struct node_base {
+		//     int color;
+		//     node_base *parent, *left, *right;
+		// };
+		// struct tree {
+		//     Compare compare;
+		//     node_base header; // parent is root, left/right are leftmost/rightmost
+		//     size_t count;
+		// };
+		// Nodes are a node_base followed by the value.
+		auto p = abi.pointer.size;
+		auto word = [&](std::size_t i) { return abi.get_pointer(data.subview(i * p)); };
+		auto header = data.address + p;
+		auto root = word(2);
+		auto count = word(5);
+		if (root == 0) {
+			if (count != 0 || word(3) != header || word(4) != header)
+				report(path, data.address, std::format("invalid empty tree (size = {})", count), &container_info);
+			return;
+		}
+		check_tree(path, data, container_info, {p, 2*p, 3*p, std::nullopt, 4*p, 0},
+				root, header, count, key_type, mapped_type);
+	}
+
+	void check_tree_msvc(const ValuePath &path, MemoryView data, const AnyType &key_type, const AnyType *mapped_type,
+	                     const TypeInfo &container_info)
+	{
+		// struct node {
+		//     node *left, *parent, *right;
+		//     char color, is_nil;
+		//     T value;
+		// };
+		// struct tree {
+		//     node *head; // parent is root, nil children point to head
+		//     size_t size;
+		// };
+		auto p = abi.pointer.size;
+		auto head = abi.get_pointer(data);
+		auto count = abi.get_pointer(data.subview(p));
+		std::array<uint8_t, 3*8+2> head_data;
+		if (auto err = process.read_sync({head, {head_data.data(), 3*p+2}})) {
+			report(path, data.address, std::format("invalid tree head {:#x} ({})", head, err.message()), &container_info);
+			return;
+		}
+		if (head_data[3*p+1] != 1) {
+			report(path, data.address, std::format("invalid tree head {:#x} (not nil)", head), &container_info);
+			return;
+		}
+		auto root = abi.get_pointer(head_data.data() + p);
+		if (root == head) {
+			if (count != 0)
+				report(path, data.address, std::format("invalid empty tree (size = {})", count), &container_info);
+			return;
+		}
+		check_tree(path, data, container_info, {p, 0, 2*p, 3*p+1, 3*p+2, head},
+				root, head, count, key_type, mapped_type);
+	}
+
+	void check_shared_ptr(const ValuePath &path, MemoryView data, const AnyType &item_type,
+	                      const TypeInfo &container_info, bool weak)
+	{
+		// struct shared_ptr {
+		//     T *ptr;
+		//     control_block *control;
+		// };
+		// struct control_block {
+		//     void *vtable;
+		//     int32_t use_count, weak_count; // weak_count is +1 while use_count > 0
+		// };
+		auto p = abi.pointer.size;
+		auto ptr = abi.get_pointer(data);
+		auto control = abi.get_pointer(data.subview(p));
+		if (control == 0)
+			return;
+		std::array<int32_t, 2> counts;
+		if (auto err = process.read_sync(control + p, counts)) {
+			report(path, data.address, std::format("invalid control block {:#x} ({})", control, err.message()), &container_info);
+			return;
 		}
+		auto [use_count, weak_count] = counts;
+		if (use_count < 0 || weak_count <= 0 || (!weak && use_count == 0)) {
+			report(path, data.address, std::format("invalid reference counts (use = {}, weak = {})", use_count, weak_count), &container_info);
+			return;
+		}
+		// the object of an expired weak_ptr is destroyed
+		if (ptr != 0 && use_count > 0 && layout.getTypeInfo(item_type).size != 0)
+			check_pointer(path, data.address, ptr, item_type);
 	}
 
-	cppcoro::task<> check_value(std::string name, MemoryView data, const PrimitiveType &type)
+	void check_value(const ValuePath &path, MemoryView data, const PrimitiveType &type)
 	{
 		auto type_info = abi.primitive_type(type.type);
 		switch (type.type) {
 		case PrimitiveType::StdString: {
-			auto res = co_await abi.read_string(process, data);
+			ABI::string_result res;
+			process.sync([&, this]() -> cppcoro::task<> {
+				res = co_await abi.read_string(process, data);
+			}());
 			if (res.err) {
-				std::cout << std::format("{} ({:#x}): invalid string ({})\n", name, data.address,
-						res.err.message());
-				print_raw_data(data.address, type_info);
-				co_return;
+				report(path, data.address, std::format("invalid string ({})", res.err.message()), &type_info);
+				return;
 			}
 			break;
 		}
@@ -340,6 +1444,11 @@ static constexpr const char *usage = "{} [options...] df_structures pid\n"
 	" -t, --type type   Process type (native or wine)\n"
 	" -c, --cache       Use cache\n"
 	" -v, --vectorize   Use vectorizer\n"
+	" -j, --jobs n      Number of checking threads (default: number of cores,\n"
+	"                   forced to 1 with --cache or --vectorize)\n"
+	" -s, --state file  Load and save the state for incremental checks: objects\n"
+	"                   are skipped if their memory and type did not change\n"
+	" -k, --sample k    Check only k random items in each container\n"
 	" --no-vtable-errors Hide vtable errors\n"
 	" -h, --help        Print this help message\n";
 
@@ -351,15 +1460,23 @@ int main(int argc, char *argv[]) try
 	bool use_cache = false;
 	bool use_vectorizer = false;
 	int no_vtable_errors = false;
+	std::size_t jobs = std::max(1u, std::thread::hardware_concurrency());
+	fs::path state_path;
+	std::size_t sample_size = 0;
 	static option options[] = {
 		{"type", required_argument, nullptr, 't'},
+		{"cache", no_argument, nullptr, 'c'},
+		{"vectorize", no_argument, nullptr, 'v'},
+		{"jobs", required_argument, nullptr, 'j'},
+		{"state", required_argument, nullptr, 's'},
+		{"sample", required_argument, nullptr, 'k'},
 		{"no-vtable-errors", no_argument, &no_vtable_errors, 1},
 		{"help", no_argument, nullptr, 'h'},
 		{nullptr, 0, nullptr, 0}
 	};
 	{
 		int opt;
-		while ((opt = getopt_long(argc, argv, ":t:cv", options, nullptr)) != -1) {
+		while ((opt = getopt_long(argc, argv, ":t:cvj:s:k:", options, nullptr)) != -1) {
 			switch (opt) {
 			case 0:
 				break;
@@ -372,6 +1489,27 @@ int main(int argc, char *argv[]) try
 			case 'v': // vectorize
 				use_vectorizer = true;
 				break;
+			case 'j': { // jobs
+				std::string_view arg = optarg;
+				auto res = std::from_chars(arg.data(), arg.data()+arg.size(), jobs);
+				if (res.ec != std::errc{} || res.ptr != arg.data()+arg.size() || jobs == 0) {
+					std::cerr << "Invalid job count\n";
+					return EXIT_FAILURE;
+				}
+				break;
+			}
+			case 's': // state
+				state_path = optarg;
+				break;
+			case 'k': { // sample
+				std::string_view arg = optarg;
+				auto res = std::from_chars(arg.data(), arg.data()+arg.size(), sample_size);
+				if (res.ec != std::errc{} || res.ptr != arg.data()+arg.size() || sample_size == 0) {
+					std::cerr << "Invalid sample size\n";
+					return EXIT_FAILURE;
+				}
+				break;
+			}
 			case '?': // invalid option
 				std::cerr << "Invalid option\n";
 				std::cerr << std::format(usage, argv[0]);
@@ -386,6 +1524,11 @@ int main(int argc, char *argv[]) try
 			}
 		}
 	}
+	if (sample_size != 0 && !state_path.empty()) {
+		// skipped objects would only have checked the sampled items
+		std::cerr << "--sample cannot be used with --state\n";
+		return EXIT_FAILURE;
+	}
 	if (argc - optind < 2) {
 		std::cerr << "This command must have at least two parameters\n";
 		std::cerr << std::format(usage, argv[0]);
@@ -425,6 +1568,9 @@ int main(int argc, char *argv[]) try
 		return EXIT_FAILURE;
 	}
 
+	// Caching wrappers are not thread-safe
+	if (use_vectorizer || use_cache)
+		jobs = 1;
 	if (use_vectorizer) {
 		auto tmp = std::move(process);
 		process = std::make_unique<ProcessVectorizer>(std::move(tmp), 48*1024*1024);
@@ -433,6 +1579,10 @@ int main(int argc, char *argv[]) try
 		auto tmp = std::move(process);
 		process = std::make_unique<ProcessCache>(std::move(tmp));
 	}
+	if (!state_path.empty()) {
+		auto tmp = std::move(process);
+		process = std::make_unique<RecordingProcess>(std::move(tmp));
+	}
 
 	auto version = structures.versionById(process->id());
 	if (!version) {
@@ -447,13 +1597,38 @@ int main(int argc, char *argv[]) try
 	}
 	std::cerr << std::format("Found version {}\n", version->version_name);
 
-        ObjectChecker checker(structures, *version, *process);
+	WorkStealingPool pool(jobs);
+	ObjectChecker checker(structures, *version, *process, pool);
 	checker.show_vtable_errors = !no_vtable_errors;
+	checker.sample_size = sample_size;
+
+	checker.incremental = !state_path.empty();
+	std::unordered_map<uint64_t, uint64_t> checksums;
+	if (checker.incremental && fs::exists(state_path)) try {
+		CheckState previous;
+		previous.load(state_path);
+		if (!std::ranges::equal(previous.id, process->id()) || previous.base_offset != process->base_offset())
+			throw std::runtime_error("it was saved for another process");
+		std::vector<uint64_t> pages;
+		for (const auto &[page, checksum]: previous.page_checksums)
+			pages.push_back(page);
+		std::ranges::sort(pages);
+		checksums = page_checksums(*process, pages);
+		for (const auto &[page, checksum]: previous.page_checksums)
+			if (auto it = checksums.find(page); it != checksums.end() && it->second == checksum)
+				checker.unchanged_pages.insert(page);
+		checker.previous_objects = std::move(previous.objects);
+		std::cerr << std::format("Loaded state: {} of {} pages unchanged\n",
+				checker.unchanged_pages.size(), previous.page_checksums.size());
+	}
+	catch (std::exception &e) {
+		std::cerr << std::format("Ignoring state file {}: {}\n", state_path.string(), e.what());
+	}
 
 	if (argc - optind >= 3) for (int i = optind+2; i < argc; ++i) {
 		auto ptr = Pointer::fromGlobal(structures, *version, checker.layout, parse_path(argv[i]), process.get());
 		ptr.type.visit([&checker, name = std::string(argv[i]), address = ptr.address](const auto &type) {
-			checker.process.sync(checker.check_object(name, address, type));
+			checker.push_object(name, address, type);
 		});
 	}
 	else for (const auto &[name, type]: structures.allGlobalObjects()) {
@@ -464,9 +1639,32 @@ int main(int argc, char *argv[]) try
 		}
 		auto address = it->second + process->base_offset();
 		type.visit([&checker, name = name, address](const auto &type) {
-			checker.process.sync(checker.check_object(name, address, type));
+			checker.push_object(name, address, type);
 		});
 	}
+	pool.run();
+
+	if (checker.incremental) {
+		CheckState state;
+		state.id.assign(process->id().begin(), process->id().end());
+		state.base_offset = process->base_offset();
+		std::vector<uint64_t> missing;
+		for (const auto &[key, record]: checker.objects)
+			for (auto page: record.pages) {
+				if (auto it = checksums.find(page); it != checksums.end())
+					state.page_checksums.emplace(page, it->second);
+				else
+					missing.push_back(page);
+			}
+		std::ranges::sort(missing);
+		auto [first, last] = std::ranges::unique(missing);
+		missing.erase(first, last);
+		state.page_checksums.merge(page_checksums(*process, missing));
+		state.objects = std::move(checker.objects);
+		state.save(state_path);
+		std::cerr << std::format("Skipped {} unchanged objects, saved {} objects\n",
+				checker.skipped_objects.load(), state.objects.size());
+	}
 
 	return 0;
 }
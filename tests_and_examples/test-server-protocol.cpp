@@ -0,0 +1,183 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <protocol.h>
+
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+
+using namespace dfs::server;
+
+static void check(bool condition, std::string_view what)
+{
+	if (!condition)
+		throw std::runtime_error(std::format("check failed: {}", what));
+}
+
+template <typename Exception, typename F>
+static void check_throws(F &&f, std::string_view what)
+{
+	try {
+		f();
+	}
+	catch (Exception &) {
+		return;
+	}
+	throw std::runtime_error(std::format("no exception: {}", what));
+}
+
+static void test_request()
+{
+	Request request = {42, "world.units.active", {"id", "name.first_name"}};
+	std::vector<uint8_t> buffer;
+	encode(request, buffer);
+
+	// Incomplete frames are not decoded
+	Request out;
+	for (std::size_t len = 0; len < buffer.size(); ++len)
+		check(decode(std::span(buffer).first(len), out) == 0, "incomplete request");
+
+	check(decode(buffer, out) == buffer.size(), "request frame size");
+	check(out.id == request.id, "request id");
+	check(out.path == request.path, "request path");
+	check(out.fields == request.fields, "request fields");
+}
+
+static void test_response()
+{
+	Response response = {7, Status::ReadError, std::string(100000, 'x'), {4, 2}, {0x1000, 0x2000}, {}};
+	response.data.resize(response.addresses.size() * response.row_size());
+	for (std::size_t i = 0; i < response.data.size(); ++i)
+		response.data[i] = i;
+	std::vector<uint8_t> buffer;
+	encode(response, buffer);
+
+	Response out;
+	check(decode(buffer, out) == buffer.size(), "response frame size");
+	check(out.id == response.id, "response id");
+	check(out.status == response.status, "response status");
+	check(out.message == response.message, "long messages are not truncated");
+	check(out.field_sizes == response.field_sizes, "response field sizes");
+	check(out.addresses == response.addresses, "response addresses");
+	check(out.data == response.data, "response data");
+}
+
+static void test_several_frames()
+{
+	std::vector<uint8_t> buffer;
+	encode(Request{1, "a", {}}, buffer);
+	encode(Request{2, "b", {}}, buffer);
+	Request out;
+	auto first = decode(buffer, out);
+	check(first != 0 && out.id == 1, "first request");
+	auto second = decode(std::span(buffer).subspan(first), out);
+	check(second != 0 && out.id == 2, "second request");
+	check(first + second == buffer.size(), "frame sizes");
+}
+
+static void test_oversize_request()
+{
+	std::vector<uint8_t> buffer = {1, 2, 3};
+	check_throws<std::length_error>([&]() {
+		encode(Request{1, std::string(MaxRequestSize, 'x'), {}}, buffer);
+	}, "request bigger than MaxRequestSize");
+	check(buffer == std::vector<uint8_t>{1, 2, 3}, "output unchanged after a failed encode");
+
+	check_throws<std::length_error>([&]() {
+		encode(Request{1, "a", std::vector<std::string>(70000)}, buffer);
+	}, "too many fields");
+	check(buffer == std::vector<uint8_t>{1, 2, 3}, "output unchanged after a failed encode");
+}
+
+static void set_frame_size(std::vector<uint8_t> &buffer, uint32_t size)
+{
+	std::memcpy(buffer.data(), &size, sizeof(size));
+}
+
+static void test_malformed_request()
+{
+	Request out;
+	std::vector<uint8_t> valid;
+	encode(Request{1, "world", {"a"}}, valid);
+
+	// Frame size over the limit
+	auto buffer = valid;
+	set_frame_size(buffer, MaxRequestSize + 1);
+	check_throws<std::invalid_argument>([&]() { decode(buffer, out); }, "frame is too big");
+
+	// Trailing data
+	buffer = valid;
+	buffer.push_back(0);
+	set_frame_size(buffer, valid.size() - sizeof(uint32_t) + 1);
+	check_throws<std::invalid_argument>([&]() { decode(buffer, out); }, "trailing data");
+
+	// String longer than the frame
+	buffer = valid;
+	buffer.resize(buffer.size() - 1);
+	set_frame_size(buffer, valid.size() - sizeof(uint32_t) - 1);
+	check_throws<std::invalid_argument>([&]() { decode(buffer, out); }, "truncated string");
+}
+
+static void test_malformed_response()
+{
+	Response out;
+	std::vector<uint8_t> buffer;
+	encode(Response{1, Status::Ok, "", {4}, {0x1000}, {1, 2, 3, 4}}, buffer);
+	buffer.resize(buffer.size() - 1);
+	set_frame_size(buffer, buffer.size() - sizeof(uint32_t));
+	check_throws<std::invalid_argument>([&]() { decode(buffer, out); }, "missing row data");
+
+	// Counts bigger than the frame are rejected before allocating
+	// frame size, id, status and empty message
+	constexpr std::size_t field_count_offset = 4*sizeof(uint32_t);
+	auto valid = buffer;
+	valid.clear();
+	encode(Response{1, Status::Ok, "", {4}, {0x1000}, {1, 2, 3, 4}}, valid);
+	buffer = valid;
+	uint32_t count = std::numeric_limits<uint32_t>::max();
+	std::memcpy(buffer.data() + field_count_offset, &count, sizeof(count));
+	check_throws<std::invalid_argument>([&]() { decode(buffer, out); }, "field count");
+	buffer = valid;
+	std::memcpy(buffer.data() + field_count_offset + 2*sizeof(uint32_t), &count, sizeof(count));
+	check_throws<std::invalid_argument>([&]() { decode(buffer, out); }, "address count");
+
+	// Row data bigger than the frame
+	buffer.clear();
+	encode(Response{1, Status::Ok, "", {0x80000000u, 0x80000000u}, std::vector<uint64_t>(4), {}}, buffer);
+	check_throws<std::invalid_argument>([&]() { decode(buffer, out); }, "row data size");
+}
+
+int main()
+{
+	try {
+		test_request();
+		test_response();
+		test_several_frames();
+		test_oversize_request();
+		test_malformed_request();
+		test_malformed_response();
+	}
+	catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return -1;
+	}
+	return 0;
+}
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include "FakeProcess.h"
+
+#include <executor.h>
+
+#include <dfs/Structures.h>
+
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+
+namespace fs = std::filesystem;
+
+using namespace dfs;
+using namespace dfs::server;
+
+static constexpr const char *structures_xml = R"(<data-definition>
+	<struct-type type-name='test_item'>
+		<int32_t name='a'/>
+		<int16_t name='b'/>
+	</struct-type>
+	<struct-type type-name='test_world'>
+		<stl-vector name='items' pointer-type='test_item'/>
+		<stl-vector name='broken' pointer-type='test_item'/>
+		<int32_t name='counter'/>
+	</struct-type>
+	<global-object name='world' type-name='test_world'/>
+</data-definition>
+)";
+
+static constexpr const char *symbols_xml = R"(<data-definition>
+	<symbol-table name='v0.50.00 linux64 test'>
+		<binary-timestamp value='16909060'/>
+		<global-address name='world' value='4096'/>
+	</symbol-table>
+</data-definition>
+)";
+
+static void check(bool condition, std::string_view what)
+{
+	if (!condition)
+		throw std::runtime_error(std::format("check failed: {}", what));
+}
+
+// std::vector<T *> for GCC_CXX11_64
+static void write_vector(FakeProcess &process, uintptr_t address, uintptr_t data, std::size_t size)
+{
+	process.write<uint64_t>(address, data);
+	process.write<uint64_t>(address + 8, data + size * 8);
+	process.write<uint64_t>(address + 16, data + size * 8);
+}
+
+int main()
+{
+	auto dir = fs::temp_directory_path() / "dfs-test-server";
+	try {
+		fs::create_directories(dir);
+		std::ofstream(dir / "df.test.xml") << structures_xml;
+		std::ofstream(dir / "symbols.xml") << symbols_xml;
+		Structures structures(dir);
+		fs::remove_all(dir);
+
+		FakeProcess process({1, 2, 3, 4});
+		auto version = structures.versionById(process.id());
+		check(bool(version), "version");
+
+		// world
+		process.map(0x1000, 0x100);
+		write_vector(process, 0x1000, 0x2000, 3);
+		write_vector(process, 0x1018, 0x9000, 1); // unmapped data
+		process.write<int32_t>(0x1030, 12);
+		// world.items, the null pointer is skipped
+		process.map(0x2000, 0x100);
+		process.write<uint64_t>(0x2000, 0x3000);
+		process.write<uint64_t>(0x2008, 0);
+		process.write<uint64_t>(0x2010, 0x3010);
+		process.map(0x3000, 0x100);
+		process.write<int32_t>(0x3000, 1);
+		process.write<int16_t>(0x3004, 2);
+		process.write<int32_t>(0x3010, 3);
+		process.write<int16_t>(0x3014, 4);
+
+		ReaderFactory factory(structures, *version);
+		Executor executor(factory, process);
+		std::vector<Request> requests = {
+			{1, "world.items", {"a", "b"}},
+			{2, "world.counter", {}},
+			{3, "world.broken", {}},
+			{4, "unknown_global", {}},
+			{5, "world.items", {"missing"}},
+		};
+		std::vector<Response> responses(requests.size());
+		executor.execute(requests, responses);
+		check(process.stop_count == 1, "single session for the batch");
+
+		for (std::size_t i = 0; i < requests.size(); ++i)
+			check(responses[i].id == requests[i].id, "response id");
+
+		const auto &items = responses[0];
+		check(items.status == Status::Ok, "items status");
+		check(items.field_sizes == std::vector<uint32_t>{4, 2}, "items field sizes");
+		check(items.addresses == std::vector<uint64_t>{0x3000, 0x3010}, "items addresses");
+		check(items.data == std::vector<uint8_t>{1, 0, 0, 0, 2, 0, 3, 0, 0, 0, 4, 0}, "items data");
+
+		const auto &counter = responses[1];
+		check(counter.status == Status::Ok, "counter status");
+		check(counter.field_sizes == std::vector<uint32_t>{4}, "counter field sizes");
+		check(counter.addresses == std::vector<uint64_t>{0x1030}, "counter address");
+		check(counter.data == std::vector<uint8_t>{12, 0, 0, 0}, "counter data");
+
+		check(responses[2].status == Status::ReadError, "unmapped vector data");
+		check(responses[2].data.empty(), "no data on error");
+		check(responses[3].status == Status::InvalidPath, "unknown global");
+		check(responses[4].status != Status::Ok, "unknown field");
+	}
+	catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		fs::remove_all(dir);
+		return -1;
+	}
+	return 0;
+}
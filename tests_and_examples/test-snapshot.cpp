@@ -0,0 +1,222 @@
+/*
+ * Copyright 2023 Clement Vuchener
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ *
+ */
+
+#include <dfs/Snapshot.h>
+
+#include <cstring>
+#include <format>
+#include <iostream>
+#include <limits>
+#include <sstream>
+
+using namespace dfs::snapshot;
+
+static void check(bool condition, std::string_view what)
+{
+	if (!condition)
+		throw std::runtime_error(std::format("check failed: {}", what));
+}
+
+// Snapshot data with the alignment required by View
+struct Buffer
+{
+	std::vector<uint64_t> storage;
+	std::size_t size;
+
+	Buffer(const std::string &data):
+		storage((data.size() + sizeof(uint64_t) - 1) / sizeof(uint64_t)),
+		size(data.size())
+	{
+		std::memcpy(storage.data(), data.data(), data.size());
+	}
+
+	std::span<uint8_t> bytes() {
+		return {reinterpret_cast<uint8_t *>(storage.data()), size};
+	}
+
+	template <typename T>
+	T &at(std::size_t offset) {
+		return *reinterpret_cast<T *>(bytes().data() + offset);
+	}
+};
+
+static std::string write(const Writer &writer)
+{
+	std::ostringstream out;
+	writer.write(out);
+	return out.str();
+}
+
+static Writer make_writer()
+{
+	Writer writer;
+	auto &units = writer.add_table("units", 3);
+	// units must still be valid after adding another table
+	auto &empty = writer.add_table("empty", 0);
+	Writer::add_column(units, "id", std::vector<int32_t>{10, -20, 30});
+	Writer::add_column(units, "name", std::vector<std::string>{"Urist", "", "Bembul"});
+	Writer::add_column(units, "alive", std::vector<bool>{true, false, true});
+	Writer::add_column(empty, "name", std::vector<std::string>{});
+	return writer;
+}
+
+static void test_round_trip()
+{
+	auto writer = make_writer();
+	check(writer.tables().size() == 2, "writer table count");
+	Buffer buffer(write(writer));
+	View view(buffer.bytes());
+
+	check(view.tables().size() == 2, "table count");
+	auto units = view.table("units");
+	check(units && units->size() == 3, "units table");
+	check(units->columns().size() == 3, "units column count");
+	auto ids = units->column("id")->values<int32_t>();
+	check(std::ranges::equal(ids, std::vector<int32_t>{10, -20, 30}), "id values");
+	auto name = units->column("name");
+	check(name->string(0) == "Urist" && name->string(1) == "" && name->string(2) == "Bembul", "name values");
+	auto alive = units->column("alive")->values<bool>();
+	check(alive[0] && !alive[1] && alive[2], "alive values");
+	check(units->column("missing") == nullptr, "missing column");
+
+	auto empty = view.table("empty");
+	check(empty && empty->size() == 0 && empty->columns().size() == 1, "empty table");
+
+	bool type_error = false;
+	try {
+		units->column("id")->values<int64_t>();
+	}
+	catch (std::invalid_argument &) {
+		type_error = true;
+	}
+	check(type_error, "column type mismatch");
+
+	bool size_error = false;
+	try {
+		Writer::add_column(writer.add_table("wrong", 2), "x", std::vector<int32_t>{1});
+	}
+	catch (std::invalid_argument &) {
+		size_error = true;
+	}
+	check(size_error, "column size mismatch");
+}
+
+struct position
+{
+	int16_t x, y;
+
+	using reader_type = dfs::StructureReader<position, "position",
+		dfs::Field<&position::x, "x">,
+		dfs::Field<&position::y, "y">
+	>;
+};
+
+struct unit
+{
+	int32_t id;
+	std::string name;
+	position pos;
+
+	using reader_type = dfs::StructureReader<unit, "unit",
+		dfs::Field<&unit::id, "id">,
+		dfs::Field<&unit::name, "name">,
+		dfs::Field<&unit::pos, "pos">
+	>;
+};
+
+static void test_pointers()
+{
+	std::vector<std::unique_ptr<unit>> units;
+	units.push_back(std::make_unique<unit>(1, "Urist", position{1, 2}));
+	units.push_back(nullptr);
+	units.push_back(std::make_unique<unit>(3, "Bembul", position{3, 4}));
+	Writer writer;
+	writer.add("units", units);
+	std::vector<std::shared_ptr<unit>> shared = {nullptr};
+	writer.add("shared", shared);
+	Buffer buffer(write(writer));
+	View view(buffer.bytes());
+
+	auto table = view.table("units");
+	check(table && table->size() == 2, "null pointers are skipped");
+	check(std::ranges::equal(table->column("id")->values<int32_t>(), std::vector<int32_t>{1, 3}), "id values");
+	check(table->column("name")->string(1) == "Bembul", "name values");
+	check(std::ranges::equal(table->column("pos.y")->values<int16_t>(), std::vector<int16_t>{2, 4}), "nested values");
+	check(view.table("shared")->size() == 0, "shared pointers");
+}
+
+// Modifies a valid snapshot with f and checks View rejects it
+template <typename F>
+static void check_malformed(F &&f, std::string_view what)
+{
+	Buffer buffer(write(make_writer()));
+	f(buffer);
+	try {
+		View view(buffer.bytes());
+	}
+	catch (std::runtime_error &) {
+		return;
+	}
+	throw std::runtime_error(std::format("malformed snapshot accepted: {}", what));
+}
+
+static void test_malformed()
+{
+	constexpr std::size_t units_entry = sizeof(FileHeader);
+	constexpr std::size_t empty_entry = sizeof(FileHeader) + sizeof(TableEntry);
+	constexpr std::size_t name_column_entry = sizeof(FileHeader) + 2*sizeof(TableEntry) + sizeof(ColumnEntry);
+	check_malformed([](Buffer &b) { b.at<char>(0) = 'X'; }, "magic");
+	check_malformed([](Buffer &b) { b.at<FileHeader>(0).version = FormatVersion + 1; }, "version");
+	check_malformed([](Buffer &b) { b.size = sizeof(FileHeader) - 1; }, "truncated header");
+	check_malformed([](Buffer &b) { b.size -= 1; }, "truncated data");
+	check_malformed([](Buffer &b) { b.at<FileHeader>(0).table_count = std::numeric_limits<uint32_t>::max(); }, "table count");
+	check_malformed([](Buffer &b) {
+		b.at<TableEntry>(empty_entry).row_count = std::numeric_limits<uint64_t>::max();
+	}, "string column row count overflow");
+	check_malformed([](Buffer &b) { b.at<TableEntry>(units_entry).row_count = 4; }, "row count");
+	check_malformed([](Buffer &b) { b.at<TableEntry>(units_entry).columns_offset += 1; }, "misaligned columns");
+	check_malformed([](Buffer &b) {
+		b.at<ColumnEntry>(name_column_entry).type = ColumnType(100);
+	}, "unknown column type");
+	check_malformed([](Buffer &b) {
+		auto &entry = b.at<ColumnEntry>(name_column_entry);
+		entry.data_offset = b.storage.size() * sizeof(uint64_t) + Alignment;
+	}, "column data out of bounds");
+	check_malformed([](Buffer &b) {
+		auto &entry = b.at<ColumnEntry>(name_column_entry);
+		b.at<uint64_t>(entry.data_offset + 2*sizeof(uint64_t)) = 0; // offsets[2] < offsets[1]
+	}, "decreasing string offsets");
+	check_malformed([](Buffer &b) {
+		auto &entry = b.at<ColumnEntry>(name_column_entry);
+		b.at<uint64_t>(entry.data_offset + 3*sizeof(uint64_t)) = 1000;
+	}, "string past the end of the column");
+}
+
+int main()
+{
+	try {
+		test_round_trip();
+		test_pointers();
+		test_malformed();
+	}
+	catch (std::exception &e) {
+		std::cerr << e.what() << std::endl;
+		return -1;
+	}
+	return 0;
+}